@@ -14,8 +14,25 @@ class AppDelegate: UIResponder, UIApplicationDelegate {
 //                options.enableSwizzling = true // Auto breadcrumbs
 //        }
         setInitialViewController()
+        NotificationCenter.default.addObserver(self, selector: #selector(uploadFailed(_:)), name: .uploadFailed, object: nil)
+        UploadQueue.shared.resume()
         return true
     }
+
+    /// Lets the user retry or drop an upload the server refused; the file is kept until then.
+    @objc private func uploadFailed(_ notification: Notification) {
+        guard let item = notification.object as? UploadQueue.Item,
+              let topVC = window?.rootViewController?.topMostViewController(),
+              !(topVC is UIAlertController) else { return }
+        let reason = notification.userInfo?[UploadQueue.failureReasonKey] as? String ?? ""
+        let alert = UIAlertController(title: "Upload Failed",
+                                      message: "The \(item.kind.rawValue) for order \(item.orderId) was not accepted. \(reason)",
+                                      preferredStyle: .alert)
+        alert.addAction(UIAlertAction(title: "Retry", style: .default) { _ in UploadQueue.shared.retry(item.id) })
+        alert.addAction(UIAlertAction(title: "Discard", style: .destructive) { _ in UploadQueue.shared.discard(item.id) })
+        alert.addAction(UIAlertAction(title: "Later", style: .cancel))
+        topVC.present(alert, animated: true)
+    }
     
     private func setInitialViewController2() {
         guard let window = window else { return }
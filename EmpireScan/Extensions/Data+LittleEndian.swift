@@ -0,0 +1,29 @@
+//
+//  Data+LittleEndian.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+
+/// Little-endian field access shared by the archive, mesh and frame log formats.
+/// Reads are unchecked: callers validate `offset` against `count` first.
+extension Data {
+    func uint16(at offset: Int) -> UInt16 {
+        withUnsafeBytes { UInt16(littleEndian: $0.loadUnaligned(fromByteOffset: offset, as: UInt16.self)) }
+    }
+
+    func uint32(at offset: Int) -> UInt32 {
+        withUnsafeBytes { UInt32(littleEndian: $0.loadUnaligned(fromByteOffset: offset, as: UInt32.self)) }
+    }
+
+    func uint64(at offset: Int) -> UInt64 {
+        withUnsafeBytes { UInt64(littleEndian: $0.loadUnaligned(fromByteOffset: offset, as: UInt64.self)) }
+    }
+
+    mutating func appendLittleEndian<T: FixedWidthInteger>(_ value: T) {
+        var value = value.littleEndian
+        Swift.withUnsafeBytes(of: &value) { append(contentsOf: $0) }
+    }
+}
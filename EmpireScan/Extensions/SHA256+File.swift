@@ -0,0 +1,22 @@
+//
+//  SHA256+File.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import CryptoKit
+
+extension SHA256 {
+    /// Lowercase hex digest of the file at `url`, read in 1 MB chunks.
+    static func hexDigest(ofFileAt url: URL) throws -> String {
+        let handle = try FileHandle(forReadingFrom: url)
+        defer { try? handle.close() }
+        var hasher = SHA256()
+        while let chunk = try handle.read(upToCount: 1024 * 1024), !chunk.isEmpty {
+            hasher.update(data: chunk)
+        }
+        return hasher.finalize().map { String(format: "%02x", $0) }.joined()
+    }
+}
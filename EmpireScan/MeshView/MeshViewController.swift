@@ -62,7 +62,10 @@ class MeshViewController: UIViewController, UIGestureRecognizerDelegate {
     var projectionMatrixBeforeUserInteractions: float4x4?
     
     var shareViewController: UIActivityViewController!
-    
+
+    /// Most faces a scan is uploaded with; denser meshes go through `MeshDecimator` first.
+    static let uploadFaceLimit = 400_000
+
     required public init?(coder aDecoder: NSCoder) {
         super.init(coder: aDecoder)
         
@@ -70,7 +73,8 @@ class MeshViewController: UIViewController, UIGestureRecognizerDelegate {
         navigationItem.leftBarButtonItem = backButton
         
         let shareButton = UIBarButtonItem(title: "Save", style: .plain,  target: self, action: #selector(shareMesh(_:)))
-        navigationItem.rightBarButtonItem = shareButton
+        let exportButton = UIBarButtonItem(barButtonSystemItem: .action, target: self, action: #selector(exportMesh(_:)))
+        navigationItem.rightBarButtonItems = [shareButton, exportButton]
         // Custom initialization
         title = "3D Foot Scan"
     }
@@ -225,23 +229,28 @@ class MeshViewController: UIViewController, UIGestureRecognizerDelegate {
     
     // MARK: Mesh file share
     func prepareScreenShot(screenshotPath: URL) {
-        let lastDrawableDisplayed = mtkView.currentDrawable?.texture
-        if let imageRef = lastDrawableDisplayed?.toImage() {
-            let uiImage: UIImage = UIImage.init(cgImage: imageRef)
-            if let data = uiImage.jpegData(compressionQuality: 0.8) {
-                try? data.write(to: screenshotPath)
-            }
+        if let data = screenshotJPEGData() {
+            try? data.write(to: screenshotPath)
         }
     }
+
+    /// JPEG of the last frame shown in the mesh view.
+    func screenshotJPEGData() -> Data? {
+        let lastDrawableDisplayed = mtkView.currentDrawable?.texture
+        guard let imageRef = lastDrawableDisplayed?.toImage() else { return nil }
+        let uiImage: UIImage = UIImage.init(cgImage: imageRef)
+        return uiImage.jpegData(compressionQuality: 0.8)
+    }
     
-    func getMeshExportFormat() -> Int {
+    func getMeshExportFormat() -> MeshExporter.Format {
         switch UserDefaults.standard.integer(forKey: "meshExportFormat") {
-        case 0: return STMeshWriteOptionFileFormat.objFile.rawValue
-        case 1: return STMeshWriteOptionFileFormat.plyFile.rawValue
-        case 2: return STMeshWriteOptionFileFormat.binarySTLFile.rawValue
+        case 0: return .obj
+        case 1: return .ply
+        case 2: return .binarySTL
+        case 3: return .glb
         default:
             NSLog("Unknown meshExportFormat")
-            return STMeshWriteOptionFileFormat.objFileZip.rawValue
+            return .obj
         }
     }
     
@@ -254,69 +263,42 @@ class MeshViewController: UIViewController, UIGestureRecognizerDelegate {
         LoaderManager.shared.show(in: self.view, message: "Saving Scan")
         
         let cacheDirectory = FileManager.default.urls(for: .documentDirectory, in: .userDomainMask).first!
-        let screenshotPath = cacheDirectory.appendingPathComponent("Preview.jpg")
-        
-        // Set file permissions and prepare screenshot
-        try? FileManager.default.setAttributes([.posixPermissions: 0o777], ofItemAtPath: screenshotPath.path)
-        prepareScreenShot(screenshotPath: screenshotPath)
         let timestamp = Int(Date().timeIntervalSince1970)
-        // Prepare file paths
-        let objFileName = "Model_\(timestamp).obj"
-        let stlFileName = "Model_STL_\(timestamp).stl"
-        let objFileURL = cacheDirectory.appendingPathComponent(objFileName)
-        let stlFileURL = cacheDirectory.appendingPathComponent(stlFileName)
-        
-        do {
-            // Save OBJ
-            let objOptions: [String: Any] = [
-                kSTMeshWriteOptionFileFormatKey: STMeshWriteOptionFileFormat.objFile.rawValue,
-                kSTMeshWriteOptionUseXRightYUpConventionKey: true
-            ]
-            try _mesh.write(toFile: objFileURL.path, options: objOptions)
-            print("✅ OBJ file saved")
-
-            // Save STL
-            let stlOptions: [String: Any] = [
-                kSTMeshWriteOptionFileFormatKey: STMeshWriteOptionFileFormat.binarySTLFile.rawValue,
-                kSTMeshWriteOptionUseXRightYUpConventionKey: true
-            ]
-            try _mesh.write(toFile: stlFileURL.path, options: stlOptions)
-            print("✅ STL file saved")
-
-        } catch let error as NSError {
-            let alert = UIAlertController(title: "Mesh cannot be exported.",
-                                          message: "Exporting failed: \(error.localizedDescription).",
-                                          preferredStyle: .alert)
-            alert.addAction(UIAlertAction(title: "OK", style: .default))
-            present(alert, animated: true)
-            return
-        }
-
-        // Check file existence
-        guard FileManager.default.fileExists(atPath: objFileURL.path),
-              FileManager.default.fileExists(atPath: stlFileURL.path) else {
-            print("❌ Exported mesh files are missing")
-            return
-        }
-
-        // Create ZIP
         let zipFileURL = cacheDirectory.appendingPathComponent("Model_\(timestamp).zip")
-        if FileManager.default.fileExists(atPath: zipFileURL.path) {
-            try? FileManager.default.removeItem(at: zipFileURL)
-        }
-        do {
-            guard let archive = Archive(url: zipFileURL, accessMode: .create) else {
-                print("❌ Could not create archive")
-                return
-            }
-            try archive.addEntry(with: objFileName, fileURL: objFileURL)
-            try archive.addEntry(with: stlFileName, fileURL: stlFileURL)
-            try archive.addEntry(with: screenshotPath.lastPathComponent, fileURL: screenshotPath)
-            print("📦 ZIP file created at: \(zipFileURL.path)")
-            uploadMesh(zipFileURL: zipFileURL)
+        let preview = screenshotJPEGData()
+        let source = MeshBuffer(mesh: _mesh)
 
-        } catch {
-            print("❌ Failed to create ZIP file: \(error.localizedDescription)")
+        DispatchQueue.global(qos: .userInitiated).async {
+            do {
+                // Dense scans are uploaded at the level of detail the viewers can draw;
+                // meshes under the limit are kept as they are.
+                let mesh = try MeshDecimator.decimate(source, targetFaces: MeshViewController.uploadFaceLimit)
+                // The mesh is encoded once and streamed straight into the ZIP, so the archive
+                // is the only file written.
+                let archive = try ZipStreamWriter(url: zipFileURL)
+                try MeshExporter.write(mesh, into: archive, entries: [
+                    (name: "Model_\(timestamp).obj", format: .obj),
+                    (name: "Model_STL_\(timestamp).stl", format: .binarySTL)
+                ])
+                if let preview = preview {
+                    // JPEG does not deflate any further, so it is stored.
+                    try archive.addEntry("Preview.jpg", data: preview)
+                }
+                try archive.finish()
+                print("📦 ZIP file created at: \(zipFileURL.path) with \(mesh.faceCount) of \(source.faceCount) faces")
+                DispatchQueue.main.async {
+                    self.uploadMesh(zipFileURL: zipFileURL)
+                }
+            } catch let error as NSError {
+                DispatchQueue.main.async {
+                    LoaderManager.shared.hide()
+                    let alert = UIAlertController(title: "Mesh cannot be exported.",
+                                                  message: "Exporting failed: \(error.localizedDescription).",
+                                                  preferredStyle: .alert)
+                    alert.addAction(UIAlertAction(title: "OK", style: .default))
+                    self.present(alert, animated: true)
+                }
+            }
         }
     }
 
@@ -332,17 +314,8 @@ class MeshViewController: UIViewController, UIGestureRecognizerDelegate {
         // Take a screenshot and save it to disk.
         prepareScreenShot(screenshotPath: screenshotPath)
         
-        let exportExtensions: [Int: String] = [
-            STMeshWriteOptionFileFormat.objFile.rawValue: "obj",
-            STMeshWriteOptionFileFormat.plyFile.rawValue: "ply",
-            STMeshWriteOptionFileFormat.binarySTLFile.rawValue: "stl"
-        ]
-
-        let meshExportFormat: Int = getMeshExportFormat()
-        guard let fileExtension = exportExtensions[meshExportFormat] else {
-            print("❌ Unsupported file format")
-            return
-        }
+        let meshExportFormat = getMeshExportFormat()
+        let fileExtension = meshExportFormat.fileExtension
         
         let timestamp = Int(Date().timeIntervalSince1970)
         let meshFileName = "Model_\(timestamp).\(fileExtension)"
@@ -350,14 +323,8 @@ class MeshViewController: UIViewController, UIGestureRecognizerDelegate {
         
         print("⏳ Saving mesh file: \(meshFileName)")
         
-        // Request a zipped OBJ file, potentially with embedded MTL and texture.
-        let options: [String: Any] = [
-            kSTMeshWriteOptionFileFormatKey: meshExportFormat,
-            kSTMeshWriteOptionUseXRightYUpConventionKey: true
-        ]
-        
         do {
-            try _mesh.write(toFile: meshFileURL.path, options: options)
+            try MeshExporter.write(MeshBuffer(mesh: _mesh), to: [meshExportFormat: meshFileURL])
         } catch let error as NSError {
             let message = "Exporting failed: \(error.localizedDescription)."
             let alert = UIAlertController(title: "Mesh cannot be exported.",
@@ -409,14 +376,14 @@ class MeshViewController: UIViewController, UIGestureRecognizerDelegate {
         }
         print("mesh orderStatus", orderStatus)
         
-        ScansService.shared.uploadScanResult(
+        UploadQueue.shared.enqueueScan(
+            fileURL: zipFileURL,
             orderId: orderId ?? 0,
             description: "",
             footType: footType ?? "",
             scanType: scanType ?? "",
             folderId: folderId,
-            orderStatus: orderStatus ?? "",
-            meshFileURL: zipFileURL
+            orderStatus: orderStatus ?? ""
         ) { result in
             DispatchQueue.main.async {
                 LoaderManager.shared.hide {
@@ -448,6 +415,14 @@ class MeshViewController: UIViewController, UIGestureRecognizerDelegate {
                             }
                         }
 
+                    case .failure(let error as NSError) where error.domain == "UploadQueue" && error.code == UploadQueue.queuedErrorCode:
+                        print("⏳ Upload queued: \(error.localizedDescription)")
+                        self.showToast(message: error.localizedDescription)
+                        DispatchQueue.main.asyncAfter(deadline: .now() + 1.5) {
+                            self.dismiss(animated: true) {
+                                self.delegate?.meshViewDidDismiss()
+                            }
+                        }
                     case .failure(let error):
                         print("❌ Upload failed: \(error.localizedDescription)")
                         self.showToast(message: error.localizedDescription)
@@ -471,6 +446,50 @@ class MeshViewController: UIViewController, UIGestureRecognizerDelegate {
     @objc func shareMesh(_ sender: AnyObject) {
         openShareMeshDialog()
     }
+
+    /// Asks for a format, the saved preference first, and shares the mesh as that file.
+    @objc func exportMesh(_ sender: UIBarButtonItem) {
+        let alert = UIAlertController(title: "Export Scan", message: nil, preferredStyle: .actionSheet)
+        alert.popoverPresentationController?.barButtonItem = sender
+        let preferred = getMeshExportFormat()
+        let formats = [preferred] + MeshExporter.Format.allCases.filter { $0 != preferred }
+        for format in formats {
+            alert.addAction(UIAlertAction(title: format.fileExtension.uppercased(), style: .default) { [weak self] _ in
+                self?.openExportDialog(format: format, sender: sender)
+            })
+        }
+        alert.addAction(UIAlertAction(title: "Cancel", style: .cancel))
+        present(alert, animated: true)
+    }
+
+    @MainActor private func openExportDialog(format: MeshExporter.Format, sender: UIBarButtonItem) {
+        LoaderManager.shared.show(in: self.view, message: "Exporting Scan")
+        let timestamp = Int(Date().timeIntervalSince1970)
+        let fileURL = FileManager.default.temporaryDirectory.appendingPathComponent("Model_\(timestamp).\(format.fileExtension)")
+        let source = MeshBuffer(mesh: _mesh)
+
+        DispatchQueue.global(qos: .userInitiated).async {
+            do {
+                try MeshExporter.write(source, to: [format: fileURL])
+                DispatchQueue.main.async {
+                    LoaderManager.shared.hide {
+                        self.shareViewController = UIActivityViewController(activityItems: [fileURL], applicationActivities: nil)
+                        self.shareViewController.popoverPresentationController?.barButtonItem = sender
+                        self.present(self.shareViewController, animated: true)
+                    }
+                }
+            } catch let error as NSError {
+                DispatchQueue.main.async {
+                    LoaderManager.shared.hide()
+                    let alert = UIAlertController(title: "Mesh cannot be exported.",
+                                                  message: "Exporting failed: \(error.localizedDescription).",
+                                                  preferredStyle: .alert)
+                    alert.addAction(UIAlertAction(title: "OK", style: .default))
+                    self.present(alert, animated: true)
+                }
+            }
+        }
+    }
     
     // MARK: Rendering
     @objc func draw() {
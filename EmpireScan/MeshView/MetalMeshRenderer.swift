@@ -15,26 +15,6 @@ import Structure
 
 typealias Float3 = SIMD3<Float>
 
-extension STMesh {
-  func bbox() -> (Float3, Float3) {
-    var minPoint = Float3(Float.greatestFiniteMagnitude, Float.greatestFiniteMagnitude, Float.greatestFiniteMagnitude)
-    var maxPoint = -Float3(Float.greatestFiniteMagnitude, Float.greatestFiniteMagnitude, Float.greatestFiniteMagnitude)
-
-    let vertices = self.meshVertices(0)!
-    for vItr in 0..<Int(self.number(ofMeshVertices: 0)) {
-
-      minPoint.x = min(vertices[vItr].x, minPoint.x)
-      minPoint.y = min(vertices[vItr].y, minPoint.y)
-      minPoint.z = min(vertices[vItr].z, minPoint.z)
-
-      maxPoint.x = max(vertices[vItr].x, maxPoint.x)
-      maxPoint.y = max(vertices[vItr].y, maxPoint.y)
-      maxPoint.z = max(vertices[vItr].z, maxPoint.z)
-    }
-    return (minPoint, maxPoint)
-  }
-}
-
 class RendererMeshMetal: NSObject, MTKViewDelegate {
   enum Modes {
     case lightedGrey
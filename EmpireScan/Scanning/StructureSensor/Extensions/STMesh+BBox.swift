@@ -3,30 +3,26 @@
  http://structure.io
  */
 import Foundation
+import GLKit
 import Structure
 
 extension STMesh {
-  func bbox() -> (SIMD3<Float>, SIMD3<Float>)? {
-    guard self.meshVertices(0) != nil else {
-      return nil
+  /// Statistics over every partial mesh, read in place and reduced on all cores.
+  func statistics() -> MeshStatistics {
+    let meshCount = Int(self.numberOfMeshes())
+    var parts: [MeshStatistics.Part] = []
+    var vertices: [UnsafeRawPointer?] = []
+    var faces: [UnsafeRawPointer?] = []
+    for meshItr in 0..<meshCount {
+      parts.append(MeshStatistics.Part(vertexCount: Int(self.number(ofMeshVertices: Int32(meshItr))),
+                                       faceCount: Int(self.number(ofMeshFaces: Int32(meshItr)))))
+      vertices.append(UnsafeRawPointer(self.meshVertices(Int32(meshItr))))
+      faces.append(UnsafeRawPointer(self.meshFaces(Int32(meshItr))))
     }
-    var minPoint = vector_float3(self.meshVertices(0)[0])
-    var maxPoint = vector_float3(minPoint)
+    return MeshStatistics.compute(parts, vertices: vertices, vertexStride: MemoryLayout<GLKVector3>.stride, faces: faces)
+  }
 
-    for meshItr in 0..<self.numberOfMeshes() {
-      let numVertices = Int(self.number(ofMeshVertices: meshItr))
-      if let vertices = self.meshVertices(Int32(meshItr)) {
-        for vertexItr in 0..<numVertices {
-          let vertex = vertices[Int(vertexItr)]
-          minPoint.x = min(minPoint.x, vertex.x)
-          minPoint.y = min(minPoint.y, vertex.y)
-          minPoint.z = min(minPoint.z, vertex.z)
-          maxPoint.x = max(maxPoint.x, vertex.x)
-          maxPoint.y = max(maxPoint.y, vertex.y)
-          maxPoint.z = max(maxPoint.z, vertex.z)
-        }
-      }
-    }
-    return (minPoint, maxPoint)
+  func bbox() -> (SIMD3<Float>, SIMD3<Float>)? {
+    statistics().bounds
   }
 }
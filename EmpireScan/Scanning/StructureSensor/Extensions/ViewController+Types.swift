@@ -6,6 +6,8 @@
 import Foundation
 import Structure
 
+extension STBackgroundTask: CancellableTask {}
+
 enum BatteryLevelState: Int {
   case full = 0
   case medium
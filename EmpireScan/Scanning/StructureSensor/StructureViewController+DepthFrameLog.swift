@@ -0,0 +1,110 @@
+//
+//  StructureViewController+DepthFrameLog.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import Structure
+import StructureKit
+import UIKit
+
+// Debug recording of the tracked depth stream, replayed through `TSDFVolume` and
+// `DepthTracker` to time them on real scans. Enabled by the "recordDepthFrames" default.
+extension StructureViewController {
+  var depthFrameLogDirectory: URL {
+    FileManager.default.urls(for: .documentDirectory, in: .userDomainMask)[0].appendingPathComponent("DepthFrames")
+  }
+
+  func startDepthFrameLog() {
+    guard UserDefaults.standard.bool(forKey: "recordDepthFrames") else { return }
+    let formatter = DateFormatter()
+    formatter.dateFormat = "yyyy-MM-dd_HH-mm-ss"
+    let url = depthFrameLogDirectory.appendingPathComponent("\(formatter.string(from: Date())).edf")
+    do {
+      try FileManager.default.createDirectory(at: depthFrameLogDirectory, withIntermediateDirectories: true)
+      depthFrameLog = try DepthFrameLog.Writer(url: url)
+      print("Recording depth frames to \(url.lastPathComponent)")
+    } catch {
+      print("Could not start the depth frame log: \(error.localizedDescription)")
+    }
+  }
+
+  /// Copies the frame and its tracked pose now; encoding and writing happen off the capture queue.
+  func appendToDepthFrameLog(_ depthFrame: STDepthFrame) {
+    guard let writer = depthFrameLog, let tracker = slamState.tracker else { return }
+    let frame = DepthFrameLog.Frame(depth: DepthImage(frame: depthFrame),
+                                    cameraPose: float4x4(tracker.lastFrameCameraPose()),
+                                    timestamp: depthFrame.timestamp)
+    depthFrameLogQueue.async {
+      do {
+        try writer.append(frame)
+      } catch {
+        print("Depth frame log write failed: \(error.localizedDescription)")
+      }
+    }
+  }
+
+  func stopDepthFrameLog() {
+    guard let writer = depthFrameLog else { return }
+    depthFrameLog = nil
+    depthFrameLogQueue.async {
+      try? writer.close()
+    }
+  }
+
+  #if DEBUG
+  func setupDepthFrameLogGesture() {
+    let longPress = UILongPressGestureRecognizer(target: self, action: #selector(depthFrameLogGesture(_:)))
+    longPress.numberOfTouchesRequired = 2
+    view.addGestureRecognizer(longPress)
+  }
+
+  @objc func depthFrameLogGesture(_ gesture: UILongPressGestureRecognizer) {
+    guard gesture.state == .began, presentedViewController == nil else { return }
+    let recording = UserDefaults.standard.bool(forKey: "recordDepthFrames")
+    let menu = UIAlertController(title: "Depth Frame Log", message: nil, preferredStyle: .actionSheet)
+    menu.popoverPresentationController?.sourceView = view
+    menu.popoverPresentationController?.sourceRect = CGRect(origin: gesture.location(in: view), size: .zero)
+    menu.addAction(UIAlertAction(title: recording ? "Stop Recording Scans" : "Record Scans", style: .default) { _ in
+      UserDefaults.standard.set(!recording, forKey: "recordDepthFrames")
+    })
+    menu.addAction(UIAlertAction(title: "Replay Latest Recording", style: .default) { [weak self] _ in
+      self?.replayLatestDepthFrameLog()
+    })
+    menu.addAction(UIAlertAction(title: "Cancel", style: .cancel))
+    present(menu, animated: true)
+  }
+
+  /// Runs `benchmark` and `replayTracking` on the newest log and shows the timings.
+  func replayLatestDepthFrameLog() {
+    let directory = depthFrameLogDirectory
+    let volumeSize = options.volumeSizeInMeters
+    DispatchQueue.global(qos: .utility).async {
+      let message: String
+      do {
+        let logs = try FileManager.default.contentsOfDirectory(at: directory, includingPropertiesForKeys: nil)
+          .filter { $0.pathExtension == "edf" }
+        // Names are timestamps, so the newest sorts last.
+        guard let latest = logs.max(by: { $0.lastPathComponent < $1.lastPathComponent }) else {
+          throw DepthFrameLog.error(5, "No recordings yet")
+        }
+        let frames = try DepthFrameLog.read(latest)
+        var lines = ["\(latest.lastPathComponent): \(frames.count) frames"]
+        for statistics in DepthFrameLog.benchmark(frames, volumeSize: volumeSize) {
+          lines.append(String(format: "TSDF %ld³: %.1f fps", statistics.bounds.x, statistics.framesPerSecond))
+        }
+        let tracking = DepthFrameLog.replayTracking(frames)
+        lines.append(String(format: "ICP: %.1f fps", tracking.framesPerSecond))
+        message = lines.joined(separator: "\n")
+      } catch {
+        message = error.localizedDescription
+      }
+      DispatchQueue.main.async {
+        self.showAlert(title: "Depth Frame Replay", message: message)
+      }
+    }
+  }
+  #endif
+}
@@ -270,6 +270,7 @@ extension StructureViewController {
       // Integrate it into the current mesh estimate if tracking was successful.
       do {
         try slamState.tracker!.updateCameraPose(with: depthFrame, colorFrame: colorFrame)
+        appendToDepthFrameLog(depthFrame)
 
         // Update the tracking message.
         trackingMessage = computeTrackerMessage(slamState.tracker!.trackerHints)
@@ -47,6 +47,9 @@ class StructureViewController: UIViewController, STBackgroundTaskDelegate, MeshV
   var st01CompatibilityMode: Bool = false
   var settingsPopupView: StructureSettingsPopupView?
   var calibrationOverlay: CalibrationOverlay?
+  // Debug recording of the depth stream, see StructureViewController+DepthFrameLog.
+  var depthFrameLog: DepthFrameLog.Writer?
+  let depthFrameLogQueue = DispatchQueue(label: "depthFrameLog", qos: .utility)
     
     //Params
   var footType: String?
@@ -190,6 +193,10 @@ class StructureViewController: UIViewController, STBackgroundTaskDelegate, MeshV
     let panGesture = UIPanGestureRecognizer(target: self, action: #selector(panGesture(_:)))
     view.addGestureRecognizer(panGesture)
 
+    #if DEBUG
+    setupDepthFrameLogGesture()
+    #endif
+
 //    let tapToStructureIO = UITapGestureRecognizer(target: self, action: #selector(onTapSensorRequiedImageView))
 //    sensorRequiredImageView.addGestureRecognizer(tapToStructureIO)
 //    sensorRequiredImageView.isUserInteractionEnabled = true
@@ -219,12 +226,6 @@ class StructureViewController: UIViewController, STBackgroundTaskDelegate, MeshV
         meshViewController?.orderId = orderId
         meshViewController?.orderStatus = orderStatus
 
-      // Sample a few points to estimate the volume center
-      var totalNumVertices: Int32 = 0
-      for itr in 0 ..< mesh.numberOfMeshes() {
-        totalNumVertices += mesh.number(ofMeshVertices: itr)
-      }
-
       guard let (min, max) = mesh.bbox() else {
         showAlert(title: "Error!!!", message: "Invalid mesh.")
         return
@@ -424,10 +425,12 @@ class StructureViewController: UIViewController, STBackgroundTaskDelegate, MeshV
       }
     }
 
+    startDepthFrameLog()
     enterScanningState()
   }
 
   @IBAction func resetButtonPressed(_ sender: Any) {
+    stopDepthFrameLog()
     resetSLAM()
   }
 
@@ -438,6 +441,7 @@ class StructureViewController: UIViewController, STBackgroundTaskDelegate, MeshV
         fatalError("Could not properly stop OCC writer.")
       }
     }
+    stopDepthFrameLog()
     enterViewingState()
   }
 
@@ -58,7 +58,7 @@ class ViewController: UIViewController {
   var _appStatus: AppStatus = .init()
   var _meshViewController: MeshViewController!
   var _naiveColorizeTask: STBackgroundTask?
-  var _holeFillingTask: STBackgroundTask?
+  var _holeFillingTask: CancellableTask?
   var _enhancedColorizeTask: STBackgroundTask?
   var _timeTagOnOcc: String?
   var showingMemoryWarning = false
@@ -248,28 +248,11 @@ class ViewController: UIViewController {
   }
 
   func calcBBox(_ mesh: STMesh) -> (vector_float3, vector_float3)? {
-    guard mesh.meshVertices(0) != nil else {
+    guard let bounds = mesh.statistics().bounds else {
       showAlert(title: "Error!!!", message: "Empty Mesh found while calculating Boundary Box")
       return nil
     }
-    var minPoint = vector_float3(mesh.meshVertices(0)[0])
-    var maxPoint = vector_float3(minPoint)
-
-    for i in 0..<mesh.numberOfMeshes() {
-      let numVertices = Int(mesh.number(ofMeshVertices: i))
-      if let vertex = mesh.meshVertices(Int32(i)) {
-        for j in 0..<numVertices {
-          let v = vertex[Int(j)]
-          minPoint.x = min(minPoint.x, v.x)
-          minPoint.y = min(minPoint.y, v.y)
-          minPoint.z = min(minPoint.z, v.z)
-          maxPoint.x = max(maxPoint.x, v.x)
-          maxPoint.y = max(maxPoint.y, v.y)
-          maxPoint.z = max(maxPoint.z, v.z)
-        }
-      }
-    }
-    return (minPoint, maxPoint)
+    return bounds
   }
 
   func presentMeshViewer(_ mesh: STMesh) {
@@ -286,12 +269,6 @@ class ViewController: UIViewController {
       _meshViewController.orderId = orderId
       _meshViewController.orderStatus = orderStatus
       print("presentMeshViewer")
-    // Sample a few points to estimate the volume center
-    var totalNumVertices: Int32 = 0
-    for i in 0..<mesh.numberOfMeshes() {
-      totalNumVertices += mesh.number(ofMeshVertices: i)
-    }
-
     guard let (min, max) = calcBBox(mesh) else {
       return
     }
@@ -801,27 +778,70 @@ extension ViewController: MeshViewDelegate {
     enterCubePlacementState()
   }
 
-  func fillHolesTask(mesh: STMesh, onCompletion: @escaping (_: STMesh) -> Void) -> STBackgroundTask? {
+  func fillHolesTask(mesh: STMesh, onCompletion: @escaping (_: STMesh) -> Void) -> CancellableTask? {
     _holeFillingTask = nil
-    let algoType = optionsSet.integer(forKey: .holeFillingAlgo) // "No", "Poisson", "Liepa"
+    let algoType = optionsSet.integer(forKey: .holeFillingAlgo) // "No", "Poisson", "Liepa", "Poisson (In-App)"
     if algoType != 0 {
-      let algorithm = STMeshFillHoleAlgorithm(rawValue: algoType - 1)!
-      let options: [AnyHashable: Any] = [
-        kSTMeshFillHoleMaxPatchAreaKey: 0.01,
-        kSTMeshFillHolePoissonStrategyKey: STMeshFillHolePoissonStrategy.closedHull.rawValue
-      ]
-      _holeFillingTask = STMesh.newFillHolesTask(with: mesh, algorithm: algorithm, options: options) { [weak self] (resMesh: STMesh?, error: Error?) in
+      let completion: MeshTask.Completion = { [weak self] (resMesh: MeshBuffer?, error: Error?) in
         defer { self?._holeFillingTask = nil }
         if self?._holeFillingTask?.isCancelled ?? true {
           return
         } else if error != nil {
           NSLog("Error during hole filling: \(String(describing: error!.localizedDescription))")
         } else {
-          DispatchQueue.main.async { onCompletion(resMesh!) }
+          do {
+            let filled = try resMesh!.makeSTMesh()
+            DispatchQueue.main.async { onCompletion(filled) }
+          } catch {
+            NSLog("Error during hole filling: \(error.localizedDescription)")
+          }
         }
       }
-      weak var this: ViewController? = self
-      _holeFillingTask!.delegate = this
+      // The mapper already cuts the support plane while scanning, so cutting again is
+      // opt-in; it would take the sole off a weight-bearing scan. Floating fragments
+      // (floor noise, the other foot) are dropped before filling.
+      let input = MeshBuffer(mesh: mesh)
+      let cutSupportPlane = optionsSet.bool(forKey: .cutSupportPlane, default: false)
+      let clean = { () -> MeshBuffer in
+        var cleaned = input
+        if cutSupportPlane {
+          SupportPlane.removeSupport(from: &cleaned)
+        }
+        MeshComponents.removeFragments(from: &cleaned)
+        return cleaned
+      }
+      switch algoType {
+      case 2:
+        // Patches every small hole in parallel and leaves the ankle opening open.
+        _holeFillingTask = MeshTask(work: { task in
+          try MeshHoleFiller.fillHoles(clean(), options: MeshHoleFiller.Options(maxPatchArea: 0.01), task: task)
+        }, completion: completion)
+      case 3:
+        // Uniform grid capped by the memory budget, so coarser than the SDK's; opt-in
+        // until its detail is validated against it.
+        _holeFillingTask = MeshTask(work: { task in
+          try PoissonReconstructor.reconstruct(clean(), options: PoissonReconstructor.Options(mode: .closedHull), task: task)
+        }, completion: completion)
+      default:
+        // The SDK's adaptive Poisson keeps the sole detail orthotics are made from.
+        _holeFillingTask = MeshTask(work: { _ in
+          var filled: STMesh?
+          var fillError: Error?
+          let options: [AnyHashable: Any] = [
+            kSTMeshFillHolePoissonStrategyKey: STMeshFillHolePoissonStrategy.closedHull.rawValue
+          ]
+          let sdkTask = STMesh.newFillHolesTask(with: try clean().makeSTMesh(), algorithm: .poisson,
+                                                options: options) { resMesh, error in
+            filled = resMesh
+            fillError = error
+          }
+          sdkTask?.start()
+          sdkTask?.waitUntilCompletion()
+          if let fillError = fillError { throw fillError }
+          guard let filled = filled else { throw MeshTask.cancelledError }
+          return MeshBuffer(mesh: filled)
+        }, completion: completion)
+      }
     }
     return _holeFillingTask
   }
@@ -1101,7 +1121,8 @@ extension ViewController {
     optSet.groups.append(groupTracker)
 
     let groupPostprocessing = OptionsGroup(id: .postprocessGroup)
-      .addEnum(id: .holeFillingAlgo, map: ["No", "Poisson", "Liepa"], val: 1, onChange: { _, _, _ in })
+      .addEnum(id: .holeFillingAlgo, map: ["No", "Poisson", "Liepa", "Poisson (In-App)"], val: 1, onChange: { _, _, _ in })
+      .addBool(id: .cutSupportPlane, val: false, onChange: { _, _ in })
     optSet.groups.append(groupPostprocessing)
 
     let groupSlam = OptionsGroup(id: .slamGroup)
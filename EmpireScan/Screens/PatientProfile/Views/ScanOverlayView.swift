@@ -4,6 +4,7 @@
 import Foundation
 import SwiftUI
 import PhotosUI
+import simd
 struct ScanOverlayView: View {
     
     @Binding var isPresented: Bool
@@ -20,6 +21,8 @@ struct ScanOverlayView: View {
     
     @State private var rightStlURL: URL?
     @State private var leftStlURL: URL?
+    @State private var labPackageURL: URL?
+    @State private var showLabShare = false
     var onDismiss: ((ScanFolderItem) -> Void)? = nil
     var submitOrder: ((ScanFolderItem,PatientData?,Bool) -> Void)? = nil
     @State private var showPDF = false
@@ -224,7 +227,9 @@ struct ScanOverlayView: View {
                                 isLoading = true
                                 didLoadRight = false
                                 if let rightScan = rightScan {
-                                    downloadAndExtractPreview(from: rightScan.attachmentUrl, identifier: "left_model") { url, meshUrl, stlUrl in
+                                    downloadAndExtractPreview(from: rightScan.attachmentUrl, identifier: "left_model", onPreview: { url in
+                                        self.rightPreviewURL = url
+                                    }) { url, meshUrl, stlUrl in
                                         self.rightPreviewURL = url
                                         print("left---->",stlUrl)
                                         self.rightMeshURL = meshUrl
@@ -255,7 +260,9 @@ struct ScanOverlayView: View {
                                 isLoading = true
                                 didLoadLeft = false
                                 if let leftScan = leftScan {
-                                    downloadAndExtractPreview(from: leftScan.attachmentUrl, identifier: "right_model") { url, meshUrl,stlUrl in
+                                    downloadAndExtractPreview(from: leftScan.attachmentUrl, identifier: "right_model", onPreview: { url in
+                                        self.leftPreviewURL = url
+                                    }) { url, meshUrl,stlUrl in
                                         print("right---->",stlUrl)
                                         self.leftPreviewURL = url
                                         self.leftMeshURL = meshUrl
@@ -292,6 +299,26 @@ struct ScanOverlayView: View {
                             .foregroundColor(.white)
                             .clipShape(Circle())
                     }
+                    if let leftUrl = leftStlURL, let rightUrl = rightStlURL {
+                        // 3MF for the lab: both feet, each placed by its own transform
+                        Button(action: {
+                            shareLabPackage(leftURL: leftUrl, rightURL: rightUrl)
+                        }) {
+                            Image(systemName: "square.and.arrow.up")
+                                .resizable()
+                                .scaledToFit()
+                                .frame(width: screenHeight * 0.02, height: screenHeight * 0.02)
+                                .padding(10)
+                                .background(Color.white.opacity(0.3))
+                                .foregroundColor(.white)
+                                .clipShape(Circle())
+                        }
+                        .sheet(isPresented: $showLabShare) {
+                            if let labPackageURL = labPackageURL {
+                                ShareSheet(items: [labPackageURL])
+                            }
+                        }
+                    }
                     if(isEditable){
                         // 📷 Photo Library Button
                         Button(action: {
@@ -859,56 +886,45 @@ struct ScanOverlayView: View {
     }
     
     func mergeBinarySTLFiles(leftURL: URL, rightURL: URL, outputURL: URL, rightModelXOffset: Float = 0.25) throws {
-        func readTriangles(from url: URL, offsetX: Float = 0.0) throws -> [Data] {
-            let data = try Data(contentsOf: url)
-            guard data.count >= 84 else { throw NSError(domain: "STL", code: 1, userInfo: [NSLocalizedDescriptionKey: "Invalid STL file size"]) }
-
-            let triangleCount = data.subdata(in: 80..<84).withUnsafeBytes { $0.load(as: UInt32.self) }
-            let expectedSize = 84 + Int(triangleCount) * 50
-            guard data.count == expectedSize else { throw NSError(domain: "STL", code: 2, userInfo: [NSLocalizedDescriptionKey: "File size doesn't match triangle count"]) }
+        try STLMerge.merge([
+            STLMergeInput(url: leftURL),
+            STLMergeInput(url: rightURL, offsetX: rightModelXOffset)
+        ], to: outputURL)
+        print("✅ Merged STL file written to: \(outputURL.path)")
+    }
 
-            var triangles: [Data] = []
+    /// Writes both feet as one 3MF, the right foot placed by its build transform
+    /// rather than baked into the geometry as `mergeBinarySTLFiles` does.
+    func writeLabPackage(leftURL: URL, rightURL: URL, outputURL: URL, rightModelXOffset: Float = 0.25) throws {
+        var offset = matrix_identity_float4x4
+        offset.columns.3.x = rightModelXOffset
+        try ThreeMFWriter.write([
+            ThreeMFObject(name: "Left", stlURL: leftURL),
+            ThreeMFObject(name: "Right", stlURL: rightURL, transform: offset)
+        ], to: outputURL)
+        print("✅ 3MF package written to: \(outputURL.path)")
+    }
 
-            for i in 0..<triangleCount {
-                let start = 84 + Int(i) * 50
-                var triangle = data.subdata(in: start..<(start + 50))
-                // Offset the vertex positions if needed
-                if offsetX != 0 {
-                    var mutableTriangle = triangle
-                    for j in 0..<3 { // 3 vertices
-                        let vertexOffset = 12 + j * 12 // Normal is first 12 bytes
-                        let xRange = vertexOffset..<(vertexOffset + 4)
-                        let x = mutableTriangle.subdata(in: xRange).withUnsafeBytes { $0.load(as: Float.self) }
-                        var newX = x + offsetX
-                        let newXData = Data(bytes: &newX, count: 4)
-                        mutableTriangle.replaceSubrange(xRange, with: newXData)
-                    }
-                    triangles.append(mutableTriangle)
-                } else {
-                    triangles.append(triangle)
+    private func shareLabPackage(leftURL: URL, rightURL: URL) {
+        isLoading = true
+        let outputURL = FileManager.default.temporaryDirectory.appendingPathComponent("Order_\(patient?.orderId ?? 0).3mf")
+        DispatchQueue.global(qos: .userInitiated).async {
+            do {
+                try writeLabPackage(leftURL: leftURL, rightURL: rightURL, outputURL: outputURL)
+                DispatchQueue.main.async {
+                    isLoading = false
+                    labPackageURL = outputURL
+                    showLabShare = true
+                }
+            } catch {
+                print("❌ Failed to write 3MF package: \(error)")
+                DispatchQueue.main.async {
+                    isLoading = false
+                    toastMessage = "Could not prepare the 3MF file"
+                    isToastVisible = true
                 }
             }
-            return triangles
         }
-
-        let leftTriangles = try readTriangles(from: leftURL)
-        let rightTriangles = try readTriangles(from: rightURL, offsetX: rightModelXOffset)
-        let allTriangles = leftTriangles + rightTriangles
-        let totalCount = UInt32(allTriangles.count)
-        var mergedData = Data()
-
-        let header = "Merged STL File".padding(toLength: 80, withPad: " ", startingAt: 0)
-        mergedData.append(header.data(using: .ascii)!)
-
-        var triangleCount = totalCount
-        mergedData.append(Data(bytes: &triangleCount, count: 4))
-
-        for triangle in allTriangles {
-            mergedData.append(triangle)
-        }
-        
-        try mergedData.write(to: outputURL)
-        print("✅ Merged STL file written to: \(outputURL.path)")
     }
 }
 
@@ -40,9 +40,8 @@ struct STLViewerScreen: View {
             } else {
                 Text("Loading STL...")
                     .onAppear {
-                        if let url = Bundle.main.url(forResource: "20255167140259", withExtension: "stl"),
-                           let triangles = STLParser.loadBinarySTL(from: url) {
-                            self.geometry = STLParser.buildGeometry(from: triangles)
+                        if let url = Bundle.main.url(forResource: "20255167140259", withExtension: "stl") {
+                            self.geometry = STLParser.loadGeometry(from: url)
                         }
                     }
             }
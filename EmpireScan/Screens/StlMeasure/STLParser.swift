@@ -7,74 +7,37 @@
 import Foundation
 import SceneKit
 
-struct Triangle {
-    let normal: SIMD3<Float>
-    let vertices: [SIMD3<Float>] // 3 vertices per triangle
-}
-
 class STLParser {
-    static func loadBinarySTL(from url: URL) -> [Triangle]? {
-        guard let data = try? Data(contentsOf: url) else {
-            print("Failed to load data from \(url)")
-            return nil
-        }
-        
-        guard data.count > 84 else {
-            print("Invalid STL file size")
+    /// Maps the STL at `url`, welds the triangle soup into an indexed mesh and builds
+    /// the geometry from it, without allocating per triangle. The welded mesh is kept
+    /// as a blob next to the STL, so opening the same file again skips the parse.
+    static func loadGeometry(from url: URL, weldEpsilon: Float = MeshWelder.defaultEpsilon) -> SCNGeometry? {
+        do {
+            return buildGeometry(from: try MeshBlob.cached(forSTL: url, weldEpsilon: weldEpsilon))
+        } catch {
+            print("Failed to load STL from \(url): \(error.localizedDescription)")
             return nil
         }
-        
-        let triangleCount = Int(data.subdata(in: 80..<84).withUnsafeBytes { $0.load(as: UInt32.self) })
-        var triangles: [Triangle] = []
-        var offset = 84
-        
-        for _ in 0..<triangleCount {
-            guard offset + 50 <= data.count else { break }
-            let normal = data.subdata(in: offset..<offset+12).withUnsafeBytes {
-                SIMD3<Float>($0.load(fromByteOffset: 0, as: Float.self),
-                             $0.load(fromByteOffset: 4, as: Float.self),
-                             $0.load(fromByteOffset: 8, as: Float.self))
-            }
-            offset += 12
-            
-            var vertices: [SIMD3<Float>] = []
-            for _ in 0..<3 {
-                let vertex = data.subdata(in: offset..<offset+12).withUnsafeBytes {
-                    SIMD3<Float>($0.load(fromByteOffset: 0, as: Float.self),
-                                 $0.load(fromByteOffset: 4, as: Float.self),
-                                 $0.load(fromByteOffset: 8, as: Float.self))
-                }
-                vertices.append(vertex)
-                offset += 12
-            }
-            
-            offset += 2 // skip attribute byte count
-            triangles.append(Triangle(normal: normal, vertices: vertices))
-        }
-        
-        return triangles
     }
-    
-    static func buildGeometry(from triangles: [Triangle]) -> SCNGeometry {
-        var allVertices: [SIMD3<Float>] = []
-        var indices: [Int32] = []
-        var currentIndex: Int32 = 0
-        
-        for triangle in triangles {
-            for vertex in triangle.vertices {
-                allVertices.append(vertex)
-                indices.append(currentIndex)
-                currentIndex += 1
-            }
+
+    /// Indexed geometry read straight from a mapped blob's packed vectors.
+    static func buildGeometry(from blob: MeshBlob) -> SCNGeometry {
+        func source(_ semantic: SCNGeometrySource.Semantic, offset: Int) -> SCNGeometrySource {
+            SCNGeometrySource(data: blob.data,
+                              semantic: semantic,
+                              vectorCount: blob.vertexCount,
+                              usesFloatComponents: true,
+                              componentsPerVector: 3,
+                              bytesPerComponent: MemoryLayout<Float>.size,
+                              dataOffset: offset,
+                              dataStride: MeshBlob.vectorSize)
         }
-        
-        let vertexSource = SCNGeometrySource(vertices: allVertices.map { SCNVector3($0.x, $0.y, $0.z) })
-        let indexData = Data(bytes: indices, count: indices.count * MemoryLayout<Int32>.size)
-        let element = SCNGeometryElement(data: indexData,
+        let element = SCNGeometryElement(data: blob.indexData,
                                          primitiveType: .triangles,
-                                         primitiveCount: indices.count / 3,
-                                         bytesPerIndex: MemoryLayout<Int32>.size)
-        
-        return SCNGeometry(sources: [vertexSource], elements: [element])
+                                         primitiveCount: blob.faceCount,
+                                         bytesPerIndex: MemoryLayout<UInt32>.size)
+
+        return SCNGeometry(sources: [source(.vertex, offset: blob.positionsOffset), source(.normal, offset: blob.normalsOffset)],
+                           elements: [element])
     }
 }
@@ -24,6 +24,7 @@ class AuthService {
             case .success(let apiResponse):
                 TokenManager.shared.accessToken = apiResponse.data?.accessToken
                 TokenManager.shared.refreshToken = apiResponse.data?.refreshToken
+                UploadQueue.shared.resume()
                 //print("Login Response:", apiResponse)
                 completion(.success(apiResponse))
             case .failure(let error):
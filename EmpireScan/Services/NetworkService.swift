@@ -128,12 +128,58 @@ class NetworkService {
             finalHeaders.add(name: "Authorization", value: "Bearer \(accessToken)")
         }
         
-        AF.upload(multipartFormData: { formData in
+        let request = AF.upload(multipartFormData: { formData in
             for (key, value) in parameters {
                 formData.append(Data(value.utf8), withName: key)
             }
             formData.append(fileData, withName: docType, fileName: fileName, mimeType: mimeType)
         }, to: url, headers: finalHeaders)
+        decodeUpload(request, completion: completion)
+    }
+
+    /// Retries uploads that failed on a dropped connection or a transient server error,
+    /// backing off 1, 2 and 4 seconds. POST is included: a dropped upload is far more
+    /// common than a lost response, and a duplicate attachment beats a lost scan.
+    static let uploadRetryPolicy = RetryPolicy(retryLimit: 3,
+                                               exponentialBackoffBase: 2,
+                                               exponentialBackoffScale: 1,
+                                               retryableHTTPMethods: RetryPolicy.defaultRetryableHTTPMethods.union([.post]))
+
+    /// Uploads the file at `fileURL` as one multipart part without loading it into memory.
+    ///
+    /// The multipart body is encoded to a temporary file in small buffers and sent
+    /// from there, so peak memory does not grow with the file. A failed attempt is
+    /// retried with `uploadRetryPolicy` before `completion` sees the error.
+    func upload<T: Decodable>(
+        endpoint: String,
+        parameters: [String: String] = [:],
+        fileURL: URL,
+        fileName: String,
+        mimeType: String,
+        headers: HTTPHeaders = [:],
+        docType: String,
+        completion: @escaping (Result<T, Error>) -> Void
+    ) {
+        let url = "\(baseURL)/\(endpoint)"
+        print("URL: \(url)")
+        print("Parameters: \(parameters)")
+
+        var finalHeaders = headers
+        if let accessToken = TokenManager.shared.accessToken {
+            finalHeaders.add(name: "Authorization", value: "Bearer \(accessToken)")
+        }
+
+        let request = AF.upload(multipartFormData: { formData in
+            for (key, value) in parameters {
+                formData.append(Data(value.utf8), withName: key)
+            }
+            formData.append(fileURL, withName: docType, fileName: fileName, mimeType: mimeType)
+        }, to: url, usingThreshold: 0, headers: finalHeaders, interceptor: NetworkService.uploadRetryPolicy)
+        decodeUpload(request, completion: completion)
+    }
+
+    private func decodeUpload<T: Decodable>(_ request: UploadRequest, completion: @escaping (Result<T, Error>) -> Void) {
+        request
         .validate()
         .responseDecodable(of: T.self) { response in
             switch response.result {
@@ -0,0 +1,228 @@
+//
+//  ScanCache.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import CryptoKit
+
+/// On-disk cache of downloaded scan archives and the files pulled out of them.
+///
+/// Archives are stored by the SHA-256 of their contents, so the same scan reached
+/// through different links is kept once. Each link, minus its signature parameters,
+/// remembers the archive it last resolved to and its ETag, and is revalidated with
+/// `If-None-Match`; a 304 serves the cached copy. Without a network the cached copy
+/// is only served to the exact link it was downloaded from. Everything is installed
+/// by renaming a finished file into place, and the least recently used archives are
+/// evicted once the cache grows past its budget.
+final class ScanCache {
+    static let shared = ScanCache()
+
+    /// One cached archive and the files derived from it.
+    struct Object {
+        let hash: String
+        let directory: URL
+
+        var archiveURL: URL { directory.appendingPathComponent("archive.zip") }
+    }
+
+    private struct Record: Codable {
+        var hash: String
+        var etag: String?
+        var lastAccess: Date
+        /// Full link the archive was downloaded from.
+        var url: String?
+    }
+
+    /// Query parameters that only sign a link, compared case-insensitively. Names ending
+    /// in "-" are prefixes.
+    static let signatureParameters = ["x-amz-", "x-goog-", "sig", "se", "st", "sp", "sv", "sr", "spr", "si", "skoid",
+                                      "sktid", "skt", "ske", "sks", "skv", "expires", "signature", "key-pair-id", "policy"]
+
+    let directory: URL
+    /// Bytes kept on disk before the least recently used archives are dropped.
+    let budget: Int
+
+    private let session: URLSession
+    private let queue = DispatchQueue(label: "ScanCache")
+    private var records: [String: Record] = [:]
+
+    private var objectsURL: URL { directory.appendingPathComponent("objects") }
+    private var stagingURL: URL { directory.appendingPathComponent("staging") }
+    private var indexURL: URL { directory.appendingPathComponent("index.json") }
+
+    init(directory: URL = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask)[0].appendingPathComponent("ScanCache"),
+         budget: Int = 512 * 1024 * 1024,
+         session: URLSession = .shared) {
+        self.directory = directory
+        self.budget = budget
+        self.session = session
+        let fileManager = FileManager.default
+        try? fileManager.removeItem(at: stagingURL)
+        try? fileManager.createDirectory(at: objectsURL, withIntermediateDirectories: true)
+        try? fileManager.createDirectory(at: stagingURL, withIntermediateDirectories: true)
+        if let data = try? Data(contentsOf: indexURL),
+           let saved = try? JSONDecoder().decode([String: Record].self, from: data) {
+            records = saved
+        }
+    }
+
+    /// The cached archive for `url`, downloaded only when it is missing or has changed.
+    /// `completion` runs on a background queue.
+    func archive(for url: URL, completion: @escaping (Result<Object, Error>) -> Void) {
+        let key = ScanCache.key(for: url)
+        let (cached, exactMatch): (Object?, Bool) = queue.sync {
+            guard let record = records[key] else { return (nil, false) }
+            let object = self.object(record.hash)
+            guard FileManager.default.fileExists(atPath: object.archiveURL.path) else { return (nil, false) }
+            return (object, record.url == url.absoluteString)
+        }
+
+        var request = URLRequest(url: url)
+        if cached != nil, let etag = queue.sync(execute: { records[key]?.etag }) {
+            request.setValue(etag, forHTTPHeaderField: "If-None-Match")
+        }
+        session.downloadTask(with: request) { [self] tempURL, response, error in
+            let status = (response as? HTTPURLResponse)?.statusCode ?? 200
+            // Offline, a link that only shares a key with the cached one may name another scan.
+            if let cached = cached, (error == nil && status == 304) || (error != nil && exactMatch) {
+                if error != nil {
+                    print("⚠️ ScanCache serving \(cached.hash) offline: \(error!.localizedDescription)")
+                }
+                touch(key)
+                completion(.success(cached))
+                return
+            }
+            guard let tempURL = tempURL, error == nil, (200..<300).contains(status) else {
+                completion(.failure(error ?? ScanCache.error(1, "Download failed with status \(status)")))
+                return
+            }
+            do {
+                let object = try install(tempURL)
+                let etag = (response as? HTTPURLResponse)?.value(forHTTPHeaderField: "ETag")
+                queue.sync {
+                    records[key] = Record(hash: object.hash, etag: etag, lastAccess: Date(), url: url.absoluteString)
+                    saveIndex()
+                    evict(keeping: object.hash)
+                }
+                completion(.success(object))
+            } catch {
+                completion(.failure(error))
+            }
+        }.resume()
+    }
+
+    /// `name` inside `object`, produced by `build` the first time it is asked for.
+    ///
+    /// `build` writes to a scratch path that is renamed into place once complete, so
+    /// a crash or a concurrent build never leaves a partial file behind.
+    func file(_ name: String, in object: Object, build: (URL) throws -> Void) throws -> URL {
+        let target = object.directory.appendingPathComponent((name as NSString).lastPathComponent)
+        let fileManager = FileManager.default
+        if fileManager.fileExists(atPath: target.path) {
+            return target
+        }
+        let scratch = stagingURL.appendingPathComponent(UUID().uuidString)
+        defer { try? fileManager.removeItem(at: scratch) }
+        try build(scratch)
+        do {
+            try fileManager.moveItem(at: scratch, to: target)
+        } catch where fileManager.fileExists(atPath: target.path) {
+            // Another caller installed it first.
+        }
+        return target
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "ScanCache", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+
+    /// The full link without its fragment and signature parameters, which change on
+    /// every request. Everything else in the query may name the scan and is kept.
+    private static func key(for url: URL) -> String {
+        guard var components = URLComponents(url: url, resolvingAgainstBaseURL: false) else { return url.absoluteString }
+        components.fragment = nil
+        if let items = components.queryItems {
+            let kept = items.filter { !isSignatureParameter($0.name) }
+            components.queryItems = kept.isEmpty ? nil : kept
+        }
+        return components.string ?? url.absoluteString
+    }
+
+    private static func isSignatureParameter(_ name: String) -> Bool {
+        let name = name.lowercased()
+        return signatureParameters.contains { $0.hasSuffix("-") ? name.hasPrefix($0) : name == $0 }
+    }
+
+    private func object(_ hash: String) -> Object {
+        Object(hash: hash, directory: objectsURL.appendingPathComponent(hash))
+    }
+
+    /// Hashes a finished download and renames it into its object directory.
+    private func install(_ downloadURL: URL) throws -> Object {
+        let hash = try SHA256.hexDigest(ofFileAt: downloadURL)
+        let object = self.object(hash)
+        let fileManager = FileManager.default
+        if fileManager.fileExists(atPath: object.archiveURL.path) {
+            return object
+        }
+        let staged = stagingURL.appendingPathComponent(UUID().uuidString)
+        defer { try? fileManager.removeItem(at: staged) }
+        try fileManager.createDirectory(at: staged, withIntermediateDirectories: true)
+        try fileManager.moveItem(at: downloadURL, to: staged.appendingPathComponent(object.archiveURL.lastPathComponent))
+        do {
+            try fileManager.moveItem(at: staged, to: object.directory)
+        } catch where fileManager.fileExists(atPath: object.archiveURL.path) {
+            // Same content installed concurrently.
+        }
+        return object
+    }
+
+    private func touch(_ key: String) {
+        queue.sync {
+            records[key]?.lastAccess = Date()
+            saveIndex()
+        }
+    }
+
+    /// Must run on `queue`.
+    private func saveIndex() {
+        if let data = try? JSONEncoder().encode(records) {
+            try? data.write(to: indexURL, options: .atomic)
+        }
+    }
+
+    /// Drops the least recently used objects until the cache fits its budget. Must run on `queue`.
+    private func evict(keeping kept: String) {
+        let fileManager = FileManager.default
+        guard let hashes = try? fileManager.contentsOfDirectory(atPath: objectsURL.path) else { return }
+        var lastAccess: [String: Date] = [:]
+        for record in records.values {
+            lastAccess[record.hash] = max(lastAccess[record.hash] ?? .distantPast, record.lastAccess)
+        }
+        var sizes: [String: Int] = [:]
+        for hash in hashes {
+            sizes[hash] = ScanCache.size(of: object(hash).directory)
+        }
+        var total = sizes.values.reduce(0, +)
+        for hash in hashes.sorted(by: { (lastAccess[$0] ?? .distantPast) < (lastAccess[$1] ?? .distantPast) }) {
+            guard total > budget else { break }
+            guard hash != kept else { continue }
+            try? fileManager.removeItem(at: object(hash).directory)
+            total -= sizes[hash] ?? 0
+            records = records.filter { $0.value.hash != hash }
+        }
+        saveIndex()
+    }
+
+    private static func size(of directory: URL) -> Int {
+        let enumerator = FileManager.default.enumerator(at: directory, includingPropertiesForKeys: [.fileSizeKey])
+        var total = 0
+        while let file = enumerator?.nextObject() as? URL {
+            total += (try? file.resourceValues(forKeys: [.fileSizeKey]).fileSize) ?? 0
+        }
+        return total
+    }
+}
@@ -33,9 +33,10 @@ class ScansService {
         folderId: Int?,
         orderStatus:String,
         meshFileURL: URL,
+        fileName: String? = nil,
         completion: @escaping (Result<APIResponse<OrderScans>, Error>) -> Void
     ) {
-        guard let fileData = try? Data(contentsOf: meshFileURL) else {
+        guard FileManager.default.isReadableFile(atPath: meshFileURL.path) else {
             print("❌ Error: Unable to read mesh file at path \(meshFileURL.path)")
             completion(.failure(NSError(domain: "FileError", code: -1, userInfo: [NSLocalizedDescriptionKey: "File not found"])))
             return
@@ -57,8 +58,8 @@ class ScansService {
         NetworkService.shared.upload(
             endpoint: ScansEndpoints.UploadScanAttachment,
             parameters: parameters,
-            fileData: fileData,
-            fileName: meshFileURL.lastPathComponent,
+            fileURL: meshFileURL,
+            fileName: fileName ?? meshFileURL.lastPathComponent,
             mimeType: "application/zip",
             docType: "attachment",
             completion: completion
@@ -71,10 +72,11 @@ class ScansService {
         documentId:Int? = nil,
         orderStatus: String,
         fileURL: URL,
+        fileName: String? = nil,
         documentType: String = "document", // e.g., "scan", "image", "attachment"
         completion: @escaping (Result<APIResponse<OrderScans>, Error>) -> Void
     ) {
-        guard let fileData = try? Data(contentsOf: fileURL) else {
+        guard FileManager.default.isReadableFile(atPath: fileURL.path) else {
             print("❌ Error: Unable to read file at path \(fileURL.path)")
             completion(.failure(NSError(domain: "FileError", code: -1, userInfo: [NSLocalizedDescriptionKey: "File not found"])))
             return
@@ -96,8 +98,8 @@ class ScansService {
         NetworkService.shared.upload(
             endpoint: ScansEndpoints.UploadScanAttachment,
             parameters: parameters,
-            fileData: fileData,
-            fileName: fileURL.lastPathComponent,
+            fileURL: fileURL,
+            fileName: fileName ?? fileURL.lastPathComponent,
             mimeType: mimeType,
             docType:"attachment",
             completion: completion
@@ -0,0 +1,442 @@
+//
+//  UploadQueue.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import Alamofire
+import CryptoKit
+
+/// Durable queue of scan and document uploads that survives bad Wi-Fi and app restarts.
+///
+/// Every change is appended to a journal of JSON lines before it takes effect, and
+/// the journal is replayed on launch. Writes reach the file at once, so a killed app
+/// loses nothing; `fsync` runs at most every `syncInterval`, grouping bursts of
+/// changes into one flush. A file already queued or uploaded for the same order and
+/// foot is recognised by its SHA-256 and not sent twice. A small pool of workers
+/// drains the queue, backing off after failures. A rejected session holds every
+/// upload until the next sign-in calls `resume()`. Files the server refuses for good
+/// are kept as failed, announced with `uploadFailed`, and only deleted by `discard`.
+final class UploadQueue {
+    static let shared = UploadQueue()
+
+    enum Kind: String, Codable {
+        case scan
+        case document
+    }
+
+    /// One upload and the order metadata `ScansService` sends with it.
+    struct Item: Codable {
+        let id: UUID
+        let kind: Kind
+        let contentHash: String
+        /// Name of the queued copy inside the queue's `files` folder.
+        let storedFileName: String
+        /// Name of the file that was queued, which the server names the attachment after.
+        /// Missing from items journaled before it was recorded.
+        var fileName: String?
+        let orderId: Int
+        let folderId: Int?
+        let orderStatus: String
+        var description = ""
+        var footType = ""
+        var scanType = ""
+        var documentId: Int?
+        var documentType = "document"
+
+        /// Uploads with the same key carry the same bytes to the same place.
+        var deduplicationKey: String {
+            "\(kind.rawValue)|\(orderId)|\(footType)|\(documentType)|\(contentHash)"
+        }
+    }
+
+    typealias Completion = (Result<APIResponse<OrderScans>, Error>) -> Void
+
+    /// Reported when the same file was already uploaded for the same order.
+    static let duplicateError = UploadQueue.error(1, "This file has already been uploaded")
+    /// Error code for an upload that failed for now and stays queued for another try.
+    static let queuedErrorCode = 2
+    /// Error code for an upload the server refused; the file is kept until retried or discarded.
+    static let failedErrorCode = 3
+    /// `userInfo` key of the server's reason in an `uploadFailed` notification.
+    static let failureReasonKey = "reason"
+
+    /// Uploads running at once.
+    let maxConcurrentUploads: Int
+    /// Longest a journal write waits for its `fsync`.
+    let syncInterval: TimeInterval = 0.05
+    let directory: URL
+
+    private enum Operation: String, Codable {
+        case add
+        case attempt
+        case failed
+        case retry
+        case done
+    }
+
+    private struct Record: Codable {
+        let operation: Operation
+        let id: UUID
+        var item: Item?
+        var deduplicationKey: String?
+        var reason: String?
+    }
+
+    private let queue = DispatchQueue(label: "UploadQueue")
+    private var items: [Item] = []
+    private var attempts: [UUID: Int] = [:]
+    private var notBefore: [UUID: Date] = [:]
+    /// Server reason for each item refused for good; these are not retried on their own.
+    private var failures: [UUID: String] = [:]
+    /// Set when the session was rejected; nothing is sent until the next `resume()`.
+    private var waitingForLogin = false
+    private var running: Set<UUID> = []
+    private var uploaded: Set<String> = []
+    private var completions: [UUID: [Completion]] = [:]
+    private var journal: FileHandle?
+    private var syncScheduled = false
+    private var wakeScheduled = false
+
+    private var filesURL: URL { directory.appendingPathComponent("files") }
+    private var journalURL: URL { directory.appendingPathComponent("journal.log") }
+
+    init(directory: URL = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask)[0].appendingPathComponent("UploadQueue"),
+         maxConcurrentUploads: Int = 2) {
+        self.directory = directory
+        self.maxConcurrentUploads = maxConcurrentUploads
+        queue.sync { replay() }
+    }
+
+    /// Number of uploads still waiting or running.
+    var pendingCount: Int {
+        queue.sync { items.count }
+    }
+
+    /// Uploads the server refused, kept until `retry` or `discard`.
+    var failedItems: [Item] {
+        queue.sync { items.filter { failures[$0.id] != nil } }
+    }
+
+    /// Starts draining whatever the journal still holds, e.g. at launch or after a
+    /// sign-in, and announces the uploads that are still failed.
+    func resume() {
+        queue.async {
+            self.waitingForLogin = false
+            for item in self.items {
+                if let reason = self.failures[item.id] { self.announceFailure(of: item, reason: reason) }
+            }
+            self.pump()
+        }
+    }
+
+    /// Queues a failed upload again.
+    func retry(_ id: UUID) {
+        queue.async {
+            guard self.failures.removeValue(forKey: id) != nil else { return }
+            self.append(Record(operation: .retry, id: id))
+            self.attempts[id] = nil
+            self.notBefore[id] = nil
+            self.pump()
+        }
+    }
+
+    /// Drops a failed upload and its queued file.
+    func discard(_ id: UUID) {
+        queue.async {
+            guard self.failures[id] != nil, let item = self.items.first(where: { $0.id == id }) else { return }
+            self.complete(item, uploaded: false)
+        }
+    }
+
+    /// Queues a scan archive for `ScansService.uploadScanResult`.
+    ///
+    /// `completion` runs on the main queue once: after the upload succeeds, fails for
+    /// good, or fails for the first time, in which case the upload stays queued and
+    /// is retried in the background.
+    func enqueueScan(fileURL: URL, orderId: Int, description: String = "", footType: String, scanType: String,
+                     folderId: Int?, orderStatus: String, completion: Completion? = nil) {
+        enqueue(fileURL: fileURL, completion: completion) { id, hash, stored in
+            var item = Item(id: id, kind: .scan, contentHash: hash, storedFileName: stored,
+                            orderId: orderId, folderId: folderId, orderStatus: orderStatus)
+            item.description = description
+            item.footType = footType
+            item.scanType = scanType
+            return item
+        }
+    }
+
+    /// Queues a document for `ScansService.uploadOrderDocument`, with the same completion rules.
+    func enqueueDocument(fileURL: URL, orderId: Int, folderId: Int? = nil, documentId: Int? = nil,
+                         orderStatus: String, documentType: String = "document", completion: Completion? = nil) {
+        enqueue(fileURL: fileURL, completion: completion) { id, hash, stored in
+            var item = Item(id: id, kind: .document, contentHash: hash, storedFileName: stored,
+                            orderId: orderId, folderId: folderId, orderStatus: orderStatus)
+            item.documentId = documentId
+            item.documentType = documentType
+            return item
+        }
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "UploadQueue", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+
+    private func enqueue(fileURL: URL, completion: Completion?, makeItem: @escaping (UUID, String, String) -> Item) {
+        queue.async {
+            do {
+                let hash = try SHA256.hexDigest(ofFileAt: fileURL)
+                let id = UUID()
+                // The copy is named by content; the upload goes out under the original name.
+                let stored = "\(hash).\(fileURL.pathExtension)"
+                var item = makeItem(id, hash, stored)
+                item.fileName = fileURL.lastPathComponent
+                if self.uploaded.contains(item.deduplicationKey) {
+                    self.finish([completion].compactMap { $0 }, with: .failure(UploadQueue.duplicateError))
+                    return
+                }
+                if let queued = self.items.first(where: { $0.deduplicationKey == item.deduplicationKey }) {
+                    if let completion = completion { self.completions[queued.id, default: []].append(completion) }
+                    return
+                }
+
+                // Journal first: a kill before the file lands leaves an add that replay drops.
+                self.append(Record(operation: .add, id: id, item: item))
+                do {
+                    try self.store(fileURL, as: stored)
+                } catch {
+                    self.append(Record(operation: .done, id: id))
+                    throw error
+                }
+                self.items.append(item)
+                if let completion = completion { self.completions[id] = [completion] }
+                self.pump()
+            } catch {
+                self.finish([completion].compactMap { $0 }, with: .failure(error))
+            }
+        }
+    }
+
+    /// Starts uploads until the pool is full. Must run on `queue`.
+    private func pump() {
+        guard !waitingForLogin else { return }
+        let now = Date()
+        for item in items where running.count < maxConcurrentUploads {
+            guard !running.contains(item.id), failures[item.id] == nil,
+                  (notBefore[item.id] ?? .distantPast) <= now else { continue }
+            running.insert(item.id)
+            upload(item) { result in
+                self.queue.async { self.uploadDidFinish(item, result: result) }
+            }
+        }
+        if running.isEmpty, !wakeScheduled, let wake = notBefore.filter({ failures[$0.key] == nil }).values.min() {
+            wakeScheduled = true
+            queue.asyncAfter(deadline: .now() + max(0, wake.timeIntervalSince(now))) {
+                self.wakeScheduled = false
+                self.pump()
+            }
+        }
+    }
+
+    private func upload(_ item: Item, completion: @escaping Completion) {
+        let fileURL = filesURL.appendingPathComponent(item.storedFileName)
+        let fileName = item.fileName ?? item.storedFileName
+        switch item.kind {
+        case .scan:
+            ScansService.shared.uploadScanResult(orderId: item.orderId, description: item.description,
+                                                 footType: item.footType, scanType: item.scanType,
+                                                 folderId: item.folderId, orderStatus: item.orderStatus,
+                                                 meshFileURL: fileURL, fileName: fileName, completion: completion)
+        case .document:
+            ScansService.shared.uploadOrderDocument(orderId: item.orderId, folderId: item.folderId,
+                                                    documentId: item.documentId, orderStatus: item.orderStatus,
+                                                    fileURL: fileURL, fileName: fileName,
+                                                    documentType: item.documentType, completion: completion)
+        }
+    }
+
+    /// Must run on `queue`.
+    private func uploadDidFinish(_ item: Item, result: Result<APIResponse<OrderScans>, Error>) {
+        running.remove(item.id)
+        let waiting = completions.removeValue(forKey: item.id) ?? []
+        var reported = result
+        switch result {
+        case .success(let response):
+            complete(item, uploaded: true)
+            if waiting.isEmpty, item.kind == .scan {
+                DispatchQueue.main.async {
+                    NotificationCenter.default.post(name: .scanUploadedSuccessfully, object: response.data)
+                }
+            }
+        case .failure(let error) where UploadQueue.isAuthenticationFailure(error):
+            // The token expired; retrying before the next sign-in only repeats the 401.
+            waitingForLogin = true
+            print("🔒 Upload of \(item.storedFileName) needs a new sign-in: \(error.localizedDescription)")
+            reported = .failure(NSError(domain: "UploadQueue", code: UploadQueue.queuedErrorCode, userInfo: [
+                NSLocalizedDescriptionKey: "Upload saved and will be sent after you sign in again",
+                NSUnderlyingErrorKey: error
+            ]))
+        case .failure(let error) where UploadQueue.isPermanent(error):
+            print("❌ Upload of \(item.storedFileName) rejected: \(error.localizedDescription)")
+            failures[item.id] = error.localizedDescription
+            append(Record(operation: .failed, id: item.id, reason: error.localizedDescription))
+            announceFailure(of: item, reason: error.localizedDescription)
+            reported = .failure(NSError(domain: "UploadQueue", code: UploadQueue.failedErrorCode, userInfo: [
+                NSLocalizedDescriptionKey: "Upload was rejected and is kept until you retry or discard it",
+                NSUnderlyingErrorKey: error
+            ]))
+        case .failure(let error):
+            let attempt = (attempts[item.id] ?? 0) + 1
+            attempts[item.id] = attempt
+            append(Record(operation: .attempt, id: item.id))
+            notBefore[item.id] = Date().addingTimeInterval(min(60, pow(2, Double(attempt))))
+            print("⚠️ Upload of \(item.storedFileName) failed (attempt \(attempt)), retrying later: \(error.localizedDescription)")
+            reported = .failure(NSError(domain: "UploadQueue", code: UploadQueue.queuedErrorCode, userInfo: [
+                NSLocalizedDescriptionKey: "Upload saved and will be retried when the connection is back",
+                NSUnderlyingErrorKey: error
+            ]))
+        }
+        finish(waiting, with: reported)
+        pump()
+    }
+
+    /// Removes a finished item from the queue and the disk. Must run on `queue`.
+    private func complete(_ item: Item, uploaded didUpload: Bool) {
+        append(Record(operation: .done, id: item.id, deduplicationKey: didUpload ? item.deduplicationKey : nil))
+        if didUpload { uploaded.insert(item.deduplicationKey) }
+        items.removeAll { $0.id == item.id }
+        attempts[item.id] = nil
+        notBefore[item.id] = nil
+        failures[item.id] = nil
+        if !items.contains(where: { $0.storedFileName == item.storedFileName }) {
+            try? FileManager.default.removeItem(at: filesURL.appendingPathComponent(item.storedFileName))
+        }
+    }
+
+    private func finish(_ completions: [Completion], with result: Result<APIResponse<OrderScans>, Error>) {
+        guard !completions.isEmpty else { return }
+        DispatchQueue.main.async {
+            completions.forEach { $0(result) }
+        }
+    }
+
+    private func announceFailure(of item: Item, reason: String) {
+        DispatchQueue.main.async {
+            NotificationCenter.default.post(name: .uploadFailed, object: item,
+                                            userInfo: [UploadQueue.failureReasonKey: reason])
+        }
+    }
+
+    /// A missing or expired session, which a new sign-in fixes.
+    private static func isAuthenticationFailure(_ error: Error) -> Bool {
+        guard let code = (error as? AFError)?.responseCode else { return false }
+        return code == 401 || code == 403
+    }
+
+    /// Other client errors, apart from timeouts and throttling, will not go away by retrying.
+    private static func isPermanent(_ error: Error) -> Bool {
+        guard let code = (error as? AFError)?.responseCode else { return false }
+        return (400..<500).contains(code) && code != 408 && code != 429
+    }
+
+    // MARK: Journal
+
+    /// Hard-links the file into the queue, or copies it across volumes.
+    private func store(_ fileURL: URL, as name: String) throws {
+        let target = filesURL.appendingPathComponent(name)
+        let fileManager = FileManager.default
+        guard !fileManager.fileExists(atPath: target.path) else { return }
+        do {
+            try fileManager.linkItem(at: fileURL, to: target)
+        } catch {
+            try fileManager.copyItem(at: fileURL, to: target)
+        }
+    }
+
+    /// Writes one record now and schedules the shared `fsync`. Must run on `queue`.
+    private func append(_ record: Record) {
+        guard let journal = journal, var line = try? JSONEncoder().encode(record) else { return }
+        line.append(0x0a)
+        do {
+            try journal.write(contentsOf: line)
+        } catch {
+            print("⚠️ Upload journal write failed: \(error.localizedDescription)")
+        }
+        guard !syncScheduled else { return }
+        syncScheduled = true
+        queue.asyncAfter(deadline: .now() + syncInterval) {
+            self.syncScheduled = false
+            try? self.journal?.synchronize()
+        }
+    }
+
+    /// Rebuilds the queue from the journal, then rewrites the journal with only what is
+    /// still needed. Must run on `queue`.
+    private func replay() {
+        let fileManager = FileManager.default
+        try? fileManager.createDirectory(at: filesURL, withIntermediateDirectories: true)
+
+        if let data = try? Data(contentsOf: journalURL) {
+            let decoder = JSONDecoder()
+            // A torn last line from a kill mid-write simply fails to decode.
+            for line in data.split(separator: 0x0a) {
+                guard let record = try? decoder.decode(Record.self, from: line) else { continue }
+                switch record.operation {
+                case .add:
+                    if let item = record.item { items.append(item) }
+                case .attempt:
+                    attempts[record.id, default: 0] += 1
+                case .failed:
+                    failures[record.id] = record.reason ?? ""
+                case .retry:
+                    failures[record.id] = nil
+                    attempts[record.id] = nil
+                case .done:
+                    items.removeAll { $0.id == record.id }
+                    attempts[record.id] = nil
+                    failures[record.id] = nil
+                    if let key = record.deduplicationKey { uploaded.insert(key) }
+                }
+            }
+        }
+        items.removeAll { !fileManager.fileExists(atPath: filesURL.appendingPathComponent($0.storedFileName).path) }
+        failures = failures.filter { id, _ in items.contains { $0.id == id } }
+        // Files linked in by an enqueue that never finished belong to no item.
+        let referenced = Set(items.map { $0.storedFileName })
+        for name in (try? fileManager.contentsOfDirectory(atPath: filesURL.path)) ?? [] where !referenced.contains(name) {
+            try? fileManager.removeItem(at: filesURL.appendingPathComponent(name))
+        }
+
+        // Compact: one add per pending item, one failed per refused item and one done per uploaded key.
+        var compacted = Data()
+        let encoder = JSONEncoder()
+        var records = items.map { Record(operation: .add, id: $0.id, item: $0) }
+        records += items.compactMap { item in
+            failures[item.id].map { Record(operation: .failed, id: item.id, reason: $0) }
+        }
+        records += uploaded.map { Record(operation: .done, id: UUID(), deduplicationKey: $0) }
+        for record in records {
+            if let line = try? encoder.encode(record) {
+                compacted.append(line)
+                compacted.append(0x0a)
+            }
+        }
+        for item in items {
+            for _ in 0..<(attempts[item.id] ?? 0) {
+                if let line = try? encoder.encode(Record(operation: .attempt, id: item.id)) {
+                    compacted.append(line)
+                    compacted.append(0x0a)
+                }
+            }
+        }
+        do {
+            try compacted.write(to: journalURL, options: .atomic)
+            journal = try FileHandle(forWritingTo: journalURL)
+            try journal?.seekToEnd()
+        } catch {
+            print("⚠️ Upload journal unavailable: \(error.localizedDescription)")
+        }
+    }
+}
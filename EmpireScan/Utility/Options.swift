@@ -18,6 +18,7 @@ enum OptionId: String {
 
   case holeFillingAlgo = "Hole Filling"
   case texturingAlgo = "Texturing"
+  case cutSupportPlane = "Cut Below Support Plane"
 
   case depthResolution = "Depth Resolution"
   case arKit = "Use ARKit (Beta)"
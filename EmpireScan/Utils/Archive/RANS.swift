@@ -0,0 +1,246 @@
+//
+//  RANS.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+
+/// Static order-0 rANS entropy coder for byte streams.
+///
+/// One frequency table is built for the whole stream, then the stream is cut into
+/// blocks that are encoded and decoded independently on all cores. Each block
+/// starts with its 32-bit coder state, so blocks can be decoded in any order.
+enum RANS {
+    static let probabilityBits: UInt32 = 12
+    static let probabilityScale = 1 << 12
+    /// Lower bound of the normalized coder state.
+    static let lowerBound: UInt32 = 1 << 23
+    /// Symbols per independently coded block.
+    static let blockSize = 128 * 1024
+
+    /// Frequencies scaled to `probabilityScale` and their cumulative starts.
+    private struct Model {
+        var frequencies = [UInt32](repeating: 0, count: 256)
+        var starts = [UInt32](repeating: 0, count: 256)
+
+        init(frequencies: [UInt32]) {
+            self.frequencies = frequencies
+            var start: UInt32 = 0
+            for symbol in 0..<256 {
+                starts[symbol] = start
+                start += frequencies[symbol]
+            }
+        }
+
+        /// Symbol for every slot of the probability range.
+        func slots() -> [UInt8] {
+            var slots = [UInt8](repeating: 0, count: RANS.probabilityScale)
+            for symbol in 0..<256 where frequencies[symbol] > 0 {
+                for slot in Int(starts[symbol])..<Int(starts[symbol] + frequencies[symbol]) {
+                    slots[slot] = UInt8(symbol)
+                }
+            }
+            return slots
+        }
+    }
+
+    /// Encodes `symbols` as a self-describing stream.
+    static func encode(_ symbols: [UInt8]) -> Data {
+        var output = Data()
+        output.appendLittleEndian(UInt32(symbols.count))
+        guard !symbols.isEmpty else { return output }
+
+        let model = Model(frequencies: normalized(histogram(symbols)))
+        let used = (0..<256).filter { model.frequencies[$0] > 0 }
+        output.appendLittleEndian(UInt16(used.count))
+        for symbol in used {
+            output.append(UInt8(symbol))
+            output.appendLittleEndian(UInt16(model.frequencies[symbol]))
+        }
+
+        let blockCount = (symbols.count + blockSize - 1) / blockSize
+        var blocks = [Data](repeating: Data(), count: blockCount)
+        symbols.withUnsafeBufferPointer { symbolBuffer in
+            blocks.withUnsafeMutableBufferPointer { blockBuffer in
+                let input = symbolBuffer
+                let out = blockBuffer
+                DispatchQueue.concurrentPerform(iterations: blockCount) { block in
+                    let lower = block * blockSize
+                    out[block] = encodeBlock(UnsafeBufferPointer(rebasing: input[lower..<min(input.count, lower + blockSize)]), model)
+                }
+            }
+        }
+        for block in blocks {
+            output.appendLittleEndian(UInt32(block.count))
+        }
+        for block in blocks {
+            output.append(block)
+        }
+        return output
+    }
+
+    /// Decodes the stream starting at `offset` and moves `offset` past it.
+    static func decode(_ data: Data, offset: inout Int) throws -> [UInt8] {
+        var reader = Reader(data: data, offset: offset)
+        let count = Int(try reader.uint32())
+        guard count > 0 else {
+            offset = reader.offset
+            return []
+        }
+
+        var frequencies = [UInt32](repeating: 0, count: 256)
+        let used = Int(try reader.uint16())
+        for _ in 0..<used {
+            let symbol = Int(try reader.uint8())
+            frequencies[symbol] = UInt32(try reader.uint16())
+        }
+        guard frequencies.reduce(0, +) == UInt32(probabilityScale) else {
+            throw error(1, "Invalid frequency table")
+        }
+        let model = Model(frequencies: frequencies)
+        let slots = model.slots()
+
+        let blockCount = (count + blockSize - 1) / blockSize
+        // Each block needs its length word and its 4-byte coder state.
+        guard blockCount * 8 <= data.count - reader.offset else { throw error(2, "The stream is truncated") }
+        var ranges: [Range<Int>] = []
+        let lengths = try (0..<blockCount).map { _ in Int(try reader.uint32()) }
+        var start = reader.offset
+        for length in lengths {
+            guard start + length <= data.count else { throw error(2, "The stream is truncated") }
+            ranges.append(start..<(start + length))
+            start += length
+        }
+        offset = start
+
+        var symbols = [UInt8](repeating: 0, count: count)
+        var failed = false
+        data.withUnsafeBytes { bytes in
+            symbols.withUnsafeMutableBufferPointer { symbolBuffer in
+                let out = symbolBuffer
+                let lock = NSLock()
+                DispatchQueue.concurrentPerform(iterations: blockCount) { block in
+                    let lower = block * blockSize
+                    let target = UnsafeMutableBufferPointer(rebasing: out[lower..<min(count, lower + blockSize)])
+                    if !decodeBlock(UnsafeRawBufferPointer(rebasing: bytes[ranges[block]]), model, slots, into: target) {
+                        lock.lock()
+                        failed = true
+                        lock.unlock()
+                    }
+                }
+            }
+        }
+        guard !failed else { throw error(2, "The stream is truncated") }
+        return symbols
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "RANS", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+
+    // MARK: Coding
+
+    private static func encodeBlock(_ symbols: UnsafeBufferPointer<UInt8>, _ model: Model) -> Data {
+        // rANS runs backwards: bytes are collected last-first and reversed at the end.
+        var reversed: [UInt8] = []
+        reversed.reserveCapacity(symbols.count / 2 + 8)
+        var state = lowerBound
+        for symbol in symbols.reversed() {
+            let frequency = model.frequencies[Int(symbol)]
+            let limit = ((lowerBound >> probabilityBits) << 8) * frequency
+            while state >= limit {
+                reversed.append(UInt8(truncatingIfNeeded: state))
+                state >>= 8
+            }
+            state = ((state / frequency) << probabilityBits) + state % frequency + model.starts[Int(symbol)]
+        }
+        for shift in stride(from: 24, through: 0, by: -8) {
+            reversed.append(UInt8(truncatingIfNeeded: state >> UInt32(shift)))
+        }
+        return Data(reversed.reversed())
+    }
+
+    private static func decodeBlock(_ bytes: UnsafeRawBufferPointer, _ model: Model, _ slots: [UInt8],
+                                    into symbols: UnsafeMutableBufferPointer<UInt8>) -> Bool {
+        guard bytes.count >= 4 else { return false }
+        var state = UInt32(bytes[0]) | UInt32(bytes[1]) << 8 | UInt32(bytes[2]) << 16 | UInt32(bytes[3]) << 24
+        var position = 4
+        let mask = UInt32(probabilityScale - 1)
+        for index in 0..<symbols.count {
+            let symbol = slots[Int(state & mask)]
+            symbols[index] = symbol
+            // Wrapping arithmetic: corrupt input must fail the length check, not trap.
+            state = model.frequencies[Int(symbol)] &* (state >> probabilityBits) &+ (state & mask) &- model.starts[Int(symbol)]
+            while state < lowerBound {
+                guard position < bytes.count else { return false }
+                state = state << 8 | UInt32(bytes[position])
+                position += 1
+            }
+        }
+        return true
+    }
+
+    private static func histogram(_ symbols: [UInt8]) -> [Int] {
+        var partials = [[Int]](repeating: [Int](repeating: 0, count: 256), count: Parallel.chunkCount(for: symbols.count, minChunk: 64 * 1024))
+        symbols.withUnsafeBufferPointer { symbolBuffer in
+            partials.withUnsafeMutableBufferPointer { partialBuffer in
+                let input = symbolBuffer
+                let out = partialBuffer
+                Parallel.forEachChunk(count: input.count, minChunk: 64 * 1024) { chunk, range in
+                    var counts = [Int](repeating: 0, count: 256)
+                    for index in range {
+                        counts[Int(input[index])] += 1
+                    }
+                    out[chunk] = counts
+                }
+            }
+        }
+        return partials.reduce(into: [Int](repeating: 0, count: 256)) { total, counts in
+            for symbol in 0..<256 { total[symbol] += counts[symbol] }
+        }
+    }
+
+    /// Scales counts to sum to `probabilityScale`, keeping every used symbol at least 1.
+    private static func normalized(_ counts: [Int]) -> [UInt32] {
+        let total = counts.reduce(0, +)
+        var frequencies = counts.map { count -> Int in
+            count == 0 ? 0 : max(1, count * probabilityScale / total)
+        }
+        var sum = frequencies.reduce(0, +)
+        while sum != probabilityScale {
+            // Adjust the largest symbol, where one unit costs the least precision.
+            let largest = frequencies.indices.max { frequencies[$0] < frequencies[$1] }!
+            if sum < probabilityScale {
+                frequencies[largest] += probabilityScale - sum
+                sum = probabilityScale
+            } else {
+                let excess = min(sum - probabilityScale, frequencies[largest] / 2)
+                frequencies[largest] -= excess
+                sum -= excess
+            }
+        }
+        return frequencies.map { UInt32($0) }
+    }
+
+    /// Bounds-checked little-endian reads.
+    private struct Reader {
+        let data: Data
+        var offset: Int
+
+        mutating func uint8() throws -> UInt8 {
+            guard offset + 1 <= data.count else { throw RANS.error(2, "The stream is truncated") }
+            defer { offset += 1 }
+            return data[data.startIndex + offset]
+        }
+
+        mutating func uint16() throws -> UInt16 {
+            UInt16(try uint8()) | UInt16(try uint8()) << 8
+        }
+
+        mutating func uint32() throws -> UInt32 {
+            UInt32(try uint16()) | UInt32(try uint16()) << 16
+        }
+    }
+}
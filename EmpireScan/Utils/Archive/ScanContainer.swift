@@ -0,0 +1,428 @@
+//
+//  ScanContainer.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+import zlib
+
+/// Single-file scan: geometry, preview and metadata in one indexed binary.
+///
+/// A 16-byte header is followed by a table of sections, each naming its tag, CRC,
+/// offset and length. Sections start on 16-byte boundaries, so a reader maps the
+/// file and touches only the sections it asks for: the preview can be shown
+/// without decoding any geometry. Geometry is stored with `MeshCodec` by default;
+/// without a codec, positions are quantized to 16 bits over the bounding box and
+/// indices are delta coded, and both are deflated.
+struct ScanContainer {
+    static let magic: UInt32 = 0x3143_5345 // "ESC1"
+    static let version: UInt32 = 1
+    static let headerSize = 16
+    static let sectionEntrySize = 24
+    static let alignment = 16
+
+    /// Four-character section tags.
+    enum Tag: UInt32, CaseIterable {
+        case metadata = 0x4154_454D  // "META"
+        case preview = 0x5645_5250   // "PREV"
+        case positions = 0x5153_4F50 // "POSQ"
+        case indices = 0x5844_4E49   // "INDX"
+        case colors = 0x524C_4F43    // "COLR"
+        case uvs = 0x3053_5655       // "UVS0"
+        case texture = 0x5258_4554   // "TEXR"
+        case mesh = 0x4344_434D      // "MCDC"
+    }
+
+    /// Scan details the server stores next to the file.
+    struct Metadata: Codable {
+        var orderId: Int?
+        var footType: String?
+        var scanType: String?
+        var createdAt = Date()
+        /// Length of one position unit, in metres.
+        var unit: Float = 1
+    }
+
+    struct Section {
+        let tag: UInt32
+        let crc: UInt32
+        let range: Range<Int>
+    }
+
+    let data: Data
+    let sections: [Section]
+
+    /// Maps the container at `url` and reads its section table.
+    init(url: URL) throws {
+        try self.init(data: Data(contentsOf: url, options: .alwaysMapped))
+    }
+
+    init(data: Data) throws {
+        guard data.count >= ScanContainer.headerSize,
+              data.uint32(at: 0) == ScanContainer.magic else {
+            throw ScanContainer.error(1, "Not a scan container")
+        }
+        guard data.uint32(at: 4) == ScanContainer.version else {
+            throw ScanContainer.error(2, "Unsupported scan container version")
+        }
+        let count = Int(data.uint32(at: 8))
+        guard ScanContainer.headerSize + count * ScanContainer.sectionEntrySize <= data.count else {
+            throw ScanContainer.error(3, "The section table is truncated")
+        }
+        sections = try (0..<count).map { slot in
+            let entry = ScanContainer.headerSize + slot * ScanContainer.sectionEntrySize
+            guard let offset = Int(exactly: data.uint64(at: entry + 8)),
+                  let length = Int(exactly: data.uint64(at: entry + 16)),
+                  offset <= data.count - length else {
+                throw ScanContainer.error(3, "A section lies outside the file")
+            }
+            return Section(tag: data.uint32(at: entry), crc: data.uint32(at: entry + 4), range: offset..<(offset + length))
+        }
+        self.data = data
+    }
+
+    /// True when the file at `url` starts with the container magic.
+    static func isContainer(_ url: URL) -> Bool {
+        guard let handle = try? FileHandle(forReadingFrom: url) else { return false }
+        defer { try? handle.close() }
+        guard let head = try? handle.read(upToCount: 4), head.count == 4 else { return false }
+        return head.uint32(at: 0) == magic
+    }
+
+    func section(_ tag: Tag) -> Section? {
+        sections.first { $0.tag == tag.rawValue }
+    }
+
+    /// Raw bytes of a section, checked against its CRC.
+    func bytes(of tag: Tag) throws -> Data? {
+        guard let section = section(tag) else { return nil }
+        let bytes = data.subdata(in: section.range)
+        guard ScanContainer.crc32(bytes) == section.crc else {
+            throw ScanContainer.error(4, "Section \(ScanContainer.name(of: tag.rawValue)) is corrupt")
+        }
+        return bytes
+    }
+
+    /// Embedded JPEG preview, read without touching the geometry.
+    func preview() throws -> Data? {
+        try bytes(of: .preview)
+    }
+
+    func metadata() throws -> Metadata? {
+        guard let bytes = try bytes(of: .metadata) else { return nil }
+        let decoder = JSONDecoder()
+        decoder.dateDecodingStrategy = .iso8601
+        return try decoder.decode(Metadata.self, from: bytes)
+    }
+
+    /// Texture image for `uvs`, when the scan has one.
+    func texture() throws -> Data? {
+        try bytes(of: .texture)
+    }
+
+    /// Decodes positions, indices and any colors or UVs.
+    func mesh() throws -> MeshBuffer {
+        var mesh: MeshBuffer
+        if let encoded = try bytes(of: .mesh) {
+            mesh = try MeshBuffer(MeshCodec.decode(encoded))
+        } else if let positions = try bytes(of: .positions), let indices = try bytes(of: .indices) {
+            mesh = MeshBuffer()
+            mesh.positions = try ScanContainer.decodePositions(ScanContainer.inflate(positions))
+            mesh.indices = try ScanContainer.decodeIndices(ScanContainer.inflate(indices), vertexCount: mesh.vertexCount)
+        } else {
+            throw ScanContainer.error(5, "The container has no geometry")
+        }
+        if let colors = try bytes(of: .colors) {
+            let raw = try ScanContainer.inflate(colors)
+            guard raw.count == mesh.vertexCount * 3 else {
+                throw ScanContainer.error(5, "Colors do not match the vertices")
+            }
+            let vertexCount = mesh.vertexCount
+            mesh.colors = raw.withUnsafeBytes { bytes in
+                (0..<vertexCount).map { SIMD3<Float>(Float(bytes[$0 * 3]), Float(bytes[$0 * 3 + 1]), Float(bytes[$0 * 3 + 2])) / 255 }
+            }
+        }
+        if let uvs = try bytes(of: .uvs) {
+            let raw = try ScanContainer.inflate(uvs)
+            guard raw.count == mesh.vertexCount * 4 else {
+                throw ScanContainer.error(5, "UVs do not match the vertices")
+            }
+            mesh.uvs = (0..<mesh.vertexCount).map {
+                SIMD2<Float>(Float(raw.uint16(at: $0 * 4)), Float(raw.uint16(at: $0 * 4 + 2))) / Float(UInt16.max)
+            }
+        }
+        return mesh
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "ScanContainer", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+
+    // MARK: Writing
+
+    /// Container bytes for `mesh`, its preview, texture and metadata. Sections are
+    /// encoded in parallel. Pass a nil `codec` to keep 16-bit positions instead of
+    /// the codec's grid.
+    static func encode(_ mesh: MeshBuffer, preview: Data? = nil, texture: Data? = nil, metadata: Metadata? = nil,
+                       codec: MeshCodec.Options? = MeshCodec.Options()) throws -> Data {
+        guard mesh.vertexCount <= Int(UInt32.max) else {
+            throw error(6, "The mesh is too large")
+        }
+        var jobs: [(Tag, () throws -> Data)] = []
+        var colors = mesh.colors
+        var uvs = mesh.uvs
+        if let codec = codec {
+            let encoded = try MeshCodec.encodeReordering(IndexedMesh(positions: mesh.positions, indices: mesh.indices), options: codec)
+            // Attributes follow the codec's vertex order.
+            if mesh.hasColors {
+                colors = encoded.order.map { colors[Int($0)] }
+            }
+            if mesh.hasUVs {
+                uvs = encoded.order.map { uvs[Int($0)] }
+            }
+            jobs.append((.mesh, { encoded.data }))
+        } else {
+            jobs.append((.positions, { try ScanContainer.deflate(ScanContainer.encodePositions(mesh.positions)) }))
+            jobs.append((.indices, { try ScanContainer.deflate(ScanContainer.encodeIndices(mesh.indices)) }))
+        }
+        if !colors.isEmpty {
+            jobs.append((.colors, { [colors] in
+                try ScanContainer.deflate(Data(colors.flatMap { color -> [UInt8] in
+                    let clamped = simd_clamp(color, .zero, .one) * 255
+                    return [UInt8(clamped.x.rounded()), UInt8(clamped.y.rounded()), UInt8(clamped.z.rounded())]
+                }))
+            }))
+        }
+        if !uvs.isEmpty {
+            jobs.append((.uvs, { [uvs] in
+                var raw = Data(capacity: uvs.count * 4)
+                for uv in uvs {
+                    let quantized = simd_clamp(uv, .zero, .one) * Float(UInt16.max)
+                    raw.appendLittleEndian(UInt16(quantized.x.rounded()))
+                    raw.appendLittleEndian(UInt16(quantized.y.rounded()))
+                }
+                return try ScanContainer.deflate(raw)
+            }))
+        }
+        if let metadata = metadata {
+            let encoder = JSONEncoder()
+            encoder.dateEncodingStrategy = .iso8601
+            let json = try encoder.encode(metadata)
+            jobs.append((.metadata, { json }))
+        }
+        if let preview = preview {
+            jobs.append((.preview, { preview }))
+        }
+        if let texture = texture {
+            jobs.append((.texture, { texture }))
+        }
+
+        var payloads = [Result<Data, Error>](repeating: .success(Data()), count: jobs.count)
+        let lock = NSLock()
+        DispatchQueue.concurrentPerform(iterations: jobs.count) { job in
+            let payload = Result { try jobs[job].1() }
+            lock.lock()
+            payloads[job] = payload
+            lock.unlock()
+        }
+
+        // Small sections first, so a reader after the preview maps as little as possible.
+        let order = [Tag.metadata, .preview, .mesh, .positions, .indices, .colors, .uvs, .texture]
+        let sorted = try jobs.indices
+            .sorted { order.firstIndex(of: jobs[$0].0)! < order.firstIndex(of: jobs[$1].0)! }
+            .map { (jobs[$0].0, try payloads[$0].get()) }
+
+        var offset = align(headerSize + sorted.count * sectionEntrySize)
+        var file = Data()
+        file.appendLittleEndian(magic)
+        file.appendLittleEndian(version)
+        file.appendLittleEndian(UInt32(sorted.count))
+        file.appendLittleEndian(UInt32(0))
+        for (tag, payload) in sorted {
+            file.appendLittleEndian(tag.rawValue)
+            file.appendLittleEndian(crc32(payload))
+            file.appendLittleEndian(UInt64(offset))
+            file.appendLittleEndian(UInt64(payload.count))
+            offset = align(offset + payload.count)
+        }
+        for (_, payload) in sorted {
+            file.count = align(file.count)
+            file.append(payload)
+        }
+        return file
+    }
+
+    static func write(_ mesh: MeshBuffer, preview: Data? = nil, texture: Data? = nil, metadata: Metadata? = nil,
+                      codec: MeshCodec.Options? = MeshCodec.Options(), to url: URL) throws {
+        try encode(mesh, preview: preview, texture: texture, metadata: metadata, codec: codec).write(to: url, options: .atomic)
+    }
+
+    /// Converts one of today's upload ZIPs (OBJ, STL and `Preview.jpg`) into a container.
+    /// Geometry is read from the STL entry and welded; the OBJ is redundant.
+    static func convert(zipAt zipURL: URL, to url: URL, metadata: Metadata? = nil) throws {
+        let archive = try ZipStreamReader(url: zipURL)
+        guard let stlEntry = archive.entry(withExtensions: ["stl"]) else {
+            throw error(7, "The archive has no STL mesh")
+        }
+        let (soup, _) = try STLFile(data: archive.data(for: stlEntry)).packedGeometry()
+        let mesh = MeshBuffer(MeshWelder.weld(soup: soup))
+        let preview = try archive.entry(withExtensions: ["jpg", "jpeg"]).map { try archive.data(for: $0) }
+        try write(mesh, preview: preview, metadata: metadata, to: url)
+    }
+
+    // MARK: Geometry coding
+
+    /// Bounding box origin and step, then per-axis planes of delta-coded 16-bit values.
+    /// Splitting the axes keeps similar bytes together for deflate.
+    private static func encodePositions(_ positions: [SIMD3<Float>]) -> Data {
+        var lower = SIMD3<Float>(repeating: .greatestFiniteMagnitude)
+        var upper = -lower
+        for position in positions {
+            lower = simd_min(lower, position)
+            upper = simd_max(upper, position)
+        }
+        if positions.isEmpty {
+            lower = .zero
+            upper = .zero
+        }
+        let step = simd_max((upper - lower) / Float(UInt16.max), SIMD3(repeating: .leastNormalMagnitude))
+
+        var raw = Data(capacity: 28 + positions.count * 6)
+        raw.appendLittleEndian(UInt32(positions.count))
+        for value in [lower.x, lower.y, lower.z, step.x, step.y, step.z] {
+            raw.appendLittleEndian(value.bitPattern)
+        }
+        for axis in 0..<3 {
+            var previous: UInt16 = 0
+            for position in positions {
+                let quantized = UInt16(min(Float(UInt16.max), ((position[axis] - lower[axis]) / step[axis]).rounded()))
+                raw.appendLittleEndian(quantized &- previous)
+                previous = quantized
+            }
+        }
+        return raw
+    }
+
+    private static func decodePositions(_ raw: Data) throws -> [SIMD3<Float>] {
+        guard raw.count >= 28 else { throw error(5, "Positions are truncated") }
+        let count = Int(raw.uint32(at: 0))
+        guard raw.count == 28 + count * 6 else { throw error(5, "Positions are truncated") }
+        let values = (0..<6).map { Float(bitPattern: raw.uint32(at: 4 + $0 * 4)) }
+        let lower = SIMD3(values[0], values[1], values[2])
+        let step = SIMD3(values[3], values[4], values[5])
+        var positions = [SIMD3<Float>](repeating: lower, count: count)
+        for axis in 0..<3 {
+            let plane = 28 + axis * count * 2
+            var value: UInt16 = 0
+            for vertex in 0..<count {
+                value = value &+ raw.uint16(at: plane + vertex * 2)
+                positions[vertex][axis] += Float(value) * step[axis]
+            }
+        }
+        return positions
+    }
+
+    /// Face count, then each index as a zigzag varint of its difference from the previous one.
+    private static func encodeIndices(_ indices: [UInt32]) -> Data {
+        var raw = Data(capacity: 4 + indices.count * 2)
+        raw.appendLittleEndian(UInt32(indices.count / 3))
+        var previous: Int64 = 0
+        for index in indices {
+            let delta = Int64(index) - previous
+            previous = Int64(index)
+            var zigzag = UInt64(bitPattern: (delta << 1) ^ (delta >> 63))
+            while zigzag >= 0x80 {
+                raw.append(UInt8(zigzag & 0x7f) | 0x80)
+                zigzag >>= 7
+            }
+            raw.append(UInt8(zigzag))
+        }
+        return raw
+    }
+
+    private static func decodeIndices(_ raw: Data, vertexCount: Int) throws -> [UInt32] {
+        guard raw.count >= 4 else { throw error(5, "Indices are truncated") }
+        let count = Int(raw.uint32(at: 0)) * 3
+        // Every index takes at least one byte.
+        guard count <= raw.count - 4 else { throw error(5, "Indices are truncated") }
+        var indices = [UInt32]()
+        indices.reserveCapacity(count)
+        try raw.withUnsafeBytes { bytes in
+            var offset = 4
+            var previous: Int64 = 0
+            for _ in 0..<count {
+                var zigzag: UInt64 = 0
+                var shift: UInt64 = 0
+                while true {
+                    guard offset < bytes.count, shift < 64 else { throw error(5, "Indices are truncated") }
+                    let byte = bytes[offset]
+                    offset += 1
+                    zigzag |= UInt64(byte & 0x7f) << shift
+                    shift += 7
+                    if byte < 0x80 { break }
+                }
+                previous += Int64(bitPattern: zigzag >> 1) ^ -Int64(bitPattern: zigzag & 1)
+                guard previous >= 0, previous < Int64(vertexCount) else {
+                    throw error(5, "An index is out of range")
+                }
+                indices.append(UInt32(previous))
+            }
+        }
+        return indices
+    }
+
+    // MARK: Helpers
+
+    private static func align(_ offset: Int) -> Int {
+        (offset + alignment - 1) / alignment * alignment
+    }
+
+    private static func name(of tag: UInt32) -> String {
+        String(decoding: withUnsafeBytes(of: tag.littleEndian) { Array($0) }, as: UTF8.self)
+    }
+
+    private static func crc32(_ data: Data) -> UInt32 {
+        data.withUnsafeBytes { bytes in
+            UInt32(zlib.crc32(0, bytes.bindMemory(to: Bytef.self).baseAddress, uInt(bytes.count)))
+        }
+    }
+
+    /// Uncompressed length, then a zlib stream.
+    private static func deflate(_ raw: Data) throws -> Data {
+        var capacity = compressBound(uLong(raw.count))
+        var output = Data(count: 8 + Int(capacity))
+        let status: Int32 = output.withUnsafeMutableBytes { outputBytes in
+            raw.withUnsafeBytes { input in
+                compress2(outputBytes.bindMemory(to: Bytef.self).baseAddress! + 8, &capacity,
+                          input.bindMemory(to: Bytef.self).baseAddress, uLong(raw.count), Z_DEFAULT_COMPRESSION)
+            }
+        }
+        guard status == Z_OK else { throw error(8, "Unable to compress a section") }
+        output.count = 8 + Int(capacity)
+        output.withUnsafeMutableBytes { $0.storeBytes(of: UInt64(raw.count).littleEndian, as: UInt64.self) }
+        return output
+    }
+
+    private static func inflate(_ packed: Data) throws -> Data {
+        guard packed.count >= 8 else { throw error(5, "A section is truncated") }
+        // zlib expands at most 1032:1, which bounds what an honest header can claim.
+        guard let count = Int(exactly: packed.uint64(at: 0)), count / 1032 <= packed.count - 8 else {
+            throw error(5, "A section is corrupt")
+        }
+        var length = uLong(count)
+        var output = Data(count: count)
+        let status: Int32 = output.withUnsafeMutableBytes { outputBytes in
+            packed.withUnsafeBytes { input in
+                uncompress(outputBytes.bindMemory(to: Bytef.self).baseAddress, &length,
+                           input.bindMemory(to: Bytef.self).baseAddress! + 8, uLong(packed.count - 8))
+            }
+        }
+        guard status == Z_OK, Int(length) == count else {
+            throw error(5, "A section is corrupt")
+        }
+        return output
+    }
+}
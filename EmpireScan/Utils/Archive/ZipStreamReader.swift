@@ -0,0 +1,209 @@
+//
+//  ZipStreamReader.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import zlib
+
+/// Reads single entries out of a ZIP archive without extracting the rest.
+///
+/// The archive is memory-mapped and only its central directory is parsed up front.
+/// An entry is inflated on request, either whole into memory, in chunks to a callback,
+/// or straight to a file. Separate entries can be read from different threads.
+final class ZipStreamReader {
+    struct Entry {
+        let name: String
+        let method: UInt16
+        let crc: UInt32
+        let compressedSize: Int
+        let uncompressedSize: Int
+        fileprivate let localHeaderOffset: Int
+
+        /// Last path component of the entry name.
+        var fileName: String { (name as NSString).lastPathComponent }
+        var pathExtension: String { (name as NSString).pathExtension.lowercased() }
+        var isDirectory: Bool { name.hasSuffix("/") }
+    }
+
+    /// Output bytes handed out per chunk while inflating.
+    static let chunkSize = 256 * 1024
+    /// Most bytes `data(for:)` reserves up front; larger entries grow as they inflate.
+    static let maxReservation = 64 * 1024 * 1024
+
+    let entries: [Entry]
+    private let data: Data
+
+    init(url: URL) throws {
+        data = try Data(contentsOf: url, options: .alwaysMapped)
+        entries = try ZipStreamReader.readCentralDirectory(data)
+    }
+
+    /// First entry whose file name matches `fileName`, ignoring case and folders.
+    func entry(named fileName: String) -> Entry? {
+        entries.first { !$0.isDirectory && $0.fileName.caseInsensitiveCompare(fileName) == .orderedSame }
+    }
+
+    /// First entry with one of `extensions`, preferring earlier extensions in the list.
+    func entry(withExtensions extensions: [String]) -> Entry? {
+        for pathExtension in extensions {
+            if let entry = entries.first(where: { !$0.isDirectory && $0.pathExtension == pathExtension }) {
+                return entry
+            }
+        }
+        return nil
+    }
+
+    /// The whole uncompressed payload of `entry`.
+    func data(for entry: Entry) throws -> Data {
+        var result = Data(capacity: min(entry.uncompressedSize, ZipStreamReader.maxReservation))
+        try read(entry) { result.append($0) }
+        return result
+    }
+
+    /// Inflates `entry` into `url`, replacing any existing file.
+    func extract(_ entry: Entry, to url: URL) throws {
+        let fileManager = FileManager.default
+        if fileManager.fileExists(atPath: url.path) {
+            try fileManager.removeItem(at: url)
+        }
+        guard fileManager.createFile(atPath: url.path, contents: nil) else {
+            throw ZipStreamReader.error(1, "Unable to create \(url.lastPathComponent)")
+        }
+        let handle = try FileHandle(forWritingTo: url)
+        defer { try? handle.close() }
+        try read(entry) { try handle.write(contentsOf: $0) }
+    }
+
+    /// Streams the uncompressed payload of `entry` to `body` in chunks and checks its CRC.
+    func read(_ entry: Entry, _ body: (Data) throws -> Void) throws {
+        let payload = try payloadRange(of: entry)
+        var crc: uLong = 0
+        var produced = 0
+        func checked(_ chunk: Data) throws {
+            produced += chunk.count
+            guard produced <= entry.uncompressedSize else {
+                throw ZipStreamReader.error(3, "\(entry.name) is corrupt")
+            }
+            crc = chunk.withUnsafeBytes { bytes in
+                zlib.crc32(crc, bytes.bindMemory(to: Bytef.self).baseAddress, uInt(bytes.count))
+            }
+            try body(chunk)
+        }
+
+        switch entry.method {
+        case 0:
+            var offset = payload.lowerBound
+            while offset < payload.upperBound {
+                let end = min(payload.upperBound, offset + ZipStreamReader.chunkSize)
+                try checked(data.subdata(in: offset..<end))
+                offset = end
+            }
+        case 8:
+            try inflate(payload, into: checked)
+        default:
+            throw ZipStreamReader.error(2, "\(entry.name) uses unsupported compression method \(entry.method)")
+        }
+        guard produced == entry.uncompressedSize, UInt32(crc) == entry.crc else {
+            throw ZipStreamReader.error(3, "\(entry.name) is corrupt")
+        }
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "ZipStreamReader", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+
+    /// Byte range of the stored payload, found through the entry's local header.
+    private func payloadRange(of entry: Entry) throws -> Range<Int> {
+        let header = entry.localHeaderOffset
+        guard header + 30 <= data.count, data.uint32(at: header) == 0x0403_4b50 else {
+            throw ZipStreamReader.error(4, "\(entry.name) has no local header")
+        }
+        let start = header + 30 + Int(data.uint16(at: header + 26)) + Int(data.uint16(at: header + 28))
+        guard start + entry.compressedSize <= data.count else {
+            throw ZipStreamReader.error(4, "\(entry.name) is truncated")
+        }
+        return start..<(start + entry.compressedSize)
+    }
+
+    private func inflate(_ payload: Range<Int>, into body: (Data) throws -> Void) throws {
+        var stream = z_stream()
+        guard inflateInit2_(&stream, -MAX_WBITS, ZLIB_VERSION, Int32(MemoryLayout<z_stream>.size)) == Z_OK else {
+            throw ZipStreamReader.error(5, "Unable to start decompression")
+        }
+        defer { inflateEnd(&stream) }
+
+        var output = Data(count: ZipStreamReader.chunkSize)
+        try data.withUnsafeBytes { archive in
+            stream.next_in = UnsafeMutablePointer(mutating: archive.bindMemory(to: Bytef.self).baseAddress! + payload.lowerBound)
+            stream.avail_in = uInt(payload.count)
+            var status = Z_OK
+            while status != Z_STREAM_END {
+                let produced: Int = output.withUnsafeMutableBytes { outputBytes in
+                    stream.next_out = outputBytes.bindMemory(to: Bytef.self).baseAddress
+                    stream.avail_out = uInt(outputBytes.count)
+                    status = zlib.inflate(&stream, Z_NO_FLUSH)
+                    return outputBytes.count - Int(stream.avail_out)
+                }
+                guard status == Z_OK || status == Z_STREAM_END, produced > 0 || status == Z_STREAM_END else {
+                    throw ZipStreamReader.error(5, "Compressed data is corrupt")
+                }
+                if produced > 0 {
+                    try body(output.prefix(produced))
+                }
+            }
+        }
+    }
+
+    private static func readCentralDirectory(_ data: Data) throws -> [Entry] {
+        // The end record sits in the last 22 bytes plus an optional comment of up to 64 KB.
+        let lowest = max(0, data.count - 22 - Int(UInt16.max))
+        var end = data.count - 22
+        while end >= lowest, data.uint32(at: end) != 0x0605_4b50 {
+            end -= 1
+        }
+        guard end >= lowest else {
+            throw error(6, "Not a ZIP archive")
+        }
+        let count = Int(data.uint16(at: end + 10))
+        let directorySize = Int(data.uint32(at: end + 12))
+        var offset = Int(data.uint32(at: end + 16))
+        guard offset != Int(UInt32.max), offset + directorySize <= end else {
+            throw error(7, "ZIP64 archives are not supported")
+        }
+
+        var entries: [Entry] = []
+        entries.reserveCapacity(count)
+        for _ in 0..<count {
+            guard offset + 46 <= end, data.uint32(at: offset) == 0x0201_4b50 else {
+                throw error(8, "The central directory is corrupt")
+            }
+            let nameLength = Int(data.uint16(at: offset + 28))
+            let extraLength = Int(data.uint16(at: offset + 30))
+            let commentLength = Int(data.uint16(at: offset + 32))
+            let nameStart = offset + 46
+            guard nameStart + nameLength <= end else {
+                throw error(8, "The central directory is corrupt")
+            }
+            let method = data.uint16(at: offset + 10)
+            let compressedSize = Int(data.uint32(at: offset + 20))
+            let uncompressedSize = Int(data.uint32(at: offset + 24))
+            // Deflate expands at most 1032:1 and stored entries not at all, which bounds
+            // what an honest directory can claim.
+            guard method != 0 || uncompressedSize == compressedSize,
+                  method != 8 || uncompressedSize / 1032 <= compressedSize else {
+                throw error(8, "The central directory is corrupt")
+            }
+            entries.append(Entry(name: String(decoding: data[nameStart..<(nameStart + nameLength)], as: UTF8.self),
+                                 method: method,
+                                 crc: data.uint32(at: offset + 16),
+                                 compressedSize: compressedSize,
+                                 uncompressedSize: uncompressedSize,
+                                 localHeaderOffset: Int(data.uint32(at: offset + 42))))
+            offset = nameStart + nameLength + extraLength + commentLength
+        }
+        return entries
+    }
+}
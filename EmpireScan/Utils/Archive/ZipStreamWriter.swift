@@ -0,0 +1,385 @@
+//
+//  ZipStreamWriter.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import zlib
+
+/// Writes a ZIP archive front to back while the entries are still being produced.
+///
+/// Each entry is a producer that hands its bytes to `emit` in any number of pieces.
+/// The bytes are cut into fixed blocks and a batch of blocks is deflated in parallel,
+/// the way pigz does it: every block is primed with the last 32 KB of the block before
+/// it and ends on a sync flush, so the pieces join into one ordinary deflate stream.
+/// Sizes and CRCs of deflated entries follow them in a data descriptor, so nothing is
+/// ever rewound and the output can be a plain file or any other sink. Stored entries
+/// carry theirs in the local header instead, since streaming readers such as Java's
+/// `ZipInputStream` cannot find the end of a stored entry from a descriptor.
+final class ZipStreamWriter {
+    typealias Sink = (Data) throws -> Void
+    typealias Emit = (Data) throws -> Void
+    typealias Producer = (_ emit: Emit) throws -> Void
+
+    enum Method: UInt16 {
+        case stored = 0
+        case deflated = 8
+    }
+
+    /// Uncompressed bytes per parallel deflate block.
+    static let blockSize = 128 * 1024
+    /// Bytes of history each block takes from its predecessor.
+    static let dictionarySize = 32 * 1024
+
+    /// Total bytes handed to the sink so far.
+    private(set) var bytesWritten = 0
+
+    private let sink: Sink
+    private let level: Int32
+    private var handle: FileHandle?
+    private var entries: [CentralEntry] = []
+    private var finished = false
+
+    /// Archive written through `sink`, e.g. straight into an upload body.
+    init(sink: @escaping Sink, level: Int32 = Z_DEFAULT_COMPRESSION) {
+        self.sink = sink
+        self.level = level
+    }
+
+    /// Archive written to `url`, replacing any existing file.
+    convenience init(url: URL, level: Int32 = Z_DEFAULT_COMPRESSION) throws {
+        let fileManager = FileManager.default
+        if fileManager.fileExists(atPath: url.path) {
+            try fileManager.removeItem(at: url)
+        }
+        guard fileManager.createFile(atPath: url.path, contents: nil) else {
+            throw ZipStreamWriter.error(1, "Unable to create \(url.lastPathComponent)")
+        }
+        let handle = try FileHandle(forWritingTo: url)
+        self.init(sink: { try handle.write(contentsOf: $0) }, level: level)
+        self.handle = handle
+    }
+
+    deinit {
+        try? handle?.close()
+    }
+
+    /// Adds one entry whose bytes come from `producer`, which runs on the calling thread.
+    /// Stored entries are collected in memory first so their header can carry the size.
+    func addEntry(_ name: String, method: Method = .deflated, modificationDate: Date = Date(), producer: Producer) throws {
+        guard method == .deflated else {
+            var data = Data()
+            try producer { data.append($0) }
+            try addEntry(name, data: data, modificationDate: modificationDate)
+            return
+        }
+        guard !finished else { throw ZipStreamWriter.error(2, "The archive is already finished") }
+        var entry = try beginEntry(name, method: method, flags: ZipStreamWriter.utf8Flag | ZipStreamWriter.descriptorFlag,
+                                   modificationDate: modificationDate)
+        // CRC and sizes follow in the data descriptor.
+        try writeLocalHeader(entry)
+
+        var stream = EntryStream(method: method, level: level)
+        try producer { data in
+            try stream.append(data, to: self)
+        }
+        try stream.finish(to: self)
+        entry.crc = stream.crc
+        entry.compressedSize = stream.compressedSize
+        entry.uncompressedSize = stream.uncompressedSize
+        guard entry.compressedSize <= Int(UInt32.max), entry.uncompressedSize <= Int(UInt32.max) else {
+            throw ZipStreamWriter.error(3, "\(name) is too large for a ZIP archive without ZIP64")
+        }
+
+        var descriptor = Data(capacity: 16)
+        descriptor.appendLittleEndian(UInt32(0x0807_4b50))
+        descriptor.appendLittleEndian(entry.crc)
+        descriptor.appendLittleEndian(UInt32(entry.compressedSize))
+        descriptor.appendLittleEndian(UInt32(entry.uncompressedSize))
+        try write(descriptor)
+        entries.append(entry)
+    }
+
+    /// Adds `data` stored as is, with its CRC and size in the local header.
+    func addEntry(_ name: String, data: Data, modificationDate: Date = Date()) throws {
+        let crc = data.withUnsafeBytes { ZipStreamWriter.crc32(0, $0) }
+        try addStoredEntry(name, size: data.count, crc: crc, modificationDate: modificationDate) { emit in
+            try emit(data)
+        }
+    }
+
+    /// Adds the contents of `fileURL`, read in blocks so it is never held in memory whole.
+    /// A stored file is read twice, first for the CRC its header needs.
+    func addEntry(_ name: String, fileURL: URL, method: Method = .deflated) throws {
+        let attributes = try FileManager.default.attributesOfItem(atPath: fileURL.path)
+        let modificationDate = attributes[.modificationDate] as? Date ?? Date()
+        func readBlocks(_ emit: Emit) throws {
+            let handle = try FileHandle(forReadingFrom: fileURL)
+            defer { try? handle.close() }
+            while let data = try handle.read(upToCount: ZipStreamWriter.blockSize), !data.isEmpty {
+                try emit(data)
+            }
+        }
+        guard method == .deflated else {
+            var crc: UInt32 = 0
+            var size = 0
+            try readBlocks { data in
+                crc = data.withUnsafeBytes { ZipStreamWriter.crc32(crc, $0) }
+                size += data.count
+            }
+            try addStoredEntry(name, size: size, crc: crc, modificationDate: modificationDate, producer: readBlocks)
+            return
+        }
+        try addEntry(name, method: method, modificationDate: modificationDate, producer: readBlocks)
+    }
+
+    /// Stored entry of known size and CRC, without a data descriptor.
+    private func addStoredEntry(_ name: String, size: Int, crc: UInt32, modificationDate: Date, producer: Producer) throws {
+        guard !finished else { throw ZipStreamWriter.error(2, "The archive is already finished") }
+        guard size <= Int(UInt32.max) else {
+            throw ZipStreamWriter.error(3, "\(name) is too large for a ZIP archive without ZIP64")
+        }
+        var entry = try beginEntry(name, method: .stored, flags: ZipStreamWriter.utf8Flag, modificationDate: modificationDate)
+        entry.crc = crc
+        entry.compressedSize = size
+        entry.uncompressedSize = size
+        try writeLocalHeader(entry)
+        var written = 0
+        try producer { data in
+            written += data.count
+            try self.write(data)
+        }
+        guard written == size else {
+            throw ZipStreamWriter.error(5, "\(name) changed while it was being added")
+        }
+        entries.append(entry)
+    }
+
+    private func beginEntry(_ name: String, method: Method, flags: UInt16, modificationDate: Date) throws -> CentralEntry {
+        let (time, date) = ZipStreamWriter.dosDateTime(modificationDate)
+        let entry = CentralEntry(name: Array(name.utf8), method: method, flags: flags, time: time, date: date, offset: bytesWritten)
+        try checkOffset(entry.offset)
+        return entry
+    }
+
+    /// Local file header; CRC and sizes are zero when a data descriptor follows.
+    private func writeLocalHeader(_ entry: CentralEntry) throws {
+        let hasDescriptor = entry.flags & ZipStreamWriter.descriptorFlag != 0
+        var header = Data(capacity: 30 + entry.name.count)
+        header.appendLittleEndian(UInt32(0x0403_4b50))
+        header.appendLittleEndian(UInt16(20))
+        header.appendLittleEndian(entry.flags)
+        header.appendLittleEndian(entry.method.rawValue)
+        header.appendLittleEndian(entry.time)
+        header.appendLittleEndian(entry.date)
+        header.appendLittleEndian(hasDescriptor ? 0 : entry.crc)
+        header.appendLittleEndian(hasDescriptor ? 0 : UInt32(entry.compressedSize))
+        header.appendLittleEndian(hasDescriptor ? 0 : UInt32(entry.uncompressedSize))
+        header.appendLittleEndian(UInt16(entry.name.count))
+        header.appendLittleEndian(UInt16(0))
+        header.append(contentsOf: entry.name)
+        try write(header)
+    }
+
+    /// Writes the central directory. The archive is complete once this returns.
+    func finish() throws {
+        guard !finished else { return }
+        finished = true
+        let directoryOffset = bytesWritten
+        try checkOffset(directoryOffset)
+        var directory = Data()
+        for entry in entries {
+            directory.appendLittleEndian(UInt32(0x0201_4b50))
+            directory.appendLittleEndian(UInt16(0x031e)) // Made by Unix, spec 3.0.
+            directory.appendLittleEndian(UInt16(20))
+            directory.appendLittleEndian(entry.flags)
+            directory.appendLittleEndian(entry.method.rawValue)
+            directory.appendLittleEndian(entry.time)
+            directory.appendLittleEndian(entry.date)
+            directory.appendLittleEndian(entry.crc)
+            directory.appendLittleEndian(UInt32(entry.compressedSize))
+            directory.appendLittleEndian(UInt32(entry.uncompressedSize))
+            directory.appendLittleEndian(UInt16(entry.name.count))
+            directory.appendLittleEndian(UInt16(0))
+            directory.appendLittleEndian(UInt16(0))
+            directory.appendLittleEndian(UInt16(0))
+            directory.appendLittleEndian(UInt16(0))
+            directory.appendLittleEndian(UInt32(0o100644) << 16)
+            directory.appendLittleEndian(UInt32(entry.offset))
+            directory.append(contentsOf: entry.name)
+        }
+        guard entries.count <= Int(UInt16.max) else {
+            throw ZipStreamWriter.error(3, "Too many entries for a ZIP archive without ZIP64")
+        }
+        let directorySize = directory.count
+        directory.appendLittleEndian(UInt32(0x0605_4b50))
+        directory.appendLittleEndian(UInt16(0))
+        directory.appendLittleEndian(UInt16(0))
+        directory.appendLittleEndian(UInt16(entries.count))
+        directory.appendLittleEndian(UInt16(entries.count))
+        directory.appendLittleEndian(UInt32(directorySize))
+        directory.appendLittleEndian(UInt32(directoryOffset))
+        directory.appendLittleEndian(UInt16(0))
+        try write(directory)
+        try handle?.synchronize()
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "ZipStreamWriter", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+
+    /// Sizes and CRC follow the entry in a data descriptor.
+    private static let descriptorFlag: UInt16 = 1 << 3
+    /// Names are UTF-8.
+    private static let utf8Flag: UInt16 = 1 << 11
+
+    fileprivate func write(_ data: Data) throws {
+        try sink(data)
+        bytesWritten += data.count
+    }
+
+    private func checkOffset(_ offset: Int) throws {
+        guard offset <= Int(UInt32.max) else {
+            throw ZipStreamWriter.error(3, "The archive is too large without ZIP64")
+        }
+    }
+
+    private static func dosDateTime(_ date: Date) -> (time: UInt16, date: UInt16) {
+        let parts = Calendar(identifier: .gregorian).dateComponents([.year, .month, .day, .hour, .minute, .second], from: date)
+        let year = max(0, (parts.year ?? 1980) - 1980)
+        let time = (parts.hour ?? 0) << 11 | (parts.minute ?? 0) << 5 | (parts.second ?? 0) / 2
+        let day = year << 9 | (parts.month ?? 1) << 5 | (parts.day ?? 1)
+        return (UInt16(truncatingIfNeeded: time), UInt16(truncatingIfNeeded: day))
+    }
+
+    private struct CentralEntry {
+        let name: [UInt8]
+        let method: Method
+        let flags: UInt16
+        let time: UInt16
+        let date: UInt16
+        let offset: Int
+        var crc: UInt32 = 0
+        var compressedSize = 0
+        var uncompressedSize = 0
+    }
+
+    /// Buffers one entry's bytes into blocks and writes them out compressed, in order.
+    private struct EntryStream {
+        let method: Method
+        let level: Int32
+        var crc: UInt32 = 0
+        var compressedSize = 0
+        var uncompressedSize = 0
+
+        private var pending = Data()
+        private var batch: [Data] = []
+        private var history = Data()
+
+        init(method: Method, level: Int32) {
+            self.method = method
+            self.level = level
+        }
+
+        /// Enough blocks in flight to keep every core busy without buffering the whole entry.
+        private var batchSize: Int { Parallel.coreCount * 2 }
+
+        mutating func append(_ data: Data, to writer: ZipStreamWriter) throws {
+            uncompressedSize += data.count
+            guard method == .deflated else {
+                crc = data.withUnsafeBytes { ZipStreamWriter.crc32(crc, $0) }
+                compressedSize += data.count
+                try writer.write(data)
+                return
+            }
+            pending.append(data)
+            while pending.count >= ZipStreamWriter.blockSize {
+                batch.append(pending.prefix(ZipStreamWriter.blockSize))
+                pending = pending.dropFirst(ZipStreamWriter.blockSize)
+                if batch.count == batchSize {
+                    try flush(last: false, to: writer)
+                }
+            }
+        }
+
+        mutating func finish(to writer: ZipStreamWriter) throws {
+            guard method == .deflated else { return }
+            // The tail, possibly empty, closes the stream with the final block.
+            batch.append(pending)
+            pending = Data()
+            try flush(last: true, to: writer)
+        }
+
+        /// Deflates and checksums the batch in parallel, then writes it in order.
+        private mutating func flush(last: Bool, to writer: ZipStreamWriter) throws {
+            let blocks = batch.map { Data($0) }
+            let level = self.level
+            var dictionaries = [history]
+            for block in blocks.dropLast() {
+                dictionaries.append(Data(block.suffix(ZipStreamWriter.dictionarySize)))
+            }
+            let primers = dictionaries
+            var results = [(data: Data, crc: UInt32)?](repeating: nil, count: blocks.count)
+            results.withUnsafeMutableBufferPointer { resultBuffer in
+                let out = resultBuffer
+                DispatchQueue.concurrentPerform(iterations: blocks.count) { index in
+                    let isLast = last && index == blocks.count - 1
+                    out[index] = blocks[index].withUnsafeBytes { input in
+                        primers[index].withUnsafeBytes { dictionary in
+                            ZipStreamWriter.deflate(input, dictionary: dictionary, finish: isLast, level: level)
+                                .map { ($0, ZipStreamWriter.crc32(0, input)) }
+                        }
+                    }
+                }
+            }
+            for (block, result) in zip(blocks, results) {
+                guard let (data, blockCRC) = result else {
+                    throw ZipStreamWriter.error(4, "Compression failed")
+                }
+                crc = UInt32(crc32_combine(uLong(crc), uLong(blockCRC), z_off_t(block.count)))
+                compressedSize += data.count
+                try writer.write(data)
+            }
+            if let lastBlock = blocks.last {
+                history = lastBlock.count >= ZipStreamWriter.dictionarySize
+                    ? Data(lastBlock.suffix(ZipStreamWriter.dictionarySize))
+                    : Data((history + lastBlock).suffix(ZipStreamWriter.dictionarySize))
+            }
+            batch.removeAll(keepingCapacity: true)
+        }
+    }
+
+    fileprivate static func crc32(_ crc: UInt32, _ bytes: UnsafeRawBufferPointer) -> UInt32 {
+        guard let base = bytes.bindMemory(to: Bytef.self).baseAddress, !bytes.isEmpty else { return crc }
+        return UInt32(zlib.crc32(uLong(crc), base, uInt(bytes.count)))
+    }
+
+    /// One raw deflate block: primed with `dictionary`, ended by a sync flush or, for the
+    /// last block of an entry, by the final block marker.
+    fileprivate static func deflate(_ input: UnsafeRawBufferPointer, dictionary: UnsafeRawBufferPointer,
+                                    finish: Bool, level: Int32) -> Data? {
+        var stream = z_stream()
+        guard deflateInit2_(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY,
+                            ZLIB_VERSION, Int32(MemoryLayout<z_stream>.size)) == Z_OK else { return nil }
+        defer { deflateEnd(&stream) }
+        if let base = dictionary.bindMemory(to: Bytef.self).baseAddress, !dictionary.isEmpty {
+            guard deflateSetDictionary(&stream, base, uInt(dictionary.count)) == Z_OK else { return nil }
+        }
+
+        // deflateBound covers the final block; the sync marker needs a few more bytes.
+        let capacity = Int(deflateBound(&stream, uLong(input.count))) + 16
+        var output = Data(count: capacity)
+        let status: Int32 = output.withUnsafeMutableBytes { outputBytes in
+            stream.next_in = UnsafeMutablePointer(mutating: input.bindMemory(to: Bytef.self).baseAddress)
+            stream.avail_in = uInt(input.count)
+            stream.next_out = outputBytes.bindMemory(to: Bytef.self).baseAddress
+            stream.avail_out = uInt(capacity)
+            return zlib.deflate(&stream, finish ? Z_FINISH : Z_SYNC_FLUSH)
+        }
+        guard status == (finish ? Z_STREAM_END : Z_OK), stream.avail_in == 0 else { return nil }
+        output.count = capacity - Int(stream.avail_out)
+        return output
+    }
+}
@@ -5,9 +5,20 @@
 //  Created by MacOK on 14/04/2025.
 //
 import Foundation
-import ZIPFoundation
 
-func downloadAndExtractPreview(from urlString: String, identifier: String = UUID().uuidString, completion: @escaping (URL?, URL?,URL?) -> Void) {
+/// Fetches a scan archive through `ScanCache` and pulls out only what the profile screen shows.
+///
+/// `Preview.jpg` is inflated first and handed to `onPreview` as soon as it is on disk;
+/// the mesh and STL entries follow, inflated concurrently. Nothing else in the archive
+/// is extracted, and entries already pulled out of the same archive are reused, so
+/// revisiting a patient costs neither a download nor an unzip. Scans this app uploaded
+/// were already cut by the mapper, so only rescan and legacy-scan imports should pass
+/// `cutSupportPlane`: it cuts the floor off the returned STL, while the mesh stays the
+/// untouched, colored original. Both callbacks run on the main queue.
+func downloadAndExtractPreview(from urlString: String, identifier: String = UUID().uuidString,
+                               cutSupportPlane: Bool = false,
+                               onPreview: ((URL?) -> Void)? = nil,
+                               completion: @escaping (URL?, URL?,URL?) -> Void) {
     print("📥 downloadAndExtractPreview from: \(urlString), identifier: \(identifier)")
     
     guard let url = URL(string: urlString) else {
@@ -15,141 +26,124 @@ func downloadAndExtractPreview(from urlString: String, identifier: String = UUID
         completion(nil, nil,nil)
         return
     }
-    
-    let fileName = url.lastPathComponent
-    let destinationURL = FileManager.default.temporaryDirectory.appendingPathComponent("\(identifier)_\(fileName)")
-    let fileManager = FileManager.default
 
-    // Ensure no file exists at the destination path
-    if fileManager.fileExists(atPath: destinationURL.path) {
+    ScanCache.shared.archive(for: url) { result in
+        let object: ScanCache.Object
+        let archive: ZipStreamReader
         do {
-            try fileManager.removeItem(at: destinationURL)
-            print("🗑️ Removed existing file: \(destinationURL.path)")
+            object = try result.get()
+            if ScanContainer.isContainer(object.archiveURL) {
+                openScanContainer(object, cutSupportPlane: cutSupportPlane, onPreview: onPreview, completion: completion)
+                return
+            }
+            archive = try ZipStreamReader(url: object.archiveURL)
+            print("📦 Cached archive \(object.hash): \(archive.entries.map { $0.name })")
         } catch {
-            print("⚠️ Error removing existing file: \(error)")
-        }
-    }
-
-    print("⏬ Starting download from: \(urlString)")
-    URLSession.shared.downloadTask(with: url) { tempURL, response, error in
-        guard let tempURL = tempURL, error == nil else {
-            print("❌ Download failed: \(error?.localizedDescription ?? "Unknown error")")
+            print("❌ Processing failed: \(error)")
             DispatchQueue.main.async {
+                onPreview?(nil)
                 completion(nil, nil,nil)
             }
             return
         }
-        
-        print("✅ Download completed to temp URL: \(tempURL.path)")
 
-        // Remove any existing file at the destination before moving
-        if fileManager.fileExists(atPath: destinationURL.path) {
+        // Entries are kept flat under their file names, whatever folder they sit in.
+        func extract(_ entry: ZipStreamReader.Entry?) -> URL? {
+            guard let entry = entry else { return nil }
             do {
-                try fileManager.removeItem(at: destinationURL)
-                print("🗑️ Removed existing destination file: \(destinationURL.path)")
+                return try ScanCache.shared.file(entry.fileName, in: object) { try archive.extract(entry, to: $0) }
             } catch {
-                print("⚠️ Error removing existing file at destination: \(error)")
+                print("❌ Error extracting \(entry.name): \(error)")
+                return nil
             }
         }
 
-        do {
-            try fileManager.moveItem(at: tempURL, to: destinationURL)
-            print("📦 Moved file to: \(destinationURL.path)")
-            
-            // Create unique extraction directory using the identifier
-            let extractURL = fileManager.temporaryDirectory.appendingPathComponent("unzipped_\(identifier)")
-
-            if fileManager.fileExists(atPath: extractURL.path) {
-                try fileManager.removeItem(at: extractURL)
-                print("🗑️ Removed existing extract directory")
+        // Preview first, so the profile can show it while the meshes inflate.
+        let previewImageURL = extract(archive.entry(named: "Preview.jpg"))
+        if let onPreview = onPreview {
+            DispatchQueue.main.async {
+                onPreview(previewImageURL)
             }
+        }
 
-            try fileManager.createDirectory(at: extractURL, withIntermediateDirectories: true)
-            print("📁 Created extraction directory: \(extractURL.path)")
-            
-            // Extract the main zip file
-            do {
-                try fileManager.unzipItem(at: destinationURL, to: extractURL)
-                
-                let attributes = try? fileManager.attributesOfItem(atPath: destinationURL.path)
-                let fileSize = attributes?[.size] as? Int64 ?? 0
-                print("ZIP file size: \(fileSize) bytes")
-                print("📦 Successfully unzipped main file")
-            } catch let zipError {
-                print("❌ Error unzipping main file: \(zipError)")
-                DispatchQueue.main.async {
-                    completion(nil, nil,nil)
-                }
-                return
+        let meshEntry = archive.entry(withExtensions: ["obj", "ply", "stl"])
+        let stlEntry = archive.entry(withExtensions: ["stl"])
+        let entries = meshEntry?.name == stlEntry?.name ? [meshEntry] : [meshEntry, stlEntry]
+        var extracted = [URL?](repeating: nil, count: entries.count)
+        extracted.withUnsafeMutableBufferPointer { extractedBuffer in
+            let out = extractedBuffer
+            DispatchQueue.concurrentPerform(iterations: entries.count) { index in
+                out[index] = extract(entries[index])
             }
+        }
+        let meshFileURL = extracted[0]
+        var stlFileURL = stlEntry == nil ? nil : extracted[extracted.count - 1]
+        if cutSupportPlane, let stlURL = stlFileURL, let trimmedURL = supportTrimmedSTL(stlURL, in: object) {
+            stlFileURL = trimmedURL
+        }
+        print("stlFileURL",stlFileURL)
+        // Returning the result
+        DispatchQueue.main.async {
+            completion(previewImageURL, meshFileURL,stlFileURL)
+        }
+    }
+}
 
-            // Look for Preview.jpg
-            let previewImageURL = extractURL.appendingPathComponent("Preview.jpg")
-            var meshFileURL: URL?
-            var stlFileURL: URL?
 
-            // Get contents of extracted directory
-            let contents = try fileManager.contentsOfDirectory(at: extractURL, includingPropertiesForKeys: nil)
-            print("📂 Directory contents: \(contents.map { $0.lastPathComponent })")
-            
-            // Look for mesh files recursively
-            func findMeshFiles(in directory: URL,meshExtensions:[String]) -> URL? {
-                
-                do {
-                    let contents = try fileManager.contentsOfDirectory(at: directory, includingPropertiesForKeys: nil)
-                    
-                    // First check for mesh files
-                    for file in contents {
-                        if meshExtensions.contains(file.pathExtension.lowercased()) {
-                            return file
-                        }
-                    }
-                    
-                    // Then check subdirectories
-                    for file in contents {
-                        var isDir: ObjCBool = false
-                        fileManager.fileExists(atPath: file.path, isDirectory: &isDir)
-                        if isDir.boolValue {
-                            if let meshURL = findMeshFiles(in: file, meshExtensions: meshExtensions) {
-                                return meshURL
-                            }
-                        }
-                    }
-                } catch {
-                    print("❌ Error searching directory: \(error)")
-                }
-                return nil
-            }
-                        
-            // If still no mesh found, try the main directory
-            if meshFileURL == nil {
-                let meshExtensions = ["obj", "ply", "stl"]
-                meshFileURL = findMeshFiles(in: extractURL, meshExtensions: meshExtensions)
-            }
-            
-            if stlFileURL == nil {
-                let meshExtensions = ["stl"]
-                stlFileURL = findMeshFiles(in: extractURL, meshExtensions: meshExtensions)
-            }
-            print("stlFileURL",stlFileURL)
-            // Returning the result
-            DispatchQueue.main.async {
-                completion(
-                    fileManager.fileExists(atPath: previewImageURL.path) ? previewImageURL : nil,
-                    meshFileURL,stlFileURL
-                )
-            }
+/// Same results for a `ScanContainer`: the preview is copied out of its section and
+/// the geometry is decoded once into a cached STL, which serves as the mesh and, unless
+/// `cutSupportPlane` asks for a trimmed copy, as the STL too.
+private func openScanContainer(_ object: ScanCache.Object, cutSupportPlane: Bool, onPreview: ((URL?) -> Void)?,
+                               completion: @escaping (URL?, URL?, URL?) -> Void) {
+    let container = try? ScanContainer(url: object.archiveURL)
+    var previewImageURL: URL?
+    do {
+        if let preview = try container?.preview() {
+            previewImageURL = try ScanCache.shared.file("Preview.jpg", in: object) { try preview.write(to: $0) }
+        }
+    } catch {
+        print("❌ Error reading container preview: \(error)")
+    }
+    if let onPreview = onPreview {
+        DispatchQueue.main.async {
+            onPreview(previewImageURL)
+        }
+    }
 
-        } catch {
-            print("❌ Processing failed: \(error)")
-            DispatchQueue.main.async {
-                completion(nil, nil,nil)
+    var meshFileURL: URL?
+    do {
+        if let container = container {
+            meshFileURL = try ScanCache.shared.file("Model.stl", in: object) {
+                try MeshExporter.write(try container.mesh(), to: [.binarySTL: $0], options: MeshExporter.Options(xRightYUp: false))
             }
         }
-    }.resume()
+    } catch {
+        print("❌ Error decoding container mesh: \(error)")
+    }
+    var stlFileURL = meshFileURL
+    if cutSupportPlane, let meshURL = meshFileURL, let trimmedURL = supportTrimmedSTL(meshURL, in: object) {
+        stlFileURL = trimmedURL
+    }
+    DispatchQueue.main.async {
+        completion(previewImageURL, meshFileURL, stlFileURL)
+    }
 }
 
-
+/// The STL at `stlURL` welded and with its support plane cut away, built once per
+/// archive. Scans without a clear support come back welded but otherwise unchanged.
+private func supportTrimmedSTL(_ stlURL: URL, in object: ScanCache.Object) -> URL? {
+    do {
+        return try ScanCache.shared.file("Trimmed_" + stlURL.lastPathComponent, in: object) { url in
+            let (soup, _) = try STLFile(url: stlURL).packedGeometry()
+            var mesh = MeshBuffer(MeshWelder.weld(soup: soup))
+            SupportPlane.removeSupport(from: &mesh)
+            try MeshExporter.write(mesh, to: [.binarySTL: url], options: MeshExporter.Options(xRightYUp: false))
+        }
+    } catch {
+        print("❌ Error cutting the support plane: \(error)")
+        return nil
+    }
+}
 
 //func downloadAndExtractPreview(from urlString: String, identifier: String = UUID().uuidString, completion: @escaping (URL?, URL?) -> Void) {
 //    print("📥 downloadAndExtractPreview from: \(urlString), identifier: \(identifier)")
@@ -0,0 +1,247 @@
+//
+//  GLBWriter.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Writes a `MeshBuffer` as binary glTF 2.0 (GLB).
+///
+/// By default attributes are stored as small integers under `KHR_mesh_quantization`:
+/// 16-bit positions mapped back to metres by the node transform, 8-bit normals and
+/// colors and 16-bit texture coordinates. Triangles and vertices are ordered with
+/// `MeshOrdering` first, so the file draws and streams well as loaded. A JPEG
+/// texture is embedded as the base color map, otherwise vertex colors are used.
+/// Positions are written as given; glTF expects Y up.
+enum GLBWriter {
+    struct Options {
+        /// Stores attributes as integers under `KHR_mesh_quantization`.
+        var quantize = true
+        /// Applies `MeshOrdering.optimized` before writing.
+        var optimizeOrder = true
+    }
+
+    private static let magic: UInt32 = 0x4654_6C67     // "glTF"
+    private static let jsonChunk: UInt32 = 0x4E4F_534A // "JSON"
+    private static let binaryChunk: UInt32 = 0x004E_4942 // "BIN\0"
+
+    private enum ComponentType: Int {
+        case byte = 5120
+        case unsignedByte = 5121
+        case short = 5122
+        case unsignedShort = 5123
+        case unsignedInt = 5125
+        case float = 5126
+    }
+
+    /// GLB bytes for `mesh`, with `texture` (JPEG) applied through its UVs.
+    static func encode(_ mesh: MeshBuffer, texture: Data? = nil, options: Options = Options()) throws -> Data {
+        guard mesh.vertexCount > 0, mesh.faceCount > 0 else {
+            throw error(1, "The mesh is empty")
+        }
+        var mesh = options.optimizeOrder ? MeshOrdering.optimized(mesh) : mesh
+        if !mesh.hasNormals {
+            mesh.normals = IndexedMesh(positions: mesh.positions, indices: mesh.indices).vertexNormals()
+        }
+        let texture = mesh.hasUVs ? texture : nil
+
+        var buffer = Buffer()
+        var attributes: [String: Int] = [:]
+        var node: [String: Any] = ["mesh": 0]
+
+        var lower = SIMD3<Float>(repeating: .greatestFiniteMagnitude)
+        var upper = -lower
+        for position in mesh.positions {
+            lower = simd_min(lower, position)
+            upper = simd_max(upper, position)
+        }
+        guard lower.x.isFinite, upper.x.isFinite, lower.y.isFinite, upper.y.isFinite, lower.z.isFinite, upper.z.isFinite else {
+            throw error(2, "The mesh has invalid positions")
+        }
+
+        if options.quantize {
+            // One uniform step keeps normals valid without a non-uniform normal matrix.
+            let center = (lower + upper) / 2
+            let step = max((upper - lower).max() / 2, .leastNormalMagnitude) / Float(Int16.max)
+            func quantize(_ position: SIMD3<Float>) -> SIMD3<Float> {
+                simd_clamp(((position - center) / step).rounded(.toNearestOrAwayFromZero), SIMD3(repeating: -32767), SIMD3(repeating: 32767))
+            }
+            let quantized = packed(mesh.positions, width: 4) { (position: SIMD3<Float>, out: UnsafeMutablePointer<Int16>) in
+                let value = quantize(position)
+                out[0] = Int16(value.x)
+                out[1] = Int16(value.y)
+                out[2] = Int16(value.z)
+            }
+            let minimum = quantize(lower)
+            let maximum = quantize(upper)
+            attributes["POSITION"] = buffer.addAccessor(quantized, stride: 8, component: .short, type: "VEC3",
+                                                        count: mesh.vertexCount,
+                                                        min: [minimum.x, minimum.y, minimum.z], max: [maximum.x, maximum.y, maximum.z])
+            node["translation"] = [center.x, center.y, center.z]
+            node["scale"] = [step, step, step]
+
+            let normals = packed(mesh.normals, width: 4) { (normal: SIMD3<Float>, out: UnsafeMutablePointer<Int8>) in
+                let value = (simd_clamp(normal, SIMD3(repeating: -1), SIMD3(repeating: 1)) * 127).rounded(.toNearestOrAwayFromZero)
+                out[0] = Int8(value.x)
+                out[1] = Int8(value.y)
+                out[2] = Int8(value.z)
+            }
+            attributes["NORMAL"] = buffer.addAccessor(normals, stride: 4, component: .byte, normalized: true,
+                                                      type: "VEC3", count: mesh.vertexCount)
+            if texture != nil {
+                let uvs = packed(mesh.uvs, width: 2) { (uv: SIMD2<Float>, out: UnsafeMutablePointer<UInt16>) in
+                    let value = (simd_clamp(SIMD2(uv.x, 1 - uv.y), .zero, .one) * Float(UInt16.max)).rounded(.toNearestOrAwayFromZero)
+                    out[0] = UInt16(value.x)
+                    out[1] = UInt16(value.y)
+                }
+                attributes["TEXCOORD_0"] = buffer.addAccessor(uvs, component: .unsignedShort, normalized: true,
+                                                              type: "VEC2", count: mesh.vertexCount)
+            }
+        } else {
+            let positions = packed(mesh.positions, width: 3) { (position: SIMD3<Float>, out: UnsafeMutablePointer<Float>) in
+                out[0] = position.x
+                out[1] = position.y
+                out[2] = position.z
+            }
+            attributes["POSITION"] = buffer.addAccessor(positions, component: .float, type: "VEC3", count: mesh.vertexCount,
+                                                        min: [lower.x, lower.y, lower.z], max: [upper.x, upper.y, upper.z])
+            let normals = packed(mesh.normals, width: 3) { (normal: SIMD3<Float>, out: UnsafeMutablePointer<Float>) in
+                out[0] = normal.x
+                out[1] = normal.y
+                out[2] = normal.z
+            }
+            attributes["NORMAL"] = buffer.addAccessor(normals, component: .float, type: "VEC3", count: mesh.vertexCount)
+            if texture != nil {
+                let uvs = packed(mesh.uvs, width: 2) { (uv: SIMD2<Float>, out: UnsafeMutablePointer<Float>) in
+                    out[0] = uv.x
+                    out[1] = 1 - uv.y
+                }
+                attributes["TEXCOORD_0"] = buffer.addAccessor(uvs, component: .float, type: "VEC2", count: mesh.vertexCount)
+            }
+        }
+
+        // Vertex colors are 8-bit in both modes; core glTF allows normalized bytes.
+        if texture == nil, mesh.hasColors {
+            let colors = packed(mesh.colors, width: 4) { (color: SIMD3<Float>, out: UnsafeMutablePointer<UInt8>) in
+                let value = (simd_clamp(color, .zero, .one) * 255).rounded(.toNearestOrAwayFromZero)
+                out[0] = UInt8(value.x)
+                out[1] = UInt8(value.y)
+                out[2] = UInt8(value.z)
+            }
+            attributes["COLOR_0"] = buffer.addAccessor(colors, stride: 4, component: .unsignedByte, normalized: true,
+                                                       type: "VEC3", count: mesh.vertexCount)
+        }
+
+        let indexAccessor: Int
+        if mesh.vertexCount <= Int(UInt16.max) {
+            indexAccessor = buffer.addAccessor(mesh.indices.map { UInt16($0) }, component: .unsignedShort, type: "SCALAR",
+                                               count: mesh.indices.count, target: 34963)
+        } else {
+            indexAccessor = buffer.addAccessor(mesh.indices, component: .unsignedInt, type: "SCALAR",
+                                               count: mesh.indices.count, target: 34963)
+        }
+
+        var material: [String: Any] = ["metallicFactor": 0, "roughnessFactor": 1]
+        var json: [String: Any] = [
+            "asset": ["version": "2.0", "generator": "EmpireScan"],
+            "scene": 0,
+            "scenes": [["nodes": [0]]],
+            "nodes": [node],
+            "meshes": [["primitives": [["attributes": attributes, "indices": indexAccessor, "material": 0, "mode": 4]]]]
+        ]
+        if let texture = texture {
+            let view = buffer.addView(texture)
+            json["images"] = [["bufferView": view, "mimeType": "image/jpeg"]]
+            json["samplers"] = [["magFilter": 9729, "minFilter": 9987, "wrapS": 33071, "wrapT": 33071]]
+            json["textures"] = [["source": 0, "sampler": 0]]
+            material["baseColorTexture"] = ["index": 0]
+        }
+        json["materials"] = [["pbrMetallicRoughness": material, "doubleSided": true]]
+        if options.quantize {
+            json["extensionsUsed"] = ["KHR_mesh_quantization"]
+            json["extensionsRequired"] = ["KHR_mesh_quantization"]
+        }
+        json["accessors"] = buffer.accessors
+        json["bufferViews"] = buffer.views
+        json["buffers"] = [["byteLength": buffer.data.count]]
+
+        var jsonData = try JSONSerialization.data(withJSONObject: json, options: [.sortedKeys])
+        jsonData.append(contentsOf: [UInt8](repeating: 0x20, count: (4 - jsonData.count % 4) % 4))
+        var binary = buffer.data
+        binary.append(contentsOf: [UInt8](repeating: 0, count: (4 - binary.count % 4) % 4))
+
+        var glb = Data(capacity: 28 + jsonData.count + binary.count)
+        glb.appendLittleEndian(magic)
+        glb.appendLittleEndian(UInt32(2))
+        glb.appendLittleEndian(UInt32(28 + jsonData.count + binary.count))
+        glb.appendLittleEndian(UInt32(jsonData.count))
+        glb.appendLittleEndian(jsonChunk)
+        glb.append(jsonData)
+        glb.appendLittleEndian(UInt32(binary.count))
+        glb.appendLittleEndian(binaryChunk)
+        glb.append(binary)
+        return glb
+    }
+
+    static func write(_ mesh: MeshBuffer, texture: Data? = nil, options: Options = Options(), to url: URL) throws {
+        try encode(mesh, texture: texture, options: options).write(to: url, options: .atomic)
+    }
+
+    /// GLB for the scan in `container`, with its texture when it has one.
+    static func encode(_ container: ScanContainer, options: Options = Options()) throws -> Data {
+        try encode(container.mesh(), texture: container.texture(), options: options)
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "GLBWriter", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+
+    /// Flattens one attribute into `width` zero-filled components per element, in parallel.
+    private static func packed<Element, Component: Numeric>(_ elements: [Element], width: Int,
+                                                            _ pack: (Element, UnsafeMutablePointer<Component>) -> Void) -> [Component] {
+        var components = [Component](repeating: 0, count: elements.count * width)
+        components.withUnsafeMutableBufferPointer { componentBuffer in
+            guard let base = componentBuffer.baseAddress else { return }
+            Parallel.forEachChunk(count: elements.count) { _, range in
+                for element in range {
+                    pack(elements[element], base + element * width)
+                }
+            }
+        }
+        return components
+    }
+
+    /// The binary chunk and the views and accessors into it.
+    private struct Buffer {
+        var data = Data()
+        var views: [[String: Any]] = []
+        var accessors: [[String: Any]] = []
+
+        /// Appends `bytes` on a 4-byte boundary and returns the view index.
+        mutating func addView(_ bytes: Data, stride: Int? = nil, target: Int? = nil) -> Int {
+            data.append(contentsOf: [UInt8](repeating: 0, count: (4 - data.count % 4) % 4))
+            var view: [String: Any] = ["buffer": 0, "byteOffset": data.count, "byteLength": bytes.count]
+            if let stride = stride { view["byteStride"] = stride }
+            if let target = target { view["target"] = target }
+            data.append(bytes)
+            views.append(view)
+            return views.count - 1
+        }
+
+        mutating func addAccessor<Component>(_ components: [Component], stride: Int? = nil, component: ComponentType,
+                                             normalized: Bool = false, type: String, count: Int,
+                                             min: [Float]? = nil, max: [Float]? = nil, target: Int = 34962) -> Int {
+            let bytes = components.withUnsafeBufferPointer { Data(buffer: $0) }
+            let view = addView(bytes, stride: stride, target: target)
+            var accessor: [String: Any] = ["bufferView": view, "componentType": component.rawValue, "count": count, "type": type]
+            if normalized { accessor["normalized"] = true }
+            if let min = min { accessor["min"] = min }
+            if let max = max { accessor["max"] = max }
+            accessors.append(accessor)
+            return accessors.count - 1
+        }
+    }
+}
@@ -0,0 +1,218 @@
+//
+//  MarchingCubes.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Iso-surface extraction from a dense scalar grid, parallel over z-slabs.
+///
+/// Corner `c` of a cell sits at offset `(c & 1, (c >> 1) & 1, (c >> 2) & 1)`. The triangle
+/// table resolves ambiguous faces by always separating the inside corners, a rule that
+/// depends only on the face, so neighbouring cells agree and the output is watertight.
+/// Triangles are wound counter-clockwise seen from the outside.
+enum MarchingCubes {
+    /// Corner pair of each of the 12 cell edges: four along x, then y, then z.
+    static let edgeCorners: [(Int, Int)] = [
+        (0, 1), (2, 3), (4, 5), (6, 7),
+        (0, 2), (1, 3), (4, 6), (5, 7),
+        (0, 4), (1, 5), (2, 6), (3, 7)
+    ]
+
+    /// Edge triples of the triangles for each inside-corner bitmask.
+    static let triangleTable: [[UInt8]] = [
+[], [0, 4, 8], [0, 9, 5], [8, 9, 5, 4, 8, 5],
+        [1, 10, 4], [1, 10, 8, 0, 1, 8], [0, 9, 5, 1, 10, 4], [8, 9, 5, 10, 8, 5, 1, 10, 5],
+        [1, 5, 11], [0, 4, 8, 1, 5, 11], [9, 11, 1, 0, 9, 1], [4, 8, 9, 4, 9, 11, 1, 4, 11],
+        [5, 11, 10, 4, 5, 10], [5, 11, 10, 5, 10, 8, 0, 5, 8], [11, 10, 4, 9, 11, 4, 0, 9, 4], [9, 11, 10, 8, 9, 10],
+        [2, 8, 6], [4, 6, 2, 0, 4, 2], [0, 9, 5, 2, 8, 6], [9, 5, 4, 9, 4, 6, 2, 9, 6],
+        [1, 10, 4, 2, 8, 6], [0, 1, 10, 10, 6, 2, 0, 10, 2], [0, 9, 5, 1, 10, 4, 2, 8, 6], [10, 6, 2, 2, 9, 5, 10, 2, 5, 1, 10, 5],
+        [1, 5, 11, 2, 8, 6], [4, 6, 2, 0, 4, 2, 1, 5, 11], [9, 11, 1, 0, 9, 1, 2, 8, 6], [2, 9, 11, 6, 2, 11, 4, 6, 11, 1, 4, 11],
+        [2, 8, 6, 5, 11, 10, 4, 5, 10], [10, 6, 2, 11, 10, 2, 5, 11, 2, 0, 5, 2], [11, 10, 4, 9, 11, 4, 0, 9, 4, 2, 8, 6], [11, 10, 6, 9, 11, 6, 2, 9, 6],
+        [2, 7, 9], [0, 4, 8, 2, 7, 9], [2, 7, 5, 0, 2, 5], [5, 4, 8, 7, 5, 8, 2, 7, 8],
+        [1, 10, 4, 2, 7, 9], [1, 10, 8, 0, 1, 8, 2, 7, 9], [2, 7, 5, 0, 2, 5, 1, 10, 4], [2, 7, 5, 8, 2, 5, 10, 8, 5, 1, 10, 5],
+        [1, 5, 11, 2, 7, 9], [0, 4, 8, 1, 5, 11, 2, 7, 9], [0, 2, 7, 7, 11, 1, 0, 7, 1], [4, 8, 2, 2, 7, 11, 4, 2, 11, 1, 4, 11],
+        [2, 7, 9, 5, 11, 10, 4, 5, 10], [5, 11, 10, 5, 10, 8, 0, 5, 8, 2, 7, 9], [2, 7, 11, 11, 10, 4, 2, 11, 4, 0, 2, 4], [7, 11, 10, 7, 10, 8, 2, 7, 8],
+        [7, 9, 8, 6, 7, 8], [6, 7, 9, 4, 6, 9, 0, 4, 9], [8, 6, 7, 8, 7, 5, 0, 8, 5], [6, 7, 5, 4, 6, 5],
+        [1, 10, 4, 7, 9, 8, 6, 7, 8], [1, 10, 6, 6, 7, 9, 1, 6, 9, 0, 1, 9], [8, 6, 7, 8, 7, 5, 0, 8, 5, 1, 10, 4], [10, 6, 7, 10, 7, 5, 1, 10, 5],
+        [1, 5, 11, 7, 9, 8, 6, 7, 8], [6, 7, 9, 4, 6, 9, 0, 4, 9, 1, 5, 11], [7, 11, 1, 6, 7, 1, 8, 6, 1, 0, 8, 1], [6, 7, 11, 4, 6, 11, 1, 4, 11],
+        [5, 11, 10, 4, 5, 10, 7, 9, 8, 6, 7, 8], [0, 5, 11, 11, 10, 6, 0, 11, 6, 6, 7, 9, 0, 6, 9], [0, 8, 6, 6, 7, 11, 0, 6, 11, 11, 10, 4, 0, 11, 4], [7, 11, 10, 6, 7, 10],
+        [3, 6, 10], [0, 4, 8, 3, 6, 10], [0, 9, 5, 3, 6, 10], [3, 6, 10, 8, 9, 5, 4, 8, 5],
+        [3, 6, 4, 1, 3, 4], [3, 6, 8, 1, 3, 8, 0, 1, 8], [0, 9, 5, 3, 6, 4, 1, 3, 4], [3, 6, 8, 8, 9, 5, 3, 8, 5, 1, 3, 5],
+        [1, 5, 11, 3, 6, 10], [0, 4, 8, 1, 5, 11, 3, 6, 10], [9, 11, 1, 0, 9, 1, 3, 6, 10], [4, 8, 9, 4, 9, 11, 1, 4, 11, 3, 6, 10],
+        [4, 5, 11, 6, 4, 11, 3, 6, 11], [5, 11, 3, 3, 6, 8, 5, 3, 8, 0, 5, 8], [3, 6, 4, 11, 3, 4, 9, 11, 4, 0, 9, 4], [6, 8, 9, 6, 9, 11, 3, 6, 11],
+        [8, 10, 3, 2, 8, 3], [10, 3, 2, 4, 10, 2, 0, 4, 2], [0, 9, 5, 8, 10, 3, 2, 8, 3], [4, 10, 3, 5, 4, 3, 9, 5, 3, 2, 9, 3],
+        [2, 8, 4, 3, 2, 4, 1, 3, 4], [1, 3, 2, 0, 1, 2], [0, 9, 5, 2, 8, 4, 3, 2, 4, 1, 3, 4], [2, 9, 5, 3, 2, 5, 1, 3, 5],
+        [1, 5, 11, 8, 10, 3, 2, 8, 3], [10, 3, 2, 4, 10, 2, 0, 4, 2, 1, 5, 11], [9, 11, 1, 0, 9, 1, 8, 10, 3, 2, 8, 3], [10, 3, 2, 4, 10, 2, 2, 9, 11, 4, 2, 11, 1, 4, 11],
+        [5, 11, 3, 4, 5, 3, 8, 4, 3, 2, 8, 3], [11, 3, 2, 5, 11, 2, 0, 5, 2], [2, 8, 4, 3, 2, 4, 11, 3, 4, 9, 11, 4, 0, 9, 4], [9, 11, 3, 2, 9, 3],
+        [2, 7, 9, 3, 6, 10], [0, 4, 8, 2, 7, 9, 3, 6, 10], [2, 7, 5, 0, 2, 5, 3, 6, 10], [5, 4, 8, 7, 5, 8, 2, 7, 8, 3, 6, 10],
+        [3, 6, 4, 1, 3, 4, 2, 7, 9], [3, 6, 8, 1, 3, 8, 0, 1, 8, 2, 7, 9], [2, 7, 5, 0, 2, 5, 3, 6, 4, 1, 3, 4], [3, 6, 8, 2, 7, 5, 8, 2, 5, 3, 8, 5, 1, 3, 5],
+        [1, 5, 11, 2, 7, 9, 3, 6, 10], [0, 4, 8, 1, 5, 11, 2, 7, 9, 3, 6, 10], [0, 2, 7, 7, 11, 1, 0, 7, 1, 3, 6, 10], [4, 8, 2, 2, 7, 11, 4, 2, 11, 1, 4, 11, 3, 6, 10],
+        [2, 7, 9, 4, 5, 11, 6, 4, 11, 3, 6, 11], [5, 11, 3, 3, 6, 8, 5, 3, 8, 0, 5, 8, 2, 7, 9], [2, 7, 11, 3, 6, 4, 11, 3, 4, 2, 11, 4, 0, 2, 4], [2, 7, 11, 3, 6, 8, 11, 3, 8, 2, 11, 8],
+        [7, 9, 8, 7, 8, 10, 3, 7, 10], [4, 10, 3, 3, 7, 9, 4, 3, 9, 0, 4, 9], [3, 7, 5, 10, 3, 5, 8, 10, 5, 0, 8, 5], [5, 4, 10, 7, 5, 10, 3, 7, 10],
+        [3, 7, 9, 9, 8, 4, 3, 9, 4, 1, 3, 4], [3, 7, 9, 1, 3, 9, 0, 1, 9], [4, 1, 3, 8, 4, 3, 3, 7, 5, 8, 3, 5, 0, 8, 5], [3, 7, 5, 1, 3, 5],
+        [1, 5, 11, 7, 9, 8, 7, 8, 10, 3, 7, 10], [4, 10, 3, 3, 7, 9, 4, 3, 9, 0, 4, 9, 1, 5, 11], [10, 3, 7, 8, 10, 7, 7, 11, 1, 8, 7, 1, 0, 8, 1], [10, 3, 7, 4, 10, 7, 4, 7, 11, 1, 4, 11],
+        [3, 7, 9, 9, 8, 4, 3, 9, 4, 4, 5, 11, 3, 4, 11], [5, 11, 3, 0, 5, 3, 3, 7, 9, 0, 3, 9], [0, 8, 4, 3, 7, 11], [3, 7, 11],
+        [3, 11, 7], [0, 4, 8, 3, 11, 7], [0, 9, 5, 3, 11, 7], [3, 11, 7, 8, 9, 5, 4, 8, 5],
+        [1, 10, 4, 3, 11, 7], [1, 10, 8, 0, 1, 8, 3, 11, 7], [0, 9, 5, 1, 10, 4, 3, 11, 7], [8, 9, 5, 10, 8, 5, 1, 10, 5, 3, 11, 7],
+        [5, 7, 3, 1, 5, 3], [0, 4, 8, 5, 7, 3, 1, 5, 3], [7, 3, 1, 9, 7, 1, 0, 9, 1], [9, 7, 3, 8, 9, 3, 4, 8, 3, 1, 4, 3],
+        [10, 4, 5, 10, 5, 7, 3, 10, 7], [3, 10, 8, 7, 3, 8, 5, 7, 8, 0, 5, 8], [9, 7, 3, 3, 10, 4, 9, 3, 4, 0, 9, 4], [8, 9, 7, 10, 8, 7, 3, 10, 7],
+        [2, 8, 6, 3, 11, 7], [4, 6, 2, 0, 4, 2, 3, 11, 7], [0, 9, 5, 2, 8, 6, 3, 11, 7], [9, 5, 4, 9, 4, 6, 2, 9, 6, 3, 11, 7],
+        [1, 10, 4, 2, 8, 6, 3, 11, 7], [0, 1, 10, 10, 6, 2, 0, 10, 2, 3, 11, 7], [0, 9, 5, 1, 10, 4, 2, 8, 6, 3, 11, 7], [10, 6, 2, 2, 9, 5, 10, 2, 5, 1, 10, 5, 3, 11, 7],
+        [5, 7, 3, 1, 5, 3, 2, 8, 6], [4, 6, 2, 0, 4, 2, 5, 7, 3, 1, 5, 3], [7, 3, 1, 9, 7, 1, 0, 9, 1, 2, 8, 6], [6, 2, 9, 4, 6, 9, 9, 7, 3, 4, 9, 3, 1, 4, 3],
+        [2, 8, 6, 10, 4, 5, 10, 5, 7, 3, 10, 7], [7, 3, 10, 5, 7, 10, 10, 6, 2, 5, 10, 2, 0, 5, 2], [9, 7, 3, 3, 10, 4, 9, 3, 4, 0, 9, 4, 2, 8, 6], [7, 3, 10, 9, 7, 10, 9, 10, 6, 2, 9, 6],
+        [3, 11, 9, 2, 3, 9], [0, 4, 8, 3, 11, 9, 2, 3, 9], [3, 11, 5, 2, 3, 5, 0, 2, 5], [3, 11, 5, 5, 4, 8, 3, 5, 8, 2, 3, 8],
+        [1, 10, 4, 3, 11, 9, 2, 3, 9], [1, 10, 8, 0, 1, 8, 3, 11, 9, 2, 3, 9], [3, 11, 5, 2, 3, 5, 0, 2, 5, 1, 10, 4], [3, 11, 5, 2, 3, 5, 8, 2, 5, 10, 8, 5, 1, 10, 5],
+        [9, 2, 3, 5, 9, 3, 1, 5, 3], [0, 4, 8, 9, 2, 3, 5, 9, 3, 1, 5, 3], [2, 3, 1, 0, 2, 1], [8, 2, 3, 4, 8, 3, 1, 4, 3],
+        [3, 10, 4, 4, 5, 9, 3, 4, 9, 2, 3, 9], [9, 2, 3, 5, 9, 3, 3, 10, 8, 5, 3, 8, 0, 5, 8], [3, 10, 4, 2, 3, 4, 0, 2, 4], [3, 10, 8, 2, 3, 8],
+        [9, 8, 6, 11, 9, 6, 3, 11, 6], [3, 11, 9, 6, 3, 9, 4, 6, 9, 0, 4, 9], [8, 6, 3, 3, 11, 5, 8, 3, 5, 0, 8, 5], [11, 5, 4, 11, 4, 6, 3, 11, 6],
+        [1, 10, 4, 9, 8, 6, 11, 9, 6, 3, 11, 6], [1, 10, 6, 3, 11, 9, 6, 3, 9, 1, 6, 9, 0, 1, 9], [8, 6, 3, 3, 11, 5, 8, 3, 5, 0, 8, 5, 1, 10, 4], [1, 10, 6, 3, 11, 5, 6, 3, 5, 1, 6, 5],
+        [8, 6, 3, 9, 8, 3, 5, 9, 3, 1, 5, 3], [1, 5, 9, 3, 1, 9, 6, 3, 9, 4, 6, 9, 0, 4, 9], [6, 3, 1, 8, 6, 1, 0, 8, 1], [4, 6, 3, 1, 4, 3],
+        [3, 10, 4, 4, 5, 9, 3, 4, 9, 9, 8, 6, 3, 9, 6], [0, 5, 9, 3, 10, 6], [8, 6, 3, 0, 8, 3, 3, 10, 4, 0, 3, 4], [3, 10, 6],
+        [10, 11, 7, 6, 10, 7], [0, 4, 8, 10, 11, 7, 6, 10, 7], [0, 9, 5, 10, 11, 7, 6, 10, 7], [8, 9, 5, 4, 8, 5, 10, 11, 7, 6, 10, 7],
+        [11, 7, 6, 11, 6, 4, 1, 11, 4], [1, 11, 7, 7, 6, 8, 1, 7, 8, 0, 1, 8], [0, 9, 5, 11, 7, 6, 11, 6, 4, 1, 11, 4], [1, 11, 7, 7, 6, 8, 1, 7, 8, 8, 9, 5, 1, 8, 5],
+        [7, 6, 10, 5, 7, 10, 1, 5, 10], [0, 4, 8, 7, 6, 10, 5, 7, 10, 1, 5, 10], [6, 10, 1, 7, 6, 1, 9, 7, 1, 0, 9, 1], [1, 4, 8, 8, 9, 7, 1, 8, 7, 7, 6, 10, 1, 7, 10],
+        [5, 7, 6, 4, 5, 6], [7, 6, 8, 5, 7, 8, 0, 5, 8], [9, 7, 6, 9, 6, 4, 0, 9, 4], [8, 9, 7, 6, 8, 7],
+        [10, 11, 7, 8, 10, 7, 2, 8, 7], [11, 7, 2, 10, 11, 2, 4, 10, 2, 0, 4, 2], [0, 9, 5, 10, 11, 7, 8, 10, 7, 2, 8, 7], [2, 9, 5, 5, 4, 10, 2, 5, 10, 10, 11, 7, 2, 10, 7],
+        [11, 7, 2, 2, 8, 4, 11, 2, 4, 1, 11, 4], [0, 1, 11, 11, 7, 2, 0, 11, 2], [0, 9, 5, 11, 7, 2, 2, 8, 4, 11, 2, 4, 1, 11, 4], [11, 7, 2, 1, 11, 2, 2, 9, 5, 1, 2, 5],
+        [2, 8, 10, 7, 2, 10, 5, 7, 10, 1, 5, 10], [10, 1, 5, 5, 7, 2, 10, 5, 2, 4, 10, 2, 0, 4, 2], [7, 2, 8, 8, 10, 1, 7, 8, 1, 9, 7, 1, 0, 9, 1], [1, 4, 10, 2, 9, 7],
+        [8, 4, 5, 8, 5, 7, 2, 8, 7], [5, 7, 2, 0, 5, 2], [0, 9, 7, 2, 8, 4, 7, 2, 4, 0, 7, 4], [2, 9, 7],
+        [6, 10, 11, 6, 11, 9, 2, 6, 9], [0, 4, 8, 6, 10, 11, 6, 11, 9, 2, 6, 9], [2, 6, 10, 10, 11, 5, 2, 10, 5, 0, 2, 5], [2, 6, 10, 10, 11, 5, 2, 10, 5, 5, 4, 8, 2, 5, 8],
+        [2, 6, 4, 9, 2, 4, 11, 9, 4, 1, 11, 4], [9, 2, 6, 11, 9, 6, 1, 11, 6, 1, 6, 8, 0, 1, 8], [4, 1, 11, 6, 4, 11, 2, 6, 11, 2, 11, 5, 0, 2, 5], [1, 11, 5, 2, 6, 8],
+        [5, 9, 2, 2, 6, 10, 5, 2, 10, 1, 5, 10], [0, 4, 8, 5, 9, 2, 2, 6, 10, 5, 2, 10, 1, 5, 10], [0, 2, 6, 6, 10, 1, 0, 6, 1], [4, 8, 2, 1, 4, 2, 2, 6, 10, 1, 2, 10],
+        [4, 5, 9, 6, 4, 9, 2, 6, 9], [9, 2, 6, 5, 9, 6, 5, 6, 8, 0, 5, 8], [2, 6, 4, 0, 2, 4], [2, 6, 8],
+        [10, 11, 9, 8, 10, 9], [4, 10, 11, 4, 11, 9, 0, 4, 9], [10, 11, 5, 8, 10, 5, 0, 8, 5], [10, 11, 5, 4, 10, 5],
+        [9, 8, 4, 11, 9, 4, 1, 11, 4], [1, 11, 9, 0, 1, 9], [4, 1, 11, 8, 4, 11, 8, 11, 5, 0, 8, 5], [1, 11, 5],
+        [5, 9, 8, 5, 8, 10, 1, 5, 10], [0, 4, 10, 1, 5, 9, 10, 1, 9, 0, 10, 9], [8, 10, 1, 0, 8, 1], [1, 4, 10],
+        [5, 9, 8, 4, 5, 8], [0, 5, 9], [0, 8, 4], [],
+    ]
+
+    /// Scalar samples on an `size.x * size.y * size.z` lattice, x fastest.
+    /// Samples that are not finite mark unobserved space; cells touching them are skipped.
+    struct Grid {
+        let values: UnsafeBufferPointer<Float>
+        let size: SIMD3<Int>
+        /// Position of sample (0, 0, 0) and distance between neighbouring samples.
+        var origin: SIMD3<Float> = .zero
+        var spacing: Float = 1
+
+        @inline(__always)
+        func index(_ x: Int, _ y: Int, _ z: Int) -> Int {
+            x + size.x * (y + size.y * z)
+        }
+    }
+
+    /// Extracts the surface where the samples cross `isoValue`.
+    /// - Parameter insideIsBelow: true for signed distances (negative inside), false for indicators.
+    static func extract(_ grid: Grid, isoValue: Float = 0, insideIsBelow: Bool = true) -> MeshBuffer {
+        let size = grid.size
+        guard size.x >= 2 && size.y >= 2 && size.z >= 2 else { return MeshBuffer() }
+        let nodeCount = size.x * size.y * size.z
+        let planeSize = size.x * size.y
+        let values = grid.values
+
+        @inline(__always) func isInside(_ value: Float) -> Bool {
+            insideIsBelow ? value < isoValue : value > isoValue
+        }
+        @inline(__always) func crosses(_ a: Int, _ b: Int) -> Bool {
+            let va = values[a], vb = values[b]
+            return va.isFinite && vb.isFinite && isInside(va) != isInside(vb)
+        }
+        let axisStride = [1, size.x, planeSize]
+
+        // 1. Number the crossing edges plane by plane; edge (node, axis) has id 3 * node + axis.
+        let edgeVertex = UnsafeMutableBufferPointer<Int32>.allocate(capacity: nodeCount * 3)
+        defer { edgeVertex.deallocate() }
+        var planeCount = [Int](repeating: 0, count: size.z)
+        planeCount.withUnsafeMutableBufferPointer { countBuffer in
+            let counts = countBuffer
+            DispatchQueue.concurrentPerform(iterations: size.z) { z in
+                var found = 0
+                for y in 0..<size.y {
+                    for x in 0..<size.x {
+                        let node = grid.index(x, y, z)
+                        for axis in 0..<3 {
+                            let inside = axis == 0 ? x + 1 < size.x : (axis == 1 ? y + 1 < size.y : z + 1 < size.z)
+                            if inside && crosses(node, node + axisStride[axis]) {
+                                edgeVertex[node * 3 + axis] = Int32(found)
+                                found += 1
+                            } else {
+                                edgeVertex[node * 3 + axis] = -1
+                            }
+                        }
+                    }
+                }
+                counts[z] = found
+            }
+        }
+        var planeStart = [Int](repeating: 0, count: size.z + 1)
+        for z in 0..<size.z {
+            planeStart[z + 1] = planeStart[z] + planeCount[z]
+        }
+        let starts = planeStart
+
+        var mesh = MeshBuffer()
+        mesh.positions = [SIMD3<Float>](repeating: .zero, count: starts[size.z])
+        mesh.positions.withUnsafeMutableBufferPointer { positionBuffer in
+            let positions = positionBuffer
+            DispatchQueue.concurrentPerform(iterations: size.z) { z in
+                let base = Int32(starts[z])
+                for y in 0..<size.y {
+                    for x in 0..<size.x {
+                        let node = grid.index(x, y, z)
+                        for axis in 0..<3 where edgeVertex[node * 3 + axis] >= 0 {
+                            let id = edgeVertex[node * 3 + axis] + base
+                            edgeVertex[node * 3 + axis] = id
+                            let va = values[node], vb = values[node + axisStride[axis]]
+                            let t = (isoValue - va) / (vb - va)
+                            var p = SIMD3<Float>(Float(x), Float(y), Float(z))
+                            p[axis] += t
+                            positions[Int(id)] = grid.origin + p * grid.spacing
+                        }
+                    }
+                }
+            }
+        }
+
+        // 2. Emit triangles slab by slab and concatenate.
+        let cellSlabs = size.z - 1
+        var slabIndices = [[UInt32]](repeating: [], count: cellSlabs)
+        let cornerOffsets = (0..<8).map { c in (c & 1) * axisStride[0] + ((c >> 1) & 1) * axisStride[1] + ((c >> 2) & 1) * axisStride[2] }
+        let edgeIds = edgeCorners.map { a, b -> (Int, Int) in
+            let axis = (a ^ b) == 1 ? 0 : ((a ^ b) == 2 ? 1 : 2)
+            return (cornerOffsets[a], axis)
+        }
+        slabIndices.withUnsafeMutableBufferPointer { slabBuffer in
+            let slabs = slabBuffer
+            DispatchQueue.concurrentPerform(iterations: cellSlabs) { z in
+                var indices: [UInt32] = []
+                for y in 0..<(size.y - 1) {
+                    for x in 0..<(size.x - 1) {
+                        let node = grid.index(x, y, z)
+                        var cube = 0
+                        var observed = true
+                        for corner in 0..<8 {
+                            let value = values[node + cornerOffsets[corner]]
+                            if !value.isFinite { observed = false; break }
+                            if isInside(value) { cube |= 1 << corner }
+                        }
+                        guard observed else { continue }
+                        for edge in triangleTable[cube] {
+                            let (offset, axis) = edgeIds[Int(edge)]
+                            indices.append(UInt32(edgeVertex[(node + offset) * 3 + axis]))
+                        }
+                    }
+                }
+                slabs[z] = indices
+            }
+        }
+        mesh.indices.reserveCapacity(slabIndices.reduce(0) { $0 + $1.count })
+        for indices in slabIndices {
+            mesh.indices.append(contentsOf: indices)
+        }
+        return mesh
+    }
+}
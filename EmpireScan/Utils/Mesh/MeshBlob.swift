@@ -0,0 +1,163 @@
+//
+//  MeshBlob.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Pre-parsed mesh stored in a layout that can be memory-mapped and used in place.
+///
+/// A 32-byte header (magic, version, vertex and face counts, weld epsilon) is followed
+/// by packed float positions, packed float smooth normals and 32-bit triangle indices,
+/// all little-endian and 4-byte aligned. Opening a blob maps the file and checks the
+/// indices once; nothing is parsed or welded again.
+struct MeshBlob {
+    static let magic: UInt32 = 0x3142_4D45 // "EMB1"
+    static let version: UInt32 = 2
+    static let headerSize = 32
+    /// Bytes per packed float3.
+    static let vectorSize = 12
+
+    let data: Data
+    let vertexCount: Int
+    let faceCount: Int
+    /// Distance under which the STL's vertices were merged.
+    let weldEpsilon: Float
+
+    var positionsOffset: Int { MeshBlob.headerSize }
+    var normalsOffset: Int { positionsOffset + vertexCount * MeshBlob.vectorSize }
+    var indicesOffset: Int { normalsOffset + vertexCount * MeshBlob.vectorSize }
+
+    /// Maps the blob at `url` instead of reading it into memory.
+    init(url: URL) throws {
+        try self.init(data: Data(contentsOf: url, options: .alwaysMapped))
+    }
+
+    init(data: Data) throws {
+        guard data.count >= MeshBlob.headerSize else {
+            throw MeshBlob.error(1, "Invalid mesh blob size")
+        }
+        let header = data.withUnsafeBytes { raw in
+            (0..<5).map { UInt32(littleEndian: raw.loadUnaligned(fromByteOffset: $0 * 4, as: UInt32.self)) }
+        }
+        guard header[0] == MeshBlob.magic, header[1] == MeshBlob.version else {
+            throw MeshBlob.error(2, "Not a mesh blob or an unsupported version")
+        }
+        vertexCount = Int(header[2])
+        faceCount = Int(header[3])
+        weldEpsilon = Float(bitPattern: header[4])
+        self.data = data
+        guard data.count >= indicesOffset + faceCount * 12 else {
+            throw MeshBlob.error(1, "Invalid mesh blob size")
+        }
+
+        // A corrupt blob must not hand SceneKit an index past the last vertex.
+        let start = indicesOffset
+        let indexCount = faceCount * 3
+        var largest = [UInt32](repeating: 0, count: Parallel.chunkCount(for: indexCount))
+        data.withUnsafeBytes { raw in
+            largest.withUnsafeMutableBufferPointer { largestBuffer in
+                let out = largestBuffer
+                Parallel.forEachChunk(count: indexCount) { chunk, range in
+                    var chunkLargest: UInt32 = 0
+                    for i in range {
+                        chunkLargest = max(chunkLargest, UInt32(littleEndian: raw.loadUnaligned(fromByteOffset: start + i * 4, as: UInt32.self)))
+                    }
+                    out[chunk] = chunkLargest
+                }
+            }
+        }
+        if let maxIndex = largest.max(), Int(maxIndex) >= vertexCount {
+            throw MeshBlob.error(3, "Mesh blob index out of range")
+        }
+    }
+
+    /// Writes `mesh` and its smooth normals as a blob, replacing `url` atomically.
+    static func write(_ mesh: IndexedMesh, weldEpsilon: Float, to url: URL) throws {
+        try encode(mesh, weldEpsilon: weldEpsilon).write(to: url, options: .atomic)
+    }
+
+    /// Blob bytes for `mesh`, welded with `weldEpsilon`, and its smooth normals.
+    static func encode(_ mesh: IndexedMesh, weldEpsilon: Float) -> Data {
+        let normals = mesh.vertexNormals()
+        let vertexCount = mesh.positions.count
+        var data = Data(count: headerSize + vertexCount * vectorSize * 2 + mesh.indices.count * 4)
+        data.withUnsafeMutableBytes { bytes in
+            let base = bytes.baseAddress!
+            for (slot, value) in [magic, version, UInt32(vertexCount), UInt32(mesh.faceCount), weldEpsilon.bitPattern].enumerated() {
+                base.storeBytes(of: value.littleEndian, toByteOffset: slot * 4, as: UInt32.self)
+            }
+            let normalsStart = headerSize + vertexCount * vectorSize
+            let indicesStart = normalsStart + vertexCount * vectorSize
+            Parallel.forEachChunk(count: vertexCount) { _, range in
+                for vertex in range {
+                    store(mesh.positions[vertex], base + headerSize + vertex * vectorSize)
+                    store(normals[vertex], base + normalsStart + vertex * vectorSize)
+                }
+            }
+            mesh.indices.withUnsafeBytes { indices in
+                if let source = indices.baseAddress {
+                    (base + indicesStart).copyMemory(from: source, byteCount: indices.count)
+                }
+            }
+        }
+        return data
+    }
+
+    /// Blob for the STL at `stlURL`, kept next to it as `<name>.stl.blob`.
+    ///
+    /// The first call maps, welds and stores the STL; later calls only map the blob,
+    /// as long as it is newer than the STL and was welded with the same epsilon. A blob
+    /// that fails its checks is rebuilt. Next to a read-only file, such as a bundle
+    /// resource, the blob is only kept in memory.
+    static func cached(forSTL stlURL: URL, weldEpsilon: Float = MeshWelder.defaultEpsilon) throws -> MeshBlob {
+        let blobURL = stlURL.appendingPathExtension("blob")
+        let fileManager = FileManager.default
+        if let blobDate = (try? fileManager.attributesOfItem(atPath: blobURL.path))?[.modificationDate] as? Date,
+           let stlDate = (try? fileManager.attributesOfItem(atPath: stlURL.path))?[.modificationDate] as? Date,
+           blobDate >= stlDate,
+           let blob = try? MeshBlob(url: blobURL),
+           blob.weldEpsilon == weldEpsilon {
+            return blob
+        }
+        let (positions, _) = try STLFile(url: stlURL).packedGeometry()
+        let data = encode(MeshWelder.weld(soup: positions, epsilon: weldEpsilon), weldEpsilon: weldEpsilon)
+        try? data.write(to: blobURL, options: .atomic)
+        return try MeshBlob(data: data)
+    }
+
+    /// Copies the blob back into an `IndexedMesh`.
+    func indexedMesh() -> IndexedMesh {
+        data.withUnsafeBytes { raw in
+            let positions = (0..<vertexCount).map { vertex -> SIMD3<Float> in
+                let offset = positionsOffset + vertex * MeshBlob.vectorSize
+                return SIMD3(raw.loadUnaligned(fromByteOffset: offset, as: Float.self),
+                             raw.loadUnaligned(fromByteOffset: offset + 4, as: Float.self),
+                             raw.loadUnaligned(fromByteOffset: offset + 8, as: Float.self))
+            }
+            let indices = (0..<(faceCount * 3)).map {
+                UInt32(littleEndian: raw.loadUnaligned(fromByteOffset: indicesOffset + $0 * 4, as: UInt32.self))
+            }
+            return IndexedMesh(positions: positions, indices: indices)
+        }
+    }
+
+    /// Index bytes, ready for an index buffer.
+    var indexData: Data {
+        data.subdata(in: indicesOffset..<(indicesOffset + faceCount * 12))
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "MeshBlob", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+
+    @inline(__always)
+    private static func store(_ vector: SIMD3<Float>, _ pointer: UnsafeMutableRawPointer) {
+        pointer.storeBytes(of: vector.x, toByteOffset: 0, as: Float.self)
+        pointer.storeBytes(of: vector.y, toByteOffset: 4, as: Float.self)
+        pointer.storeBytes(of: vector.z, toByteOffset: 8, as: Float.self)
+    }
+}
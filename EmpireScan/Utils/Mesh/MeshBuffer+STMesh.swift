@@ -0,0 +1,119 @@
+//
+//  MeshBuffer+STMesh.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import Structure
+import simd
+
+extension MeshBuffer {
+    /// Flattens every partial mesh of `mesh` into one buffer with global 32-bit indices.
+    ///
+    /// Each partial mesh is copied once, straight into its final slot, on its own thread.
+    init(mesh: STMesh) {
+        self.init()
+        let meshCount = Int(mesh.numberOfMeshes())
+        var vertexStart = 0
+        var faceStart = 0
+        for meshIndex in 0..<meshCount {
+            let vertexCount = Int(mesh.number(ofMeshVertices: Int32(meshIndex)))
+            let faceCount = Int(mesh.number(ofMeshFaces: Int32(meshIndex)))
+            submeshes.append(Submesh(vertexRange: vertexStart..<(vertexStart + vertexCount),
+                                     faceRange: faceStart..<(faceStart + faceCount)))
+            vertexStart += vertexCount
+            faceStart += faceCount
+        }
+        let parts = submeshes
+
+        // STMesh is not thread-safe, so resolve every pointer up front.
+        typealias Source = UnsafeRawPointer?
+        let vertices = (0..<meshCount).map { index -> Source in UnsafeRawPointer(mesh.meshVertices(Int32(index))) }
+        let faces = (0..<meshCount).map { index -> Source in UnsafeRawPointer(mesh.meshFaces(Int32(index))) }
+        let normalSources = !mesh.hasPerVertexNormals() ? [] : (0..<meshCount).map { index -> Source in
+            UnsafeRawPointer(mesh.meshPerVertexNormals(Int32(index)))
+        }
+        let colorSources = !mesh.hasPerVertexColors() ? [] : (0..<meshCount).map { index -> Source in
+            UnsafeRawPointer(mesh.meshPerVertexColors(Int32(index)))
+        }
+        let uvSources = !mesh.hasPerVertexUVTextureCoords() ? [] : (0..<meshCount).map { index -> Source in
+            UnsafeRawPointer(mesh.meshPerVertexUVTextureCoords(Int32(index)))
+        }
+
+        positions = MeshBuffer.gather(vertexStart, parts: parts) { part, out in
+            MeshBuffer.copyVectors(vertices[part], into: out, range: parts[part].vertexRange)
+        }
+        if !normalSources.isEmpty {
+            normals = MeshBuffer.gather(vertexStart, parts: parts) { part, out in
+                MeshBuffer.copyVectors(normalSources[part], into: out, range: parts[part].vertexRange)
+            }
+        }
+        if !colorSources.isEmpty {
+            colors = MeshBuffer.gather(vertexStart, parts: parts) { part, out in
+                MeshBuffer.copyVectors(colorSources[part], into: out, range: parts[part].vertexRange)
+            }
+        }
+        if !uvSources.isEmpty {
+            uvs = MeshBuffer.gather(vertexStart, parts: parts) { part, out in
+                let range = parts[part].vertexRange
+                guard let source = uvSources[part] else {
+                    for vertex in range { out[vertex] = .zero }
+                    return
+                }
+                for vertex in 0..<range.count {
+                    out[range.lowerBound + vertex] = SIMD2(source.load(fromByteOffset: vertex * 8, as: Float.self),
+                                                           source.load(fromByteOffset: vertex * 8 + 4, as: Float.self))
+                }
+            }
+        }
+        indices = MeshBuffer.gather(faceStart * 3, parts: parts) { part, out in
+            let faceRange = parts[part].faceRange
+            let base = UInt32(parts[part].vertexRange.lowerBound)
+            guard let source = faces[part] else {
+                for corner in (faceRange.lowerBound * 3)..<(faceRange.upperBound * 3) { out[corner] = base }
+                return
+            }
+            for corner in 0..<(faceRange.count * 3) {
+                out[faceRange.lowerBound * 3 + corner] = source.load(fromByteOffset: corner * 4, as: UInt32.self) + base
+            }
+        }
+    }
+
+    /// Builds an `STMesh` through a temporary PLY file, the only way the SDK can create one.
+    func makeSTMesh() throws -> STMesh {
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("mesh-\(UUID().uuidString).ply")
+        defer { try? FileManager.default.removeItem(at: url) }
+        try writePLY(to: url)
+        guard let mesh = STMesh.initFromFile(url.path) else {
+            throw NSError(domain: "MeshBuffer", code: 1, userInfo: [NSLocalizedDescriptionKey: "Unable to load the mesh into STMesh"])
+        }
+        return mesh
+    }
+
+    /// Allocates `count` elements and lets every part fill its own slice concurrently.
+    private static func gather<Element>(_ count: Int, parts: [Submesh], fill: (Int, UnsafeMutableBufferPointer<Element>) -> Void) -> [Element] {
+        [Element](unsafeUninitializedCapacity: count) { buffer, initializedCount in
+            let out = buffer
+            DispatchQueue.concurrentPerform(iterations: parts.count) { part in
+                fill(part, out)
+            }
+            initializedCount = count
+        }
+    }
+
+    /// Copies packed `GLKVector3` values into `SIMD3<Float>` slots.
+    private static func copyVectors(_ source: UnsafeRawPointer?, into out: UnsafeMutableBufferPointer<SIMD3<Float>>, range: Range<Int>) {
+        guard let source = source else {
+            for vertex in range { out[vertex] = .zero }
+            return
+        }
+        for vertex in 0..<range.count {
+            let offset = vertex * 12
+            out[range.lowerBound + vertex] = SIMD3(source.load(fromByteOffset: offset, as: Float.self),
+                                                   source.load(fromByteOffset: offset + 4, as: Float.self),
+                                                   source.load(fromByteOffset: offset + 8, as: Float.self))
+        }
+    }
+}
@@ -0,0 +1,147 @@
+//
+//  MeshBuffer.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Flat triangle mesh: one structure-of-arrays vertex store and one 32-bit index buffer.
+///
+/// Optional attributes are either empty or have exactly `vertexCount` entries.
+/// Meshes imported from the Structure SDK remember where each of their partial meshes
+/// landed in `submeshes`, so they can be handed back in that layout without copying.
+struct MeshBuffer {
+    /// Location of one partial mesh inside the flat buffers.
+    struct Submesh: Equatable {
+        var vertexRange: Range<Int>
+        var faceRange: Range<Int>
+    }
+
+    /// A run of faces viewed as a self-contained partial mesh.
+    ///
+    /// Indices are local to `vertexRange`; nothing is copied until they are read.
+    struct PartialMesh {
+        let vertexRange: Range<Int>
+        let faceRange: Range<Int>
+
+        var vertexCount: Int { vertexRange.count }
+        var faceCount: Int { faceRange.count }
+
+        /// True when local indices fit the 16-bit index buffers of older renderers.
+        var fitsUInt16Indices: Bool { vertexRange.count <= Int(UInt16.max) }
+    }
+
+    var positions: [SIMD3<Float>] = []
+    var normals: [SIMD3<Float>] = []
+    var colors: [SIMD3<Float>] = []
+    var uvs: [SIMD2<Float>] = []
+    var indices: [UInt32] = []
+    var submeshes: [Submesh] = []
+
+    init() {}
+
+    init(positions: [SIMD3<Float>], indices: [UInt32], normals: [SIMD3<Float>] = [], colors: [SIMD3<Float>] = [], uvs: [SIMD2<Float>] = []) {
+        self.positions = positions
+        self.indices = indices
+        self.normals = normals
+        self.colors = colors
+        self.uvs = uvs
+    }
+
+    init(_ mesh: IndexedMesh) {
+        self.init(positions: mesh.positions, indices: mesh.indices)
+    }
+
+    var vertexCount: Int { positions.count }
+    var faceCount: Int { indices.count / 3 }
+    var hasNormals: Bool { !normals.isEmpty }
+    var hasColors: Bool { !colors.isEmpty }
+    var hasUVs: Bool { !uvs.isEmpty }
+
+    @inline(__always)
+    func face(_ index: Int) -> SIMD3<UInt32> {
+        SIMD3(indices[index * 3], indices[index * 3 + 1], indices[index * 3 + 2])
+    }
+
+    /// Local index `corner` (0..<3 * faceCount) of a partial mesh.
+    @inline(__always)
+    func localIndex(_ corner: Int, in partial: PartialMesh) -> UInt32 {
+        indices[partial.faceRange.lowerBound * 3 + corner] - UInt32(partial.vertexRange.lowerBound)
+    }
+
+    /// Views the mesh as partial meshes of at most `maxFaces` faces.
+    ///
+    /// Imported meshes return their original partial meshes. Otherwise faces are cut into
+    /// consecutive runs and each run spans the vertices it references.
+    func partialMeshes(maxFaces: Int = Int(UInt16.max)) -> [PartialMesh] {
+        if !submeshes.isEmpty && submeshes.allSatisfy({ $0.faceRange.count <= maxFaces }) {
+            return submeshes.map { PartialMesh(vertexRange: $0.vertexRange, faceRange: $0.faceRange) }
+        }
+        var partials: [PartialMesh] = []
+        var start = 0
+        while start < faceCount {
+            let end = min(faceCount, start + maxFaces)
+            var lower = UInt32.max
+            var upper: UInt32 = 0
+            for corner in (start * 3)..<(end * 3) {
+                lower = min(lower, indices[corner])
+                upper = max(upper, indices[corner])
+            }
+            partials.append(PartialMesh(vertexRange: Int(lower)..<(Int(upper) + 1), faceRange: start..<end))
+            start = end
+        }
+        return partials
+    }
+
+    /// Drops attributes whose length does not match the vertex count.
+    mutating func validateAttributes() {
+        if normals.count != vertexCount { normals = [] }
+        if colors.count != vertexCount { colors = [] }
+        if uvs.count != vertexCount { uvs = [] }
+    }
+
+    /// Removes the faces `keep` rejects and the vertices left unreferenced, in place.
+    ///
+    /// Surviving elements only ever move towards the front, so the arrays are compacted
+    /// without a second copy of the mesh.
+    mutating func compact(keepingFaces keep: (Int) -> Bool) {
+        var vertexMap = [Int32](repeating: -1, count: vertexCount)
+        var keptFaces = 0
+        for face in 0..<faceCount where keep(face) {
+            for corner in 0..<3 {
+                let index = indices[face * 3 + corner]
+                indices[keptFaces * 3 + corner] = index
+                vertexMap[Int(index)] = 0
+            }
+            keptFaces += 1
+        }
+        indices.removeLast(indices.count - keptFaces * 3)
+
+        var next = 0
+        for vertex in 0..<vertexCount where vertexMap[vertex] == 0 {
+            vertexMap[vertex] = Int32(next)
+            positions[next] = positions[vertex]
+            if hasNormals { normals[next] = normals[vertex] }
+            if hasColors { colors[next] = colors[vertex] }
+            if hasUVs { uvs[next] = uvs[vertex] }
+            next += 1
+        }
+        let removed = vertexCount - next
+        positions.removeLast(removed)
+        if hasNormals { normals.removeLast(removed) }
+        if hasColors { colors.removeLast(removed) }
+        if hasUVs { uvs.removeLast(removed) }
+        for corner in 0..<indices.count {
+            indices[corner] = UInt32(vertexMap[Int(indices[corner])])
+        }
+        submeshes = []
+    }
+
+    /// Writes the mesh as a binary little-endian PLY file.
+    func writePLY(to url: URL) throws {
+        try MeshExporter.write(self, to: [.ply: url], options: MeshExporter.Options(xRightYUp: false))
+    }
+}
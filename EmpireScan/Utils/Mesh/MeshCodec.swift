@@ -0,0 +1,411 @@
+//
+//  MeshCodec.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Lossy geometry codec for uploading and storing scans.
+///
+/// Positions are snapped to a grid of `Options.precision`. Triangles are coded in
+/// their original order against a FIFO of recently seen edges and one of recently
+/// seen vertices: most triangles share an edge with one just coded and either add
+/// the next new vertex or reuse a recent one, so they cost one small symbol. A new
+/// vertex across a shared edge is predicted by the parallelogram rule and only the
+/// residual is stored. The symbol, index and residual streams are then entropy coded
+/// with `RANS`. Unreferenced vertices are dropped and vertices are renumbered in the
+/// order triangles first use them; normals are left to the reader.
+enum MeshCodec {
+    static let magic: UInt32 = 0x3143_4D45 // "EMC1"
+    static let version: UInt32 = 1
+    /// Recent edges a triangle can attach to; index 15 marks a triangle with no shared edge.
+    static let edgeFIFOSize = 15
+    /// Recent vertices a corner can reuse; codes 1...14.
+    static let vertexFIFOSize = 14
+
+    struct Options {
+        /// Quantization step in mesh units. 0.05 mm for Structure scans, which are in
+        /// metres; no decoded position is off by more than `maximumError`.
+        var precision: Float = 5e-5
+
+        var maximumError: Float { precision * 0.5 * 3.squareRoot() }
+    }
+
+    private static let newVertex: UInt8 = 0
+    private static let explicitVertex: UInt8 = 15
+    private static let unattached: UInt8 = 0xF0
+    private static let headerSize = 36
+
+    /// Encodes `mesh` at `options.precision`.
+    static func encode(_ mesh: IndexedMesh, options: Options = Options()) throws -> Data {
+        try encodeReordering(mesh, options: options).data
+    }
+
+    /// Encodes `mesh` and reports which input vertex became each decoded vertex, so
+    /// per-vertex attributes stored elsewhere can follow the same order.
+    static func encodeReordering(_ mesh: IndexedMesh, options: Options = Options()) throws -> (data: Data, order: [UInt32]) {
+        guard options.precision > 0 else {
+            throw error(1, "Precision must be positive")
+        }
+        guard mesh.positions.count < Int(UInt32.max), mesh.indices.allSatisfy({ Int($0) < mesh.positions.count }) else {
+            throw error(2, "The mesh has invalid indices")
+        }
+
+        var lower = SIMD3<Float>(repeating: .greatestFiniteMagnitude)
+        var upper = -lower
+        for position in mesh.positions {
+            lower = simd_min(lower, position)
+            upper = simd_max(upper, position)
+        }
+        if mesh.positions.isEmpty {
+            lower = .zero
+            upper = .zero
+        }
+        guard ((upper - lower) / options.precision).max() < Float(1 << 30) else {
+            throw error(3, "Precision is too fine for the size of the mesh")
+        }
+
+        var connectivity = Connectivity(vertexCount: mesh.positions.count, encoding: true)
+        for face in 0..<mesh.faceCount {
+            connectivity.encode(mesh.indices[face * 3], mesh.indices[face * 3 + 1], mesh.indices[face * 3 + 2])
+        }
+
+        let residuals = positionResiduals(mesh.positions, order: connectivity.order, predictors: connectivity.predictors,
+                                          origin: lower, step: options.precision)
+
+        var data = Data(capacity: headerSize + connectivity.codes.count + residuals.count)
+        data.appendLittleEndian(magic)
+        data.appendLittleEndian(version)
+        data.appendLittleEndian(UInt32(connectivity.order.count))
+        data.appendLittleEndian(UInt32(mesh.faceCount))
+        for value in [lower.x, lower.y, lower.z, options.precision] {
+            data.appendLittleEndian(value.bitPattern)
+        }
+        data.appendLittleEndian(UInt32(0))
+
+        var streams = [Data](repeating: Data(), count: 3)
+        let symbols = [connectivity.codes, connectivity.explicit, residuals]
+        streams.withUnsafeMutableBufferPointer { streamBuffer in
+            let out = streamBuffer
+            DispatchQueue.concurrentPerform(iterations: symbols.count) { stream in
+                out[stream] = RANS.encode(symbols[stream])
+            }
+        }
+        streams.forEach { data.append($0) }
+        return (data, connectivity.order)
+    }
+
+    static func decode(_ data: Data) throws -> IndexedMesh {
+        guard data.count >= headerSize, data.uint32(at: 0) == magic else {
+            throw error(4, "Not an encoded mesh")
+        }
+        guard data.uint32(at: 4) == version else {
+            throw error(5, "Unsupported encoded mesh version")
+        }
+        let vertexCount = Int(data.uint32(at: 8))
+        let faceCount = Int(data.uint32(at: 12))
+        let values = (0..<4).map { Float(bitPattern: data.uint32(at: 16 + $0 * 4)) }
+        let origin = SIMD3(values[0], values[1], values[2])
+        let step = values[3]
+
+        var offset = headerSize
+        let codes = try RANS.decode(data, offset: &offset)
+        let explicit = try RANS.decode(data, offset: &offset)
+        let residuals = try RANS.decode(data, offset: &offset)
+        // Every face reads at least one code, and every vertex is introduced by one.
+        guard faceCount <= codes.count, vertexCount <= codes.count else {
+            throw error(6, "The connectivity is corrupt")
+        }
+
+        var connectivity = Connectivity(vertexCount: vertexCount)
+        var indices = [UInt32]()
+        indices.reserveCapacity(faceCount * 3)
+        var codeReader = ByteReader(bytes: codes)
+        var explicitReader = ByteReader(bytes: explicit)
+        for _ in 0..<faceCount {
+            let face = try connectivity.decode(&codeReader, &explicitReader)
+            indices += [face.x, face.y, face.z]
+        }
+        guard Int(connectivity.next) == vertexCount else {
+            throw error(6, "The connectivity is corrupt")
+        }
+
+        // Predictions chain through earlier vertices, so integers are rebuilt in order.
+        var quantized = [SIMD3<Int32>](repeating: .zero, count: vertexCount)
+        var residualReader = ByteReader(bytes: residuals)
+        for vertex in 0..<vertexCount {
+            let residual = SIMD3(try residualReader.signedVarint(), try residualReader.signedVarint(), try residualReader.signedVarint())
+            quantized[vertex] = prediction(for: vertex, connectivity.predictors[vertex], quantized) &+ residual
+        }
+
+        var positions = [SIMD3<Float>](repeating: .zero, count: vertexCount)
+        positions.withUnsafeMutableBufferPointer { positionBuffer in
+            quantized.withUnsafeBufferPointer { quantizedBuffer in
+                let out = positionBuffer
+                let input = quantizedBuffer
+                Parallel.forEachChunk(count: vertexCount) { _, range in
+                    for vertex in range {
+                        out[vertex] = origin + SIMD3<Float>(input[vertex]) * step
+                    }
+                }
+            }
+        }
+        return IndexedMesh(positions: positions, indices: indices)
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "MeshCodec", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+
+    // MARK: Positions
+
+    /// Zigzag varints of each vertex's distance from its prediction, in coded order.
+    private static func positionResiduals(_ positions: [SIMD3<Float>], order: [UInt32], predictors: [SIMD3<UInt32>],
+                                          origin: SIMD3<Float>, step: Float) -> [UInt8] {
+        var quantized = [SIMD3<Int32>](repeating: .zero, count: order.count)
+        quantized.withUnsafeMutableBufferPointer { quantizedBuffer in
+            let out = quantizedBuffer
+            Parallel.forEachChunk(count: order.count) { _, range in
+                for vertex in range {
+                    out[vertex] = SIMD3<Int32>((positions[Int(order[vertex])] - origin) / step, rounding: .toNearestOrAwayFromZero)
+                }
+            }
+        }
+        var residuals: [UInt8] = []
+        residuals.reserveCapacity(order.count * 3)
+        for vertex in 0..<order.count {
+            let residual = quantized[vertex] &- prediction(for: vertex, predictors[vertex], quantized)
+            residuals.appendSignedVarint(residual.x)
+            residuals.appendSignedVarint(residual.y)
+            residuals.appendSignedVarint(residual.z)
+        }
+        return residuals
+    }
+
+    /// Parallelogram prediction across a shared edge, otherwise the previous vertex.
+    @inline(__always)
+    private static func prediction(for vertex: Int, _ predictor: SIMD3<UInt32>, _ quantized: [SIMD3<Int32>]) -> SIMD3<Int32> {
+        if predictor.x != Connectivity.noPredictor {
+            return quantized[Int(predictor.x)] &+ quantized[Int(predictor.y)] &- quantized[Int(predictor.z)]
+        }
+        return vertex > 0 ? quantized[vertex - 1] : .zero
+    }
+
+    // MARK: Connectivity
+
+    /// Edge and vertex FIFOs shared by the encoder and decoder, which must update them
+    /// in exactly the same order.
+    private struct Connectivity {
+        static let noPredictor = UInt32.max
+
+        /// Directed edges as a neighbour would see them, with the vertex opposite.
+        private var edges = [SIMD3<UInt32>](repeating: .zero, count: MeshCodec.edgeFIFOSize)
+        private var edgeHead = 0
+        private var edgeCount = 0
+        private var vertices = [UInt32](repeating: 0, count: MeshCodec.vertexFIFOSize)
+        private var vertexHead = 0
+        private var vertexCount = 0
+
+        /// New id of every original vertex, or -1 while unseen. Encoder only.
+        private var remap: [Int32]
+        /// Original index of every new id. Encoder only.
+        private(set) var order: [UInt32] = []
+        /// Parallelogram vertices (a, b, opposite) per new id, or `noPredictor`.
+        private(set) var predictors: [SIMD3<UInt32>] = []
+        private(set) var codes: [UInt8] = []
+        private(set) var explicit: [UInt8] = []
+        private(set) var next: UInt32 = 0
+        private let capacity: Int
+
+        init(vertexCount: Int, encoding: Bool = false) {
+            capacity = vertexCount
+            remap = encoding ? [Int32](repeating: -1, count: vertexCount) : []
+            predictors.reserveCapacity(vertexCount)
+            if encoding {
+                order.reserveCapacity(vertexCount)
+            }
+        }
+
+        // MARK: Encoding
+
+        mutating func encode(_ i0: UInt32, _ i1: UInt32, _ i2: UInt32) {
+            let corners = [i0, i1, i2]
+            for rotation in 0..<3 {
+                let a = remap[Int(corners[rotation])], b = remap[Int(corners[(rotation + 1) % 3])]
+                guard a >= 0, b >= 0, let slot = findEdge(UInt32(a), UInt32(b)) else { continue }
+                let opposite = edge(slot).z
+                let (code, c) = encodeCorner(corners[(rotation + 2) % 3], predictor: SIMD3(UInt32(a), UInt32(b), opposite))
+                codes.append(UInt8(slot) << 4 | code)
+                pushEdge(c, UInt32(b), UInt32(a))
+                pushEdge(UInt32(a), c, UInt32(b))
+                return
+            }
+            codes.append(MeshCodec.unattached)
+            var ids: [UInt32] = []
+            for corner in corners {
+                let (code, id) = encodeCorner(corner, predictor: SIMD3(repeating: Connectivity.noPredictor))
+                codes.append(code)
+                ids.append(id)
+            }
+            pushTriangleEdges(ids[0], ids[1], ids[2])
+        }
+
+        private mutating func encodeCorner(_ original: UInt32, predictor: SIMD3<UInt32>) -> (UInt8, UInt32) {
+            let known = remap[Int(original)]
+            if known < 0 {
+                let id = next
+                remap[Int(original)] = Int32(id)
+                order.append(original)
+                predictors.append(predictor)
+                next += 1
+                pushVertex(id)
+                return (MeshCodec.newVertex, id)
+            }
+            let id = UInt32(known)
+            if let slot = findVertex(id) {
+                return (UInt8(slot + 1), id)
+            }
+            explicit.appendVarint(next - 1 - id)
+            pushVertex(id)
+            return (MeshCodec.explicitVertex, id)
+        }
+
+        // MARK: Decoding
+
+        mutating func decode(_ symbols: inout ByteReader, _ distances: inout ByteReader) throws -> SIMD3<UInt32> {
+            let code = try symbols.byte()
+            if code == MeshCodec.unattached {
+                let noPredictor = SIMD3(repeating: Connectivity.noPredictor)
+                let a = try decodeCorner(symbols.byte(), predictor: noPredictor, &distances)
+                let b = try decodeCorner(symbols.byte(), predictor: noPredictor, &distances)
+                let c = try decodeCorner(symbols.byte(), predictor: noPredictor, &distances)
+                pushTriangleEdges(a, b, c)
+                return SIMD3(a, b, c)
+            }
+            let slot = Int(code >> 4)
+            guard slot < edgeCount else {
+                throw MeshCodec.error(6, "The connectivity is corrupt")
+            }
+            let shared = edge(slot)
+            let c = try decodeCorner(code & 0x0f, predictor: shared, &distances)
+            pushEdge(c, shared.y, shared.x)
+            pushEdge(shared.x, c, shared.y)
+            return SIMD3(shared.x, shared.y, c)
+        }
+
+        private mutating func decodeCorner(_ code: UInt8, predictor: SIMD3<UInt32>, _ distances: inout ByteReader) throws -> UInt32 {
+            switch code {
+            case MeshCodec.newVertex:
+                guard Int(next) < capacity else { throw MeshCodec.error(6, "The connectivity is corrupt") }
+                let id = next
+                predictors.append(predictor)
+                next += 1
+                pushVertex(id)
+                return id
+            case MeshCodec.explicitVertex:
+                let distance = try distances.varint()
+                guard distance < UInt64(next) else { throw MeshCodec.error(6, "The connectivity is corrupt") }
+                let id = next - 1 - UInt32(distance)
+                pushVertex(id)
+                return id
+            default:
+                let slot = Int(code) - 1
+                guard slot < vertexCount else { throw MeshCodec.error(6, "The connectivity is corrupt") }
+                return vertex(slot)
+            }
+        }
+
+        // MARK: FIFOs
+
+        /// Entry `slot` counting back from the most recent.
+        private func edge(_ slot: Int) -> SIMD3<UInt32> {
+            edges[(edgeHead - 1 - slot + MeshCodec.edgeFIFOSize) % MeshCodec.edgeFIFOSize]
+        }
+
+        private func vertex(_ slot: Int) -> UInt32 {
+            vertices[(vertexHead - 1 - slot + MeshCodec.vertexFIFOSize) % MeshCodec.vertexFIFOSize]
+        }
+
+        private func findEdge(_ a: UInt32, _ b: UInt32) -> Int? {
+            (0..<edgeCount).first { slot in
+                let candidate = edge(slot)
+                return candidate.x == a && candidate.y == b
+            }
+        }
+
+        private func findVertex(_ id: UInt32) -> Int? {
+            (0..<vertexCount).first { vertex($0) == id }
+        }
+
+        private mutating func pushEdge(_ a: UInt32, _ b: UInt32, _ opposite: UInt32) {
+            edges[edgeHead] = SIMD3(a, b, opposite)
+            edgeHead = (edgeHead + 1) % MeshCodec.edgeFIFOSize
+            edgeCount = min(edgeCount + 1, MeshCodec.edgeFIFOSize)
+        }
+
+        /// Reversed edges of triangle (a, b, c), so the neighbour across each can find it.
+        private mutating func pushTriangleEdges(_ a: UInt32, _ b: UInt32, _ c: UInt32) {
+            pushEdge(b, a, c)
+            pushEdge(c, b, a)
+            pushEdge(a, c, b)
+        }
+
+        private mutating func pushVertex(_ id: UInt32) {
+            vertices[vertexHead] = id
+            vertexHead = (vertexHead + 1) % MeshCodec.vertexFIFOSize
+            vertexCount = min(vertexCount + 1, MeshCodec.vertexFIFOSize)
+        }
+    }
+
+    /// Sequential reads from a decoded stream.
+    private struct ByteReader {
+        let bytes: [UInt8]
+        var offset = 0
+
+        init(bytes: [UInt8]) {
+            self.bytes = bytes
+        }
+
+        mutating func byte() throws -> UInt8 {
+            guard offset < bytes.count else { throw MeshCodec.error(7, "The encoded mesh is truncated") }
+            defer { offset += 1 }
+            return bytes[offset]
+        }
+
+        mutating func varint() throws -> UInt64 {
+            var value: UInt64 = 0
+            var shift: UInt64 = 0
+            while true {
+                let byte = try byte()
+                guard shift < 64 else { throw MeshCodec.error(7, "The encoded mesh is corrupt") }
+                value |= UInt64(byte & 0x7f) << shift
+                if byte < 0x80 { return value }
+                shift += 7
+            }
+        }
+
+        mutating func signedVarint() throws -> Int32 {
+            let value = try varint()
+            return Int32(truncatingIfNeeded: Int64(bitPattern: value >> 1) ^ -Int64(bitPattern: value & 1))
+        }
+    }
+}
+
+private extension Array where Element == UInt8 {
+    mutating func appendVarint<T: BinaryInteger>(_ value: T) {
+        var value = UInt64(value)
+        while value >= 0x80 {
+            append(UInt8(value & 0x7f) | 0x80)
+            value >>= 7
+        }
+        append(UInt8(value))
+    }
+
+    mutating func appendSignedVarint(_ value: Int32) {
+        let wide = Int64(value)
+        appendVarint(UInt64(bitPattern: (wide << 1) ^ (wide >> 63)))
+    }
+}
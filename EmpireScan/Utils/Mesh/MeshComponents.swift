@@ -0,0 +1,164 @@
+//
+//  MeshComponents.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Connected components of a mesh, used to strip floor noise, speckle and other
+/// floating fragments from a scan.
+///
+/// Vertices are split into contiguous ranges. Faces that stay inside one range are
+/// united by that range's thread, which only ever touches parents inside its own range,
+/// so the parallel phase needs no locks. The few faces that span ranges are united
+/// afterwards on the calling thread.
+enum MeshComponents {
+    struct Component {
+        var faceCount = 0
+        var area: Float = 0
+    }
+
+    struct Options {
+        /// Keep only the largest component by area.
+        var keepLargestOnly = true
+        /// When not keeping only the largest, components below both thresholds are dropped.
+        var minFaceCount = 500
+        var minArea: Float = 0.0005
+    }
+
+    /// Component index of every face, plus the face count and area of each component.
+    static func label(_ mesh: MeshBuffer) -> (faceComponent: [Int32], components: [Component]) {
+        let vertexCount = mesh.vertexCount
+        let faceCount = mesh.faceCount
+        guard faceCount > 0 else { return ([], []) }
+
+        let rangeCount = Parallel.chunkCount(for: vertexCount, minChunk: 16_384)
+        let rangeSize = (vertexCount + rangeCount - 1) / rangeCount
+        var parent = [UInt32](repeating: 0, count: vertexCount)
+
+        // Faces grouped by the vertex range they lie in; spanning faces go last.
+        var rangeOfFace = [Int32](repeating: 0, count: faceCount)
+        rangeOfFace.withUnsafeMutableBufferPointer { rangeBuffer in
+            let out = rangeBuffer
+            Parallel.forEachChunk(count: faceCount) { _, range in
+                for face in range {
+                    let corners = mesh.face(face)
+                    let a = Int(corners.x) / rangeSize, b = Int(corners.y) / rangeSize, c = Int(corners.z) / rangeSize
+                    out[face] = a == b && b == c ? Int32(a) : Int32(rangeCount)
+                }
+            }
+        }
+        var groupStart = [Int](repeating: 0, count: rangeCount + 2)
+        for range in rangeOfFace {
+            groupStart[Int(range) + 1] += 1
+        }
+        for group in 0...rangeCount {
+            groupStart[group + 1] += groupStart[group]
+        }
+        var fill = groupStart
+        var grouped = [UInt32](repeating: 0, count: faceCount)
+        for face in 0..<faceCount {
+            let group = Int(rangeOfFace[face])
+            grouped[fill[group]] = UInt32(face)
+            fill[group] += 1
+        }
+        let starts = groupStart, faces = grouped
+
+        parent.withUnsafeMutableBufferPointer { parentBuffer in
+            let parents = parentBuffer
+            DispatchQueue.concurrentPerform(iterations: rangeCount) { range in
+                let vertices = (range * rangeSize)..<min(vertexCount, (range + 1) * rangeSize)
+                for vertex in vertices {
+                    parents[vertex] = UInt32(vertex)
+                }
+                for slot in starts[range]..<starts[range + 1] {
+                    let corners = mesh.face(Int(faces[slot]))
+                    union(corners.x, corners.y, in: parents)
+                    union(corners.x, corners.z, in: parents)
+                }
+            }
+            for slot in starts[rangeCount]..<starts[rangeCount + 1] {
+                let corners = mesh.face(Int(faces[slot]))
+                union(corners.x, corners.y, in: parents)
+                union(corners.x, corners.z, in: parents)
+            }
+        }
+
+        // Roots numbered in vertex order; every face takes its first vertex's component.
+        var componentOfRoot = [Int32](repeating: -1, count: vertexCount)
+        var componentCount: Int32 = 0
+        for vertex in 0..<vertexCount where parent[vertex] == UInt32(vertex) {
+            componentOfRoot[vertex] = componentCount
+            componentCount += 1
+        }
+        let rootComponent = componentOfRoot
+        var faceComponent = [Int32](repeating: 0, count: faceCount)
+        var faceArea = [Float](repeating: 0, count: faceCount)
+        parent.withUnsafeBufferPointer { parents in
+            faceComponent.withUnsafeMutableBufferPointer { componentBuffer in
+                faceArea.withUnsafeMutableBufferPointer { areaBuffer in
+                    let componentOut = componentBuffer, areaOut = areaBuffer
+                    Parallel.forEachChunk(count: faceCount) { _, range in
+                        for face in range {
+                            let corners = mesh.face(face)
+                            var root = corners.x
+                            while parents[Int(root)] != root { root = parents[Int(root)] }
+                            componentOut[face] = rootComponent[Int(root)]
+                            let p0 = mesh.positions[Int(corners.x)]
+                            areaOut[face] = simd_length(simd_cross(mesh.positions[Int(corners.y)] - p0, mesh.positions[Int(corners.z)] - p0)) / 2
+                        }
+                    }
+                }
+            }
+        }
+
+        var components = [Component](repeating: Component(), count: Int(componentCount))
+        for face in 0..<faceCount {
+            let component = Int(faceComponent[face])
+            components[component].faceCount += 1
+            components[component].area += faceArea[face]
+        }
+        return (faceComponent, components)
+    }
+
+    /// Drops unwanted components in place and returns how many faces were removed.
+    @discardableResult
+    static func removeFragments(from mesh: inout MeshBuffer, options: Options = Options()) -> Int {
+        let (faceComponent, components) = label(mesh)
+        guard components.count > 1 else { return 0 }
+        let largest = components.indices.max { components[$0].area < components[$1].area }!
+        let keep = components.indices.map { index -> Bool in
+            if index == largest { return true }
+            if options.keepLargestOnly { return false }
+            return components[index].faceCount >= options.minFaceCount || components[index].area >= options.minArea
+        }
+        let before = mesh.faceCount
+        mesh.compact { keep[Int(faceComponent[$0])] }
+        return before - mesh.faceCount
+    }
+
+    /// Links the trees of `a` and `b`, hanging the larger root under the smaller one.
+    @inline(__always)
+    private static func union(_ a: UInt32, _ b: UInt32, in parent: UnsafeMutableBufferPointer<UInt32>) {
+        var x = find(a, in: parent)
+        var y = find(b, in: parent)
+        guard x != y else { return }
+        if x < y { swap(&x, &y) }
+        parent[Int(x)] = y
+    }
+
+    /// Root of `vertex`, halving the path on the way.
+    @inline(__always)
+    private static func find(_ vertex: UInt32, in parent: UnsafeMutableBufferPointer<UInt32>) -> UInt32 {
+        var current = vertex
+        while parent[Int(current)] != current {
+            let grandparent = parent[Int(parent[Int(current)])]
+            parent[Int(current)] = grandparent
+            current = grandparent
+        }
+        return current
+    }
+}
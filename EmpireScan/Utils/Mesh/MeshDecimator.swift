@@ -0,0 +1,534 @@
+//
+//  MeshDecimator.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Quadric error metric decimation (Garland & Heckbert) that runs on all cores.
+///
+/// The mesh is cut into slabs along its longest axis and every slab is decimated on its
+/// own thread. Vertices shared by two slabs stay locked, so a second pass with slabs
+/// shifted by half a slab width simplifies the seams left by the first one.
+enum MeshDecimator {
+    struct Options {
+        /// Keep open boundary vertices in place.
+        var preserveBoundary = true
+        /// Carry vertex colors and UVs through collapses; otherwise they are dropped.
+        var preserveColors = true
+        var preserveUVs = true
+        /// A collapse is rejected when it turns a face normal further than this cosine.
+        var minNormalCosine: Float = 0.2
+        /// Meshes smaller than this are decimated as a single region.
+        var minFacesPerRegion = 25_000
+    }
+
+    /// Decimation wrapped in a `MeshTask`, mirroring `STMesh.newDecimateTask`.
+    static func newDecimateTask(with mesh: MeshBuffer, numFaces: Int, options: Options = Options(),
+                                completion: @escaping MeshTask.Completion) -> MeshTask {
+        MeshTask(work: { task in
+            try decimate(mesh, targetFaces: numFaces, options: options, task: task)
+        }, completion: completion)
+    }
+
+    /// Collapses edges in order of increasing quadric error until at most `targetFaces`
+    /// faces remain or no valid collapse is left.
+    static func decimate(_ mesh: MeshBuffer, targetFaces: Int, options: Options = Options(), task: MeshTask? = nil) throws -> MeshBuffer {
+        var current = mesh
+        current.validateAttributes()
+        current.submeshes = []
+        if !options.preserveColors { current.colors = [] }
+        if !options.preserveUVs { current.uvs = [] }
+        guard targetFaces < current.faceCount else { return current }
+
+        let hadNormals = current.hasNormals
+        current.normals = []
+        let regionCount = max(1, min(Parallel.coreCount, current.faceCount / max(1, options.minFacesPerRegion)))
+        let shifts: [Float] = regionCount > 1 ? [0, 0.5] : [0]
+        for (passIndex, shift) in shifts.enumerated() where current.faceCount > targetFaces {
+            let ratio = Double(targetFaces) / Double(current.faceCount)
+            let faceRegion = partition(current, regionCount: regionCount, shift: shift)
+            current = try decimatePass(current, faceRegion: faceRegion, regionCount: regionCount + (shift > 0 ? 1 : 0),
+                                       ratio: ratio, options: options, task: task) { fraction in
+                task?.report((Double(passIndex) + fraction) / Double(shifts.count))
+            }
+        }
+        if hadNormals {
+            current.normals = IndexedMesh(positions: current.positions, indices: current.indices).vertexNormals()
+        }
+        return current
+    }
+
+    // MARK: Partitioning
+
+    /// Slab index of every face, by centroid along the longest axis of the bounds.
+    private static func partition(_ mesh: MeshBuffer, regionCount: Int, shift: Float) -> [Int32] {
+        var faceRegion = [Int32](repeating: 0, count: mesh.faceCount)
+        guard regionCount > 1 else { return faceRegion }
+        let statistics = MeshStatistics(mesh)
+        let size = statistics.size
+        let axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2)
+        let origin = statistics.min[axis]
+        let inverseWidth = Float(regionCount) / max(size[axis], .leastNormalMagnitude)
+        let maxRegion = Float(regionCount + (shift > 0 ? 0 : -1))
+        faceRegion.withUnsafeMutableBufferPointer { regionBuffer in
+            let out = regionBuffer
+            Parallel.forEachChunk(count: mesh.faceCount) { _, range in
+                for face in range {
+                    let corners = mesh.face(face)
+                    let centroid = (mesh.positions[Int(corners.x)][axis] + mesh.positions[Int(corners.y)][axis]
+                        + mesh.positions[Int(corners.z)][axis]) / 3
+                    let slab = ((centroid - origin) * inverseWidth + shift).rounded(.down)
+                    out[face] = Int32(max(0, min(maxRegion, slab)))
+                }
+            }
+        }
+        return faceRegion
+    }
+
+    /// Decimates every region concurrently and stitches the results back together.
+    private static func decimatePass(_ mesh: MeshBuffer, faceRegion: [Int32], regionCount: Int, ratio: Double,
+                                     options: Options, task: MeshTask?, progress: @escaping (Double) -> Void) throws -> MeshBuffer {
+        // Owner region of every vertex, or -2 when its faces lie in several regions.
+        var owner = [Int32](repeating: -1, count: mesh.vertexCount)
+        var regionFaceCount = [Int](repeating: 0, count: regionCount)
+        for face in 0..<mesh.faceCount {
+            let region = faceRegion[face]
+            regionFaceCount[Int(region)] += 1
+            for corner in 0..<3 {
+                let vertex = Int(mesh.indices[face * 3 + corner])
+                owner[vertex] = owner[vertex] == -1 || owner[vertex] == region ? region : -2
+            }
+        }
+        var regionStart = [Int](repeating: 0, count: regionCount + 1)
+        for region in 0..<regionCount {
+            regionStart[region + 1] = regionStart[region] + regionFaceCount[region]
+        }
+        var fill = regionStart
+        var regionFaces = [Int32](repeating: 0, count: mesh.faceCount)
+        for face in 0..<mesh.faceCount {
+            let region = Int(faceRegion[face])
+            regionFaces[fill[region]] = Int32(face)
+            fill[region] += 1
+        }
+
+        let totalToRemove = max(1, mesh.faceCount - Int(Double(mesh.faceCount) * ratio))
+        let progressLock = NSLock()
+        var removedSoFar = 0
+        var results = [RegionResult?](repeating: nil, count: regionCount)
+        var localIndex = [Int32](repeating: -1, count: mesh.vertexCount)
+        var failure: Error?
+
+        localIndex.withUnsafeMutableBufferPointer { localIndexBuffer in
+            results.withUnsafeMutableBufferPointer { resultBuffer in
+                let localOut = localIndexBuffer, resultOut = resultBuffer
+                let bounds = regionStart, faces = regionFaces, owners = owner
+                DispatchQueue.concurrentPerform(iterations: regionCount) { region in
+                    let faceRange = bounds[region]..<bounds[region + 1]
+                    guard !faceRange.isEmpty else { return }
+                    var local = RegionMesh(mesh: mesh, faces: faces[faceRange], region: Int32(region), owner: owners, localIndex: localOut)
+                    let target = Int((Double(faceRange.count) * ratio).rounded())
+                    do {
+                        try local.decimate(targetFaces: target, options: options, task: task) { removed in
+                            progressLock.lock()
+                            removedSoFar += removed
+                            let fraction = Double(removedSoFar) / Double(totalToRemove)
+                            progressLock.unlock()
+                            progress(min(1, fraction))
+                        }
+                        resultOut[region] = local.result()
+                    } catch {
+                        progressLock.lock()
+                        failure = error
+                        progressLock.unlock()
+                    }
+                }
+            }
+        }
+        if let failure = failure {
+            throw failure
+        }
+
+        // Stitch: shared vertices are emitted once, everything else is region-private.
+        var output = MeshBuffer()
+        var sharedOutput = [Int32](repeating: -1, count: mesh.vertexCount)
+        let keepColors = mesh.hasColors, keepUVs = mesh.hasUVs
+        for case let result? in results {
+            var map = [UInt32](repeating: 0, count: result.positions.count)
+            for vertex in 0..<result.positions.count {
+                let global = Int(result.globalIds[vertex])
+                if owner[global] == -2 && sharedOutput[global] >= 0 {
+                    map[vertex] = UInt32(sharedOutput[global])
+                    continue
+                }
+                map[vertex] = UInt32(output.positions.count)
+                if owner[global] == -2 {
+                    sharedOutput[global] = Int32(output.positions.count)
+                }
+                output.positions.append(result.positions[vertex])
+                if keepColors { output.colors.append(result.colors[vertex]) }
+                if keepUVs { output.uvs.append(result.uvs[vertex]) }
+            }
+            output.indices.reserveCapacity(output.indices.count + result.indices.count)
+            for index in result.indices {
+                output.indices.append(map[Int(index)])
+            }
+        }
+        return output
+    }
+}
+
+// MARK: - Quadrics
+
+private struct Quadric {
+    var xx = 0.0, xy = 0.0, xz = 0.0, xw = 0.0
+    var yy = 0.0, yz = 0.0, yw = 0.0
+    var zz = 0.0, zw = 0.0, ww = 0.0
+
+    init() {}
+
+    /// Squared distance to the plane through `point` with unit `normal`, scaled by `weight`.
+    init(normal n: SIMD3<Double>, point: SIMD3<Double>, weight: Double) {
+        let d = -simd_dot(n, point)
+        xx = weight * n.x * n.x; xy = weight * n.x * n.y; xz = weight * n.x * n.z; xw = weight * n.x * d
+        yy = weight * n.y * n.y; yz = weight * n.y * n.z; yw = weight * n.y * d
+        zz = weight * n.z * n.z; zw = weight * n.z * d
+        ww = weight * d * d
+    }
+
+    static func + (lhs: Quadric, rhs: Quadric) -> Quadric {
+        var sum = lhs
+        sum += rhs
+        return sum
+    }
+
+    static func += (lhs: inout Quadric, rhs: Quadric) {
+        lhs.xx += rhs.xx; lhs.xy += rhs.xy; lhs.xz += rhs.xz; lhs.xw += rhs.xw
+        lhs.yy += rhs.yy; lhs.yz += rhs.yz; lhs.yw += rhs.yw
+        lhs.zz += rhs.zz; lhs.zw += rhs.zw
+        lhs.ww += rhs.ww
+    }
+
+    func error(at p: SIMD3<Double>) -> Double {
+        xx * p.x * p.x + 2 * xy * p.x * p.y + 2 * xz * p.x * p.z + 2 * xw * p.x
+            + yy * p.y * p.y + 2 * yz * p.y * p.z + 2 * yw * p.y
+            + zz * p.z * p.z + 2 * zw * p.z + ww
+    }
+
+    /// Point of least error, or nil when the quadric is (nearly) singular.
+    func minimizer() -> SIMD3<Double>? {
+        let a = simd_double3x3(rows: [SIMD3(xx, xy, xz), SIMD3(xy, yy, yz), SIMD3(xz, yz, zz)])
+        let scale = (xx + yy + zz) / 3
+        let det = a.determinant
+        guard scale > 0, abs(det) > 1e-9 * scale * scale * scale else { return nil }
+        return a.inverse * SIMD3(-xw, -yw, -zw)
+    }
+}
+
+// MARK: - Edge heap
+
+private struct EdgeCandidate {
+    let cost: Double
+    let a: Int32
+    let b: Int32
+    let stampA: UInt32
+    let stampB: UInt32
+}
+
+/// Binary min-heap on collapse cost; stale entries are skipped when popped.
+private struct EdgeHeap {
+    private var items: [EdgeCandidate] = []
+
+    init(capacity: Int) {
+        items.reserveCapacity(capacity)
+    }
+
+    var isEmpty: Bool { items.isEmpty }
+
+    mutating func push(_ item: EdgeCandidate) {
+        items.append(item)
+        var child = items.count - 1
+        while child > 0 {
+            let parent = (child - 1) / 2
+            guard items[child].cost < items[parent].cost else { break }
+            items.swapAt(child, parent)
+            child = parent
+        }
+    }
+
+    mutating func pop() -> EdgeCandidate? {
+        guard let first = items.first else { return nil }
+        let last = items.removeLast()
+        guard !items.isEmpty else { return first }
+        items[0] = last
+        var parent = 0
+        while true {
+            let left = parent * 2 + 1, right = left + 1
+            var smallest = parent
+            if left < items.count && items[left].cost < items[smallest].cost { smallest = left }
+            if right < items.count && items[right].cost < items[smallest].cost { smallest = right }
+            guard smallest != parent else { break }
+            items.swapAt(parent, smallest)
+            parent = smallest
+        }
+        return first
+    }
+}
+
+// MARK: - Region decimation
+
+private struct RegionResult {
+    var positions: [SIMD3<Float>]
+    var colors: [SIMD3<Float>]
+    var uvs: [SIMD2<Float>]
+    var globalIds: [UInt32]
+    var indices: [UInt32]
+}
+
+/// One region copied out of the shared mesh with local vertex numbering.
+private struct RegionMesh {
+    var positions: [SIMD3<Float>] = []
+    var colors: [SIMD3<Float>] = []
+    var uvs: [SIMD2<Float>] = []
+    var globalIds: [UInt32] = []
+    var locked: [Bool] = []
+    var faces: [SIMD3<Int32>] = []
+    var faceAlive: [Bool] = []
+    var vertexFaces: [[Int32]] = []
+    var quadrics: [Quadric] = []
+    var stamps: [UInt32] = []
+
+    /// `localIndex` is shared by all regions; only entries of vertices owned by `region` are touched.
+    init(mesh: MeshBuffer, faces regionFaces: ArraySlice<Int32>, region: Int32, owner: [Int32], localIndex: UnsafeMutableBufferPointer<Int32>) {
+        var sharedIndex: [UInt32: Int32] = [:]
+        faces.reserveCapacity(regionFaces.count)
+        func local(_ global: UInt32) -> Int32 {
+            if owner[Int(global)] == region {
+                if localIndex[Int(global)] < 0 {
+                    localIndex[Int(global)] = Int32(globalIds.count)
+                    globalIds.append(global)
+                    locked.append(false)
+                }
+                return localIndex[Int(global)]
+            }
+            if let index = sharedIndex[global] {
+                return index
+            }
+            let index = Int32(globalIds.count)
+            sharedIndex[global] = index
+            globalIds.append(global)
+            locked.append(true)
+            return index
+        }
+        for face in regionFaces {
+            let corners = mesh.face(Int(face))
+            faces.append(SIMD3(local(corners.x), local(corners.y), local(corners.z)))
+        }
+        positions = globalIds.map { mesh.positions[Int($0)] }
+        if mesh.hasColors { colors = globalIds.map { mesh.colors[Int($0)] } }
+        if mesh.hasUVs { uvs = globalIds.map { mesh.uvs[Int($0)] } }
+    }
+
+    mutating func decimate(targetFaces: Int, options: MeshDecimator.Options, task: MeshTask?, progress: (Int) -> Void) throws {
+        let vertexCount = positions.count
+        faceAlive = [Bool](repeating: true, count: faces.count)
+        vertexFaces = [[Int32]](repeating: [], count: vertexCount)
+        quadrics = [Quadric](repeating: Quadric(), count: vertexCount)
+        stamps = [UInt32](repeating: 0, count: vertexCount)
+
+        var edgeKeys: [UInt64] = []
+        edgeKeys.reserveCapacity(faces.count * 3)
+        for (faceIndex, face) in faces.enumerated() {
+            for corner in 0..<3 {
+                vertexFaces[Int(face[corner])].append(Int32(faceIndex))
+                let a = face[corner], b = face[(corner + 1) % 3]
+                edgeKeys.append(UInt64(UInt32(min(a, b))) << 32 | UInt64(UInt32(max(a, b))))
+            }
+            let p0 = SIMD3<Double>(positions[Int(face.x)]), p1 = SIMD3<Double>(positions[Int(face.y)]), p2 = SIMD3<Double>(positions[Int(face.z)])
+            let cross = simd_cross(p1 - p0, p2 - p0)
+            let length = simd_length(cross)
+            guard length > 0 else { continue }
+            let plane = Quadric(normal: cross / length, point: p0, weight: length / 2)
+            quadrics[Int(face.x)] += plane
+            quadrics[Int(face.y)] += plane
+            quadrics[Int(face.z)] += plane
+        }
+
+        // Classify edges: boundary edges are locked or penalised, non-manifold ones locked.
+        edgeKeys.sort()
+        var uniqueEdges: [(Int32, Int32)] = []
+        uniqueEdges.reserveCapacity(edgeKeys.count / 2 + 1)
+        var run = 0
+        while run < edgeKeys.count {
+            var next = run + 1
+            while next < edgeKeys.count && edgeKeys[next] == edgeKeys[run] { next += 1 }
+            let a = Int32(truncatingIfNeeded: edgeKeys[run] >> 32), b = Int32(truncatingIfNeeded: edgeKeys[run] & 0xFFFF_FFFF)
+            let uses = next - run
+            if uses > 2 || (uses == 1 && options.preserveBoundary) {
+                locked[Int(a)] = true
+                locked[Int(b)] = true
+            } else if uses == 1 {
+                addBoundaryQuadric(a, b)
+            }
+            uniqueEdges.append((a, b))
+            run = next
+        }
+
+        var heap = EdgeHeap(capacity: uniqueEdges.count * 2)
+        for (a, b) in uniqueEdges {
+            if let candidate = candidate(a, b) { heap.push(candidate) }
+        }
+
+        var aliveFaces = faces.count
+        var sinceReport = 0
+        while aliveFaces > targetFaces, let entry = heap.pop() {
+            guard stamps[Int(entry.a)] == entry.stampA && stamps[Int(entry.b)] == entry.stampB else { continue }
+            let before = aliveFaces
+            if let kept = collapse(entry.a, entry.b, options: options, aliveFaces: &aliveFaces) {
+                requeue(around: kept, into: &heap)
+                sinceReport += before - aliveFaces
+                if sinceReport >= 2048 {
+                    try task?.checkCancelled()
+                    progress(sinceReport)
+                    sinceReport = 0
+                }
+            }
+        }
+        progress(sinceReport)
+    }
+
+    /// Collapsed faces compacted to the vertices they still reference.
+    func result() -> RegionResult {
+        var map = [Int32](repeating: -1, count: positions.count)
+        var output = RegionResult(positions: [], colors: [], uvs: [], globalIds: [], indices: [])
+        for (faceIndex, face) in faces.enumerated() where faceAlive[faceIndex] {
+            for corner in 0..<3 {
+                let vertex = Int(face[corner])
+                if map[vertex] < 0 {
+                    map[vertex] = Int32(output.positions.count)
+                    output.positions.append(positions[vertex])
+                    output.globalIds.append(globalIds[vertex])
+                    if !colors.isEmpty { output.colors.append(colors[vertex]) }
+                    if !uvs.isEmpty { output.uvs.append(uvs[vertex]) }
+                }
+                output.indices.append(UInt32(map[vertex]))
+            }
+        }
+        return output
+    }
+
+    private mutating func addBoundaryQuadric(_ a: Int32, _ b: Int32) {
+        guard let face = vertexFaces[Int(a)].first(where: { faces[Int($0)].contains(b) }) else { return }
+        let corners = faces[Int(face)]
+        let p0 = SIMD3<Double>(positions[Int(corners.x)]), p1 = SIMD3<Double>(positions[Int(corners.y)]), p2 = SIMD3<Double>(positions[Int(corners.z)])
+        let pa = SIMD3<Double>(positions[Int(a)]), pb = SIMD3<Double>(positions[Int(b)])
+        let edge = pb - pa
+        let normal = simd_cross(edge, simd_cross(p1 - p0, p2 - p0))
+        let length = simd_length(normal)
+        guard length > 0 else { return }
+        let constraint = Quadric(normal: normal / length, point: pa, weight: 100 * simd_length_squared(edge))
+        quadrics[Int(a)] += constraint
+        quadrics[Int(b)] += constraint
+    }
+
+    /// Collapse of edge (a, b): which vertex survives and where it goes.
+    private func placement(_ a: Int32, _ b: Int32) -> (keep: Int32, remove: Int32, position: SIMD3<Double>, cost: Double)? {
+        if locked[Int(a)] && locked[Int(b)] { return nil }
+        let (keep, remove) = locked[Int(b)] ? (b, a) : (a, b)
+        let quadric = quadrics[Int(a)] + quadrics[Int(b)]
+        let pk = SIMD3<Double>(positions[Int(keep)]), pr = SIMD3<Double>(positions[Int(remove)])
+        var position = pk
+        if !locked[Int(keep)] {
+            let mid = (pk + pr) / 2
+            if let best = quadric.minimizer(), simd_distance(best, mid) <= simd_distance(pk, pr) {
+                position = best
+            } else {
+                position = [pk, pr, mid].min { quadric.error(at: $0) < quadric.error(at: $1) }!
+            }
+        }
+        return (keep, remove, position, max(0, quadric.error(at: position)))
+    }
+
+    private func candidate(_ a: Int32, _ b: Int32) -> EdgeCandidate? {
+        guard let placement = placement(a, b) else { return nil }
+        return EdgeCandidate(cost: placement.cost, a: a, b: b, stampA: stamps[Int(a)], stampB: stamps[Int(b)])
+    }
+
+    private func neighbors(of vertex: Int32) -> [Int32] {
+        var result: [Int32] = []
+        for face in vertexFaces[Int(vertex)] {
+            for corner in 0..<3 {
+                let other = faces[Int(face)][corner]
+                if other != vertex && !result.contains(other) { result.append(other) }
+            }
+        }
+        return result
+    }
+
+    /// Collapses edge (a, b) if that keeps the surface manifold and unflipped; returns the surviving vertex.
+    private mutating func collapse(_ a: Int32, _ b: Int32, options: MeshDecimator.Options, aliveFaces: inout Int) -> Int32? {
+        guard let (keep, remove, target, _) = placement(a, b) else { return nil }
+        let position = SIMD3<Float>(target)
+
+        // Link condition: the only common neighbours are the apexes of the shared faces.
+        let shared = vertexFaces[Int(remove)].filter { faces[Int($0)].contains(keep) }
+        guard !shared.isEmpty else { return nil }
+        let keepNeighbors = neighbors(of: keep)
+        let common = neighbors(of: remove).filter { $0 != keep && keepNeighbors.contains($0) }
+        guard common.count == shared.count else { return nil }
+
+        // Reject collapses that flip or degenerate any surviving face.
+        for (moved, faceList) in [(remove, vertexFaces[Int(remove)]), (keep, vertexFaces[Int(keep)])] {
+            for face in faceList where !shared.contains(face) {
+                let corners = faces[Int(face)]
+                let p = (0..<3).map { positions[Int(corners[$0])] }
+                let q = (0..<3).map { corners[$0] == moved ? position : p[$0] }
+                let before = simd_cross(p[1] - p[0], p[2] - p[0])
+                let after = simd_cross(q[1] - q[0], q[2] - q[0])
+                let beforeLength = simd_length(before), afterLength = simd_length(after)
+                guard afterLength > 0 else { return nil }
+                if beforeLength > 0 && simd_dot(before, after) < options.minNormalCosine * beforeLength * afterLength {
+                    return nil
+                }
+            }
+        }
+
+        let pk = positions[Int(keep)], pr = positions[Int(remove)]
+        let edgeLengthSquared = simd_length_squared(pr - pk)
+        let t = edgeLengthSquared > 0 ? max(0, min(1, simd_dot(position - pk, pr - pk) / edgeLengthSquared)) : 0
+        if !colors.isEmpty { colors[Int(keep)] = simd_mix(colors[Int(keep)], colors[Int(remove)], SIMD3(repeating: t)) }
+        if !uvs.isEmpty { uvs[Int(keep)] = simd_mix(uvs[Int(keep)], uvs[Int(remove)], SIMD2(repeating: t)) }
+
+        for face in vertexFaces[Int(remove)] {
+            if shared.contains(face) {
+                faceAlive[Int(face)] = false
+                aliveFaces -= 1
+                for corner in 0..<3 where faces[Int(face)][corner] != remove {
+                    let vertex = Int(faces[Int(face)][corner])
+                    vertexFaces[vertex].removeAll { $0 == face }
+                }
+            } else {
+                for corner in 0..<3 where faces[Int(face)][corner] == remove {
+                    faces[Int(face)][corner] = keep
+                }
+                vertexFaces[Int(keep)].append(face)
+            }
+        }
+        vertexFaces[Int(remove)] = []
+        positions[Int(keep)] = position
+        quadrics[Int(keep)] += quadrics[Int(remove)]
+        stamps[Int(keep)] &+= 1
+        stamps[Int(remove)] &+= 1
+        return keep
+    }
+
+    /// Re-queues every edge around `vertex` with its current cost.
+    func requeue(around vertex: Int32, into heap: inout EdgeHeap) {
+        for neighbor in neighbors(of: vertex) {
+            if let candidate = candidate(vertex, neighbor) { heap.push(candidate) }
+        }
+    }
+}
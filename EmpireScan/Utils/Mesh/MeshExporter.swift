@@ -0,0 +1,355 @@
+//
+//  MeshExporter.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Writes a `MeshBuffer` as OBJ, binary STL, PLY and GLB in one go.
+///
+/// The axis convention and scale are applied in a single parallel pass over the mesh,
+/// then every requested file is produced on its own thread from that shared copy.
+/// Each writer formats its body in parallel chunks that are written out in order.
+enum MeshExporter {
+    enum Format: CaseIterable {
+        case obj
+        case binarySTL
+        case ply
+        /// Binary glTF from `GLBWriter`, colored by vertex; expects `xRightYUp`.
+        case glb
+
+        var fileExtension: String {
+            switch self {
+            case .obj: return "obj"
+            case .binarySTL: return "stl"
+            case .ply: return "ply"
+            case .glb: return "glb"
+            }
+        }
+    }
+
+    struct Options {
+        /// Same as `kSTMeshWriteOptionUseXRightYUpConventionKey`: flips the Y and Z axes.
+        var xRightYUp = true
+        /// Same as `kSTMeshWriteOptionUseScaleKey`: positions are multiplied by this.
+        var scale: Float = 1
+    }
+
+    /// Writes `mesh` once per entry of `files`, replacing existing files.
+    static func write(_ mesh: MeshBuffer, to files: [Format: URL], options: Options = Options()) throws {
+        guard !files.isEmpty else { return }
+        guard mesh.faceCount <= Int(UInt32.max) else {
+            throw error(1, "Too many triangles to export")
+        }
+        let source = transformed(mesh, options: options)
+
+        let jobs = Array(files)
+        var failures = [Error?](repeating: nil, count: jobs.count)
+        failures.withUnsafeMutableBufferPointer { failureBuffer in
+            let out = failureBuffer
+            DispatchQueue.concurrentPerform(iterations: jobs.count) { job in
+                do {
+                    let (format, url) = jobs[job]
+                    try write(encode(source, as: format), to: url)
+                } catch {
+                    out[job] = error
+                }
+            }
+        }
+        if let failure = failures.compactMap({ $0 }).first {
+            throw failure
+        }
+    }
+
+    /// Adds `mesh` to `archive` once per entry, in order, without touching the disk.
+    ///
+    /// The formats are encoded concurrently first; the archive then deflates each one
+    /// in parallel blocks as it is added.
+    static func write(_ mesh: MeshBuffer, into archive: ZipStreamWriter, entries: [(name: String, format: Format)],
+                      options: Options = Options()) throws {
+        guard !entries.isEmpty else { return }
+        guard mesh.faceCount <= Int(UInt32.max) else {
+            throw error(1, "Too many triangles to export")
+        }
+        let source = transformed(mesh, options: options)
+        var encoded = [[Data]](repeating: [], count: entries.count)
+        var failures = [Error?](repeating: nil, count: entries.count)
+        encoded.withUnsafeMutableBufferPointer { encodedBuffer in
+            failures.withUnsafeMutableBufferPointer { failureBuffer in
+                let out = encodedBuffer, failed = failureBuffer
+                DispatchQueue.concurrentPerform(iterations: entries.count) { entry in
+                    do {
+                        out[entry] = try encode(source, as: entries[entry].format)
+                    } catch {
+                        failed[entry] = error
+                    }
+                }
+            }
+        }
+        if let failure = failures.compactMap({ $0 }).first {
+            throw failure
+        }
+        for (entry, chunks) in zip(entries, encoded) {
+            try archive.addEntry(entry.name) { emit in
+                for chunk in chunks {
+                    try emit(chunk)
+                }
+            }
+        }
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "MeshExporter", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+
+    /// Copy of `mesh` in the output convention. Flipping two axes is a rotation, so
+    /// normals take the same flip and the winding stays as it is.
+    private static func transformed(_ mesh: MeshBuffer, options: Options) -> MeshBuffer {
+        let flip: SIMD3<Float> = options.xRightYUp ? SIMD3(1, -1, -1) : SIMD3(repeating: 1)
+        let scale = flip * options.scale
+        guard scale != SIMD3(repeating: 1) else { return mesh }
+
+        var result = mesh
+        let vertexCount = mesh.vertexCount
+        result.positions.withUnsafeMutableBufferPointer { positionBuffer in
+            result.normals.withUnsafeMutableBufferPointer { normalBuffer in
+                let positions = positionBuffer, normals = normalBuffer
+                let hasNormals = normals.count == vertexCount
+                Parallel.forEachChunk(count: vertexCount) { _, range in
+                    for vertex in range {
+                        positions[vertex] *= scale
+                        if hasNormals { normals[vertex] *= flip }
+                    }
+                }
+            }
+        }
+        return result
+    }
+
+    private static func encode(_ mesh: MeshBuffer, as format: Format) throws -> [Data] {
+        switch format {
+        case .obj: return objChunks(mesh)
+        case .binarySTL: return [stlData(mesh)]
+        case .ply: return [plyData(mesh)]
+        case .glb: return [try GLBWriter.encode(mesh)]
+        }
+    }
+
+    // MARK: OBJ
+
+    /// Vertex lines, then face lines, each split into chunks formatted concurrently.
+    private static func objChunks(_ mesh: MeshBuffer) -> [Data] {
+        let vertexCount = mesh.vertexCount
+        let faceCount = mesh.faceCount
+        let vertexChunks = Parallel.chunkCount(for: vertexCount, minChunk: 8192)
+        let faceChunks = Parallel.chunkCount(for: faceCount, minChunk: 8192)
+
+        var chunks = [Data](repeating: Data(), count: 1 + vertexChunks + faceChunks)
+        chunks[0] = Data("# \(vertexCount) vertices, \(faceCount) faces\n".utf8)
+        chunks.withUnsafeMutableBufferPointer { chunkBuffer in
+            let out = chunkBuffer
+            Parallel.forEachChunk(count: vertexCount, minChunk: 8192) { chunk, range in
+                var text = TextBuffer(capacity: range.count * (mesh.hasColors ? 72 : 40) * (mesh.hasNormals ? 2 : 1))
+                for vertex in range {
+                    let p = mesh.positions[vertex]
+                    text.append("v ")
+                    text.append(p.x, p.y, p.z)
+                    if mesh.hasColors {
+                        text.append(" ")
+                        let c = mesh.colors[vertex]
+                        text.append(c.x, c.y, c.z)
+                    }
+                    text.append("\n")
+                }
+                if mesh.hasUVs {
+                    for vertex in range {
+                        let uv = mesh.uvs[vertex]
+                        text.append("vt ")
+                        text.append(uv.x)
+                        text.append(" ")
+                        text.append(uv.y)
+                        text.append("\n")
+                    }
+                }
+                if mesh.hasNormals {
+                    for vertex in range {
+                        let n = mesh.normals[vertex]
+                        text.append("vn ")
+                        text.append(n.x, n.y, n.z)
+                        text.append("\n")
+                    }
+                }
+                out[1 + chunk] = text.data
+            }
+            Parallel.forEachChunk(count: faceCount, minChunk: 8192) { chunk, range in
+                var text = TextBuffer(capacity: range.count * 32)
+                for face in range {
+                    text.append("f")
+                    for corner in 0..<3 {
+                        // OBJ indices are 1-based; every attribute shares the vertex index.
+                        let index = Int(mesh.indices[face * 3 + corner]) + 1
+                        text.append(" ")
+                        text.append(index)
+                        if mesh.hasUVs || mesh.hasNormals {
+                            text.append("/")
+                            if mesh.hasUVs { text.append(index) }
+                            if mesh.hasNormals {
+                                text.append("/")
+                                text.append(index)
+                            }
+                        }
+                    }
+                    text.append("\n")
+                }
+                out[1 + vertexChunks + chunk] = text.data
+            }
+        }
+        return chunks
+    }
+
+    /// Growable byte buffer with float and integer formatting that skips `String` where it can.
+    struct TextBuffer {
+        private(set) var data: Data
+
+        init(capacity: Int) {
+            data = Data(capacity: capacity)
+        }
+
+        mutating func append(_ text: StaticString) {
+            data.append(text.utf8Start, count: text.utf8CodeUnitCount)
+        }
+
+        /// Shortest text that reads back as exactly the same `Float`.
+        mutating func append(_ value: Float) {
+            data.append(contentsOf: value.description.utf8)
+        }
+
+        mutating func append(_ x: Float, _ y: Float, _ z: Float) {
+            append(x)
+            append(" ")
+            append(y)
+            append(" ")
+            append(z)
+        }
+
+        mutating func append(_ value: Int) {
+            if value < 0 { data.append(45) }
+            let magnitude = value.magnitude
+            var divisor: UInt = 1
+            while divisor <= magnitude / 10 { divisor *= 10 }
+            while divisor > 0 {
+                data.append(UInt8(truncatingIfNeeded: magnitude / divisor % 10) + 48)
+                divisor /= 10
+            }
+        }
+
+        /// Two lowercase hex digits.
+        mutating func appendHex(_ byte: UInt8) {
+            for nibble in [byte >> 4, byte & 0x0f] {
+                data.append(nibble < 10 ? nibble + 48 : nibble + 87)
+            }
+        }
+    }
+
+    // MARK: Binary formats
+
+    private static func stlData(_ mesh: MeshBuffer) -> Data {
+        let faceCount = mesh.faceCount
+        var data = Data(count: STLFile.headerSize + faceCount * STLFile.recordSize)
+        data.withUnsafeMutableBytes { bytes in
+            let base = bytes.baseAddress!
+            let header = Array("Binary STL exported by EmpireScan".utf8)
+            base.initializeMemory(as: UInt8.self, repeating: 0x20, count: 80)
+            base.copyMemory(from: header, byteCount: header.count)
+            base.storeBytes(of: UInt32(faceCount).littleEndian, toByteOffset: 80, as: UInt32.self)
+            Parallel.forEachChunk(count: faceCount) { _, range in
+                for face in range {
+                    let record = base + STLFile.headerSize + face * STLFile.recordSize
+                    let corners = mesh.face(face)
+                    let a = mesh.positions[Int(corners.x)]
+                    let b = mesh.positions[Int(corners.y)]
+                    let c = mesh.positions[Int(corners.z)]
+                    let cross = simd_cross(b - a, c - a)
+                    let length = simd_length(cross)
+                    store(length > 0 ? cross / length : .zero, record, 0)
+                    store(a, record, 12)
+                    store(b, record, 24)
+                    store(c, record, 36)
+                    record.storeBytes(of: UInt16(0), toByteOffset: 48, as: UInt16.self)
+                }
+            }
+        }
+        return data
+    }
+
+    /// Binary little-endian PLY; the layout `MeshBuffer.writePLY` promises.
+    private static func plyData(_ mesh: MeshBuffer) -> Data {
+        var header = "ply\nformat binary_little_endian 1.0\nelement vertex \(mesh.vertexCount)\n"
+        header += "property float x\nproperty float y\nproperty float z\n"
+        if mesh.hasNormals { header += "property float nx\nproperty float ny\nproperty float nz\n" }
+        if mesh.hasColors { header += "property uchar red\nproperty uchar green\nproperty uchar blue\n" }
+        header += "element face \(mesh.faceCount)\nproperty list uchar uint vertex_indices\nend_header\n"
+
+        let headerBytes = Array(header.utf8)
+        let vertexSize = 12 + (mesh.hasNormals ? 12 : 0) + (mesh.hasColors ? 3 : 0)
+        let faceSize = 13
+        let faceStart = headerBytes.count + mesh.vertexCount * vertexSize
+        var data = Data(count: faceStart + mesh.faceCount * faceSize)
+        data.withUnsafeMutableBytes { bytes in
+            let base = bytes.baseAddress!
+            base.copyMemory(from: headerBytes, byteCount: headerBytes.count)
+            Parallel.forEachChunk(count: mesh.vertexCount) { _, range in
+                for vertex in range {
+                    var record = base + headerBytes.count + vertex * vertexSize
+                    store(mesh.positions[vertex], record, 0)
+                    record += 12
+                    if mesh.hasNormals {
+                        store(mesh.normals[vertex], record, 0)
+                        record += 12
+                    }
+                    if mesh.hasColors {
+                        let c = (simd_clamp(mesh.colors[vertex], .zero, SIMD3(repeating: 1)) * 255).rounded(.toNearestOrEven)
+                        record.storeBytes(of: UInt8(c.x), toByteOffset: 0, as: UInt8.self)
+                        record.storeBytes(of: UInt8(c.y), toByteOffset: 1, as: UInt8.self)
+                        record.storeBytes(of: UInt8(c.z), toByteOffset: 2, as: UInt8.self)
+                    }
+                }
+            }
+            Parallel.forEachChunk(count: mesh.faceCount) { _, range in
+                for face in range {
+                    let record = base + faceStart + face * faceSize
+                    record.storeBytes(of: UInt8(3), toByteOffset: 0, as: UInt8.self)
+                    for corner in 0..<3 {
+                        record.storeBytes(of: mesh.indices[face * 3 + corner].littleEndian, toByteOffset: 1 + corner * 4, as: UInt32.self)
+                    }
+                }
+            }
+        }
+        return data
+    }
+
+    @inline(__always)
+    private static func store(_ vector: SIMD3<Float>, _ pointer: UnsafeMutableRawPointer, _ offset: Int) {
+        pointer.storeBytes(of: vector.x, toByteOffset: offset, as: Float.self)
+        pointer.storeBytes(of: vector.y, toByteOffset: offset + 4, as: Float.self)
+        pointer.storeBytes(of: vector.z, toByteOffset: offset + 8, as: Float.self)
+    }
+
+    private static func write(_ chunks: [Data], to url: URL) throws {
+        let fileManager = FileManager.default
+        if fileManager.fileExists(atPath: url.path) {
+            try fileManager.removeItem(at: url)
+        }
+        guard fileManager.createFile(atPath: url.path, contents: nil) else {
+            throw error(2, "Unable to create \(url.lastPathComponent)")
+        }
+        let handle = try FileHandle(forWritingTo: url)
+        defer { try? handle.close() }
+        for chunk in chunks {
+            try handle.write(contentsOf: chunk)
+        }
+    }
+}
@@ -0,0 +1,377 @@
+//
+//  MeshHoleFiller.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Liepa hole filling ("Filling Holes in Meshes", 2003) with every hole patched concurrently.
+///
+/// Each boundary loop is triangulated by a minimum dihedral-angle / area dynamic program,
+/// refined until its triangle density matches the surrounding mesh, and faired with
+/// umbrella smoothing. Loops whose patch would be too large are left open.
+enum MeshHoleFiller {
+    struct Options {
+        /// Largest patch area to fill, in mesh units squared (same as `kSTMeshFillHoleMaxPatchAreaKey`).
+        var maxPatchArea: Float = 0.01
+        /// Loops longer than this are openings, not holes; the ankle opening of a foot scan is one.
+        var maxHolePerimeter: Float = 0.15
+        /// The triangulation is cubic in the loop length, so very long loops are skipped.
+        var maxHoleVertices = 600
+        var refine = true
+        var fairingIterations = 20
+    }
+
+    /// A boundary loop; walking it in order follows the boundary edges of the existing faces.
+    struct Hole {
+        var vertices: [UInt32]
+        /// Normal of the mesh face on the far side of edge `vertices[k] -> vertices[k + 1]`.
+        var edgeNormals: [SIMD3<Float>]
+    }
+
+    static func newFillHolesTask(with mesh: MeshBuffer, options: Options = Options(),
+                                 completion: @escaping MeshTask.Completion) -> MeshTask {
+        MeshTask(work: { task in
+            try fillHoles(mesh, options: options, task: task)
+        }, completion: completion)
+    }
+
+    static func fillHoles(_ mesh: MeshBuffer, options: Options = Options(), task: MeshTask? = nil) throws -> MeshBuffer {
+        var output = mesh
+        output.validateAttributes()
+        output.submeshes = []
+        let holes = boundaryLoops(output).filter { hole in
+            hole.vertices.count >= 3 && hole.vertices.count <= options.maxHoleVertices
+                && perimeter(of: hole, in: output) <= options.maxHolePerimeter
+        }.sorted { $0.vertices.count > $1.vertices.count } // slowest triangulations start first
+        guard !holes.isEmpty else { return output }
+
+        var patches = [Patch?](repeating: nil, count: holes.count)
+        let progressLock = NSLock()
+        var done = 0
+        let source = output
+        patches.withUnsafeMutableBufferPointer { patchBuffer in
+            let out = patchBuffer
+            DispatchQueue.concurrentPerform(iterations: holes.count) { index in
+                guard task?.isCancelled != true else { return }
+                var patch = Patch(hole: holes[index], mesh: source)
+                if patch.triangulate() {
+                    if options.refine { patch.refine() }
+                    patch.fair(iterations: options.fairingIterations)
+                    if patch.area() <= options.maxPatchArea {
+                        out[index] = patch
+                    }
+                }
+                progressLock.lock()
+                done += 1
+                let fraction = Double(done) / Double(holes.count)
+                progressLock.unlock()
+                task?.report(fraction)
+            }
+        }
+        try task?.checkCancelled()
+
+        let hadNormals = output.hasNormals
+        for case let patch? in patches {
+            let base = UInt32(output.vertexCount)
+            let loop = patch.hole.vertices
+            func global(_ local: Int32) -> UInt32 {
+                Int(local) < loop.count ? loop[Int(local)] : base + UInt32(Int(local) - loop.count)
+            }
+            let added = patch.positions[loop.count...]
+            output.positions.append(contentsOf: added)
+            if output.hasColors {
+                let mean = loop.reduce(SIMD3<Float>.zero) { $0 + output.colors[Int($1)] } / Float(loop.count)
+                output.colors.append(contentsOf: repeatElement(mean, count: added.count))
+            }
+            if output.hasUVs {
+                let mean = loop.reduce(SIMD2<Float>.zero) { $0 + output.uvs[Int($1)] } / Float(loop.count)
+                output.uvs.append(contentsOf: repeatElement(mean, count: added.count))
+            }
+            for triangle in patch.triangles {
+                output.indices.append(global(triangle.x))
+                output.indices.append(global(triangle.y))
+                output.indices.append(global(triangle.z))
+            }
+        }
+        if hadNormals {
+            output.normals = IndexedMesh(positions: output.positions, indices: output.indices).vertexNormals()
+        }
+        return output
+    }
+
+    /// Every closed loop of boundary edges, i.e. edges used by exactly one face.
+    static func boundaryLoops(_ mesh: MeshBuffer) -> [Hole] {
+        // Undirected edge in the high bits, direction in bit 0, so both halves of an edge sort together.
+        var keys = [UInt64](repeating: 0, count: mesh.faceCount * 3)
+        keys.withUnsafeMutableBufferPointer { keyBuffer in
+            let out = keyBuffer
+            Parallel.forEachChunk(count: mesh.faceCount) { _, range in
+                for face in range {
+                    for corner in 0..<3 {
+                        let from = mesh.indices[face * 3 + corner], to = mesh.indices[face * 3 + (corner + 1) % 3]
+                        out[face * 3 + corner] = UInt64(min(from, to)) << 32 | UInt64(max(from, to)) << 1 | (from < to ? 0 : 1)
+                    }
+                }
+            }
+        }
+        keys.sort()
+
+        var next: [UInt32: UInt32] = [:]
+        var run = 0
+        while run < keys.count {
+            var end = run + 1
+            while end < keys.count && keys[end] >> 1 == keys[run] >> 1 { end += 1 }
+            if end - run == 1 {
+                let low = UInt32(keys[run] >> 32), high = UInt32((keys[run] >> 1) & 0x7FFF_FFFF)
+                let (from, to) = keys[run] & 1 == 0 ? (low, high) : (high, low)
+                next[from] = to
+            }
+            run = end
+        }
+        guard !next.isEmpty else { return [] }
+
+        var faceNormal: [UInt64: SIMD3<Float>] = [:]
+        for face in 0..<mesh.faceCount {
+            let corners = mesh.face(face)
+            for corner in 0..<3 {
+                let from = corners[corner], to = corners[(corner + 1) % 3]
+                guard next[from] == to else { continue }
+                let p0 = mesh.positions[Int(corners.x)], p1 = mesh.positions[Int(corners.y)], p2 = mesh.positions[Int(corners.z)]
+                faceNormal[UInt64(from) << 32 | UInt64(to)] = simd_normalize(simd_cross(p1 - p0, p2 - p0))
+            }
+        }
+
+        var holes: [Hole] = []
+        var visited = Set<UInt32>()
+        for start in next.keys where !visited.contains(start) {
+            var hole = Hole(vertices: [], edgeNormals: [])
+            var current = start
+            var closed = false
+            while !visited.contains(current), let to = next[current] {
+                visited.insert(current)
+                hole.vertices.append(current)
+                let normal = faceNormal[UInt64(current) << 32 | UInt64(to)] ?? .zero
+                hole.edgeNormals.append(normal.x.isFinite ? normal : .zero)
+                current = to
+                if current == start {
+                    closed = true
+                    break
+                }
+            }
+            if closed {
+                holes.append(hole)
+            }
+        }
+        return holes
+    }
+
+    static func perimeter(of hole: Hole, in mesh: MeshBuffer) -> Float {
+        var length: Float = 0
+        for k in 0..<hole.vertices.count {
+            let a = mesh.positions[Int(hole.vertices[k])], b = mesh.positions[Int(hole.vertices[(k + 1) % hole.vertices.count])]
+            length += simd_distance(a, b)
+        }
+        return length
+    }
+}
+
+// MARK: - Patch
+
+/// Triangulation of one hole. Local vertices `0..<n` are the loop, later ones are new.
+private struct Patch {
+    let hole: MeshHoleFiller.Hole
+    var positions: [SIMD3<Float>]
+    /// Target edge length around each vertex, used to decide where to refine.
+    var scales: [Float]
+    var triangles: [SIMD3<Int32>] = []
+
+    init(hole: MeshHoleFiller.Hole, mesh: MeshBuffer) {
+        self.hole = hole
+        positions = hole.vertices.map { mesh.positions[Int($0)] }
+        let n = positions.count
+        scales = (0..<n).map { k in
+            let previous = positions[(k + n - 1) % n], current = positions[k], following = positions[(k + 1) % n]
+            return (simd_distance(previous, current) + simd_distance(current, following)) / 2
+        }
+    }
+
+    private func normal(_ a: Int32, _ b: Int32, _ c: Int32) -> SIMD3<Float> {
+        let pa = positions[Int(a)]
+        let cross = simd_cross(positions[Int(b)] - pa, positions[Int(c)] - pa)
+        let length = simd_length(cross)
+        return length > 0 ? cross / length : .zero
+    }
+
+    private static func angle(_ n0: SIMD3<Float>, _ n1: SIMD3<Float>) -> Float {
+        if n0 == .zero || n1 == .zero { return 0 }
+        return acos(max(-1, min(1, simd_dot(n0, n1))))
+    }
+
+    /// Minimum-weight triangulation of the loop; weights compare the largest dihedral angle
+    /// first and the total area second.
+    mutating func triangulate() -> Bool {
+        let n = positions.count
+        var angleWeight = [Float](repeating: 0, count: n * n)
+        var areaWeight = [Float](repeating: 0, count: n * n)
+        var apex = [Int32](repeating: -1, count: n * n)
+
+        // Triangle (i, m, j) of the loop is emitted as (i, j, m) so its edges run against the loop.
+        func triangleNormal(_ i: Int, _ m: Int, _ j: Int) -> SIMD3<Float> {
+            normal(Int32(i), Int32(j), Int32(m))
+        }
+        func neighborNormal(_ i: Int, _ j: Int) -> SIMD3<Float> {
+            if j == i + 1 { return hole.edgeNormals[i] }
+            let m = Int(apex[i * n + j])
+            return triangleNormal(i, m, j)
+        }
+
+        for span in 2..<n {
+            for i in 0..<(n - span) {
+                let j = i + span
+                var bestAngle = Float.greatestFiniteMagnitude, bestArea = Float.greatestFiniteMagnitude
+                var bestApex: Int32 = -1
+                for m in (i + 1)..<j {
+                    if apex[i * n + m] < 0 && m - i >= 2 { continue }
+                    if apex[m * n + j] < 0 && j - m >= 2 { continue }
+                    let pi = positions[i], pm = positions[m], pj = positions[j]
+                    let cross = simd_cross(pj - pi, pm - pi)
+                    let area = simd_length(cross) / 2
+                    guard area > 0 else { continue }
+                    let triangle = cross / (area * 2)
+                    var worst = max(angleWeight[i * n + m], angleWeight[m * n + j])
+                    worst = max(worst, Patch.angle(triangle, neighborNormal(i, m)))
+                    worst = max(worst, Patch.angle(triangle, neighborNormal(m, j)))
+                    if i == 0 && j == n - 1 {
+                        worst = max(worst, Patch.angle(triangle, hole.edgeNormals[n - 1]))
+                    }
+                    let total = areaWeight[i * n + m] + areaWeight[m * n + j] + area
+                    if worst < bestAngle || (worst == bestAngle && total < bestArea) {
+                        bestAngle = worst
+                        bestArea = total
+                        bestApex = Int32(m)
+                    }
+                }
+                angleWeight[i * n + j] = bestAngle
+                areaWeight[i * n + j] = bestArea
+                apex[i * n + j] = bestApex
+            }
+        }
+        guard apex[n - 1] >= 0 else { return false }
+
+        var stack = [(0, n - 1)]
+        while let (i, j) = stack.popLast() {
+            guard j - i >= 2 else { continue }
+            let m = Int(apex[i * n + j])
+            triangles.append(SIMD3(Int32(i), Int32(j), Int32(m)))
+            stack.append((i, m))
+            stack.append((m, j))
+        }
+        return true
+    }
+
+    /// Centroid splits until triangle size matches the scale at the loop, each followed by
+    /// Delaunay edge relaxation.
+    mutating func refine() {
+        let alpha = Float(2).squareRoot()
+        for _ in 0..<8 {
+            var split = false
+            for index in 0..<triangles.count {
+                let t = triangles[index]
+                let corners = [Int(t.x), Int(t.y), Int(t.z)]
+                let centroid = corners.reduce(SIMD3<Float>.zero) { $0 + positions[$1] } / 3
+                let scale = corners.reduce(0) { $0 + scales[$1] } / 3
+                let tooLarge = corners.allSatisfy { corner in
+                    let distance = alpha * simd_distance(centroid, positions[corner])
+                    return distance > scale && distance > scales[corner]
+                }
+                guard tooLarge else { continue }
+                let c = Int32(positions.count)
+                positions.append(centroid)
+                scales.append(scale)
+                triangles[index] = SIMD3(t.x, t.y, c)
+                triangles.append(SIMD3(t.y, t.z, c))
+                triangles.append(SIMD3(t.z, t.x, c))
+                split = true
+            }
+            relax()
+            if !split { break }
+        }
+    }
+
+    /// Flips interior edges whose opposite angles sum to more than pi.
+    mutating func relax() {
+        let loopCount = Int32(hole.vertices.count)
+        func key(_ a: Int32, _ b: Int32) -> UInt64 { UInt64(UInt32(a)) << 32 | UInt64(UInt32(b)) }
+        func isLoopEdge(_ a: Int32, _ b: Int32) -> Bool {
+            a < loopCount && b < loopCount && (abs(a - b) == 1 || abs(a - b) == loopCount - 1)
+        }
+        var owner: [UInt64: Int] = [:]
+        for (index, t) in triangles.enumerated() {
+            for corner in 0..<3 { owner[key(t[corner], t[(corner + 1) % 3])] = index }
+        }
+        for _ in 0..<10 {
+            var flipped = false
+            for index in 0..<triangles.count {
+                for corner in 0..<3 {
+                    let t = triangles[index]
+                    let a = t[corner], b = t[(corner + 1) % 3], c = t[(corner + 2) % 3]
+                    guard a < b, !isLoopEdge(a, b), let other = owner[key(b, a)], other != index else { continue }
+                    let u = triangles[other]
+                    guard let d = [u.x, u.y, u.z].first(where: { $0 != a && $0 != b }), owner[key(c, d)] == nil else { continue }
+                    let pa = positions[Int(a)], pb = positions[Int(b)], pc = positions[Int(c)], pd = positions[Int(d)]
+                    let angleC = acos(max(-1, min(1, simd_dot(simd_normalize(pa - pc), simd_normalize(pb - pc)))))
+                    let angleD = acos(max(-1, min(1, simd_dot(simd_normalize(pa - pd), simd_normalize(pb - pd)))))
+                    guard angleC + angleD > .pi + 1e-4 else { continue }
+                    // Keep the flip only if both new triangles face the same way as the old pair.
+                    let before = normal(a, b, c) + normal(b, a, d)
+                    guard simd_dot(normal(c, a, d), before) > 0, simd_dot(normal(d, b, c), before) > 0 else { continue }
+
+                    for old in [triangles[index], triangles[other]] {
+                        for k in 0..<3 { owner[key(old[k], old[(k + 1) % 3])] = nil }
+                    }
+                    triangles[index] = SIMD3(c, a, d)
+                    triangles[other] = SIMD3(d, b, c)
+                    for updated in [index, other] {
+                        let t = triangles[updated]
+                        for k in 0..<3 { owner[key(t[k], t[(k + 1) % 3])] = updated }
+                    }
+                    flipped = true
+                    break
+                }
+            }
+            if !flipped { break }
+        }
+    }
+
+    /// Umbrella smoothing of the new vertices; the loop stays fixed.
+    mutating func fair(iterations: Int) {
+        let loopCount = hole.vertices.count
+        guard positions.count > loopCount else { return }
+        var neighbors = [[Int32]](repeating: [], count: positions.count)
+        for t in triangles {
+            for corner in 0..<3 {
+                let a = Int(t[corner]), b = t[(corner + 1) % 3]
+                if !neighbors[a].contains(b) { neighbors[a].append(b) }
+                if !neighbors[Int(b)].contains(Int32(a)) { neighbors[Int(b)].append(Int32(a)) }
+            }
+        }
+        for _ in 0..<iterations {
+            let previous = positions
+            for vertex in loopCount..<positions.count where !neighbors[vertex].isEmpty {
+                let sum = neighbors[vertex].reduce(SIMD3<Float>.zero) { $0 + previous[Int($1)] }
+                positions[vertex] = sum / Float(neighbors[vertex].count)
+            }
+        }
+    }
+
+    func area() -> Float {
+        triangles.reduce(0) { total, t in
+            let pa = positions[Int(t.x)]
+            return total + simd_length(simd_cross(positions[Int(t.y)] - pa, positions[Int(t.z)] - pa)) / 2
+        }
+    }
+}
@@ -0,0 +1,127 @@
+//
+//  MeshOrdering.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+
+/// Reorders triangles and vertices for faster drawing.
+///
+/// Triangles are ordered for the GPU's post-transform vertex cache with Tipsify
+/// (Sander et al.), then vertices are renumbered in the order the triangles first
+/// fetch them, so vertex reads stream through memory.
+enum MeshOrdering {
+    /// Vertex cache size assumed by `optimizeVertexCache`.
+    static let cacheSize = 16
+
+    /// `indices` with the triangles reordered for the vertex cache. Vertices are unchanged.
+    static func optimizeVertexCache(_ indices: [UInt32], vertexCount: Int) -> [UInt32] {
+        let faceCount = indices.count / 3
+        guard faceCount > 1 else { return indices }
+
+        // Triangles around each vertex, in compressed rows.
+        var offsets = [Int](repeating: 0, count: vertexCount + 1)
+        for index in indices {
+            offsets[Int(index) + 1] += 1
+        }
+        for vertex in 0..<vertexCount {
+            offsets[vertex + 1] += offsets[vertex]
+        }
+        var cursor = offsets
+        var adjacency = [Int](repeating: 0, count: indices.count)
+        for (corner, index) in indices.enumerated() {
+            adjacency[cursor[Int(index)]] = corner / 3
+            cursor[Int(index)] += 1
+        }
+
+        var live = (0..<vertexCount).map { offsets[$0 + 1] - offsets[$0] }
+        var cacheTime = [Int](repeating: 0, count: vertexCount)
+        var emitted = [Bool](repeating: false, count: faceCount)
+        var deadEnds: [Int] = []
+        var output: [UInt32] = []
+        output.reserveCapacity(indices.count)
+        var time = cacheSize + 1
+        var nextUnused = 0
+        var fan: Int? = indices.first.map { Int($0) }
+
+        while let vertex = fan {
+            var candidates: [Int] = []
+            for face in adjacency[offsets[vertex]..<offsets[vertex + 1]] where !emitted[face] {
+                emitted[face] = true
+                for corner in 0..<3 {
+                    let index = Int(indices[face * 3 + corner])
+                    output.append(UInt32(index))
+                    deadEnds.append(index)
+                    candidates.append(index)
+                    live[index] -= 1
+                    if time - cacheTime[index] > cacheSize {
+                        cacheTime[index] = time
+                        time += 1
+                    }
+                }
+            }
+
+            // Next fan: the candidate still in cache whose remaining triangles fit, oldest first.
+            fan = nil
+            var best = -1
+            for candidate in candidates where live[candidate] > 0 {
+                let age = time - cacheTime[candidate]
+                let priority = age + 2 * live[candidate] <= cacheSize ? age : 0
+                if priority > best {
+                    best = priority
+                    fan = candidate
+                }
+            }
+            if fan == nil {
+                while let recent = deadEnds.popLast() {
+                    if live[recent] > 0 {
+                        fan = recent
+                        break
+                    }
+                }
+            }
+            if fan == nil {
+                while nextUnused < vertexCount {
+                    defer { nextUnused += 1 }
+                    if live[nextUnused] > 0 {
+                        fan = nextUnused
+                        break
+                    }
+                }
+            }
+        }
+        return output
+    }
+
+    /// New position of every vertex when numbered in first-fetch order; unreferenced
+    /// vertices go last, in their original order.
+    static func fetchOrder(_ indices: [UInt32], vertexCount: Int) -> (remap: [UInt32], order: [UInt32]) {
+        var remap = [UInt32](repeating: .max, count: vertexCount)
+        var order: [UInt32] = []
+        order.reserveCapacity(vertexCount)
+        for index in indices where remap[Int(index)] == .max {
+            remap[Int(index)] = UInt32(order.count)
+            order.append(index)
+        }
+        for vertex in 0..<vertexCount where remap[vertex] == .max {
+            remap[vertex] = UInt32(order.count)
+            order.append(UInt32(vertex))
+        }
+        return (remap, order)
+    }
+
+    /// Copy of `mesh` with both orderings applied; attributes follow their vertices.
+    static func optimized(_ mesh: MeshBuffer) -> MeshBuffer {
+        let indices = optimizeVertexCache(mesh.indices, vertexCount: mesh.vertexCount)
+        let (remap, order) = fetchOrder(indices, vertexCount: mesh.vertexCount)
+        var result = MeshBuffer()
+        result.positions = order.map { mesh.positions[Int($0)] }
+        if mesh.hasNormals { result.normals = order.map { mesh.normals[Int($0)] } }
+        if mesh.hasColors { result.colors = order.map { mesh.colors[Int($0)] } }
+        if mesh.hasUVs { result.uvs = order.map { mesh.uvs[Int($0)] } }
+        result.indices = indices.map { remap[Int($0)] }
+        return result
+    }
+}
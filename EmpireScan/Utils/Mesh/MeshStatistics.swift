@@ -0,0 +1,152 @@
+//
+//  MeshStatistics.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Bounds, centroid, element counts and edge lengths of a mesh, gathered in one pass.
+struct MeshStatistics {
+    var min = SIMD3<Float>(repeating: .greatestFiniteMagnitude)
+    var max = SIMD3<Float>(repeating: -.greatestFiniteMagnitude)
+    /// Mean of all vertex positions.
+    var centroid = SIMD3<Float>.zero
+    var vertexCount = 0
+    var faceCount = 0
+    /// Mean and max length over the three edges of every face; shared edges count once per face.
+    var meanEdgeLength: Float = 0
+    var maxEdgeLength: Float = 0
+
+    var isEmpty: Bool { vertexCount == 0 }
+    var center: SIMD3<Float> { (min + max) / 2 }
+    var size: SIMD3<Float> { max - min }
+    var bounds: (SIMD3<Float>, SIMD3<Float>)? { isEmpty ? nil : (min, max) }
+
+    init() {}
+
+    init(_ mesh: MeshBuffer) {
+        let parts = [Part(vertexCount: mesh.vertexCount, faceCount: mesh.faceCount)]
+        self = mesh.positions.withUnsafeBytes { positions in
+            mesh.indices.withUnsafeBytes { indices in
+                MeshStatistics.compute(parts, vertices: [positions.baseAddress], vertexStride: MemoryLayout<SIMD3<Float>>.stride,
+                                       faces: [indices.baseAddress])
+            }
+        }
+    }
+
+    /// Sizes of one partial mesh.
+    struct Part {
+        let vertexCount: Int
+        let faceCount: Int
+    }
+
+    /// Reduces the partial meshes described by `parts` without copying them.
+    ///
+    /// `vertices[i]` holds `parts[i].vertexCount` float triples `vertexStride` bytes apart;
+    /// `faces[i]` holds `3 * parts[i].faceCount` `UInt32` indices local to that part. Vertex
+    /// and face ranges of all parts are cut into chunks and reduced concurrently.
+    static func compute(_ parts: [Part], vertices: [UnsafeRawPointer?], vertexStride: Int, faces: [UnsafeRawPointer?]) -> MeshStatistics {
+        struct Job {
+            let part: Int
+            let range: Range<Int>
+            let isFaces: Bool
+        }
+        let chunk = 16_384
+        var jobs: [Job] = []
+        for (index, part) in parts.enumerated() {
+            if vertices[index] == nil { continue }
+            for start in stride(from: 0, to: part.vertexCount, by: chunk) {
+                jobs.append(Job(part: index, range: start..<Swift.min(part.vertexCount, start + chunk), isFaces: false))
+            }
+            if faces[index] == nil { continue }
+            for start in stride(from: 0, to: part.faceCount, by: chunk) {
+                jobs.append(Job(part: index, range: start..<Swift.min(part.faceCount, start + chunk), isFaces: true))
+            }
+        }
+
+        var partials = [Partial](repeating: Partial(), count: jobs.count)
+        partials.withUnsafeMutableBufferPointer { partialBuffer in
+            let out = partialBuffer
+            DispatchQueue.concurrentPerform(iterations: jobs.count) { jobIndex in
+                let job = jobs[jobIndex]
+                let base = vertices[job.part]!
+                @inline(__always) func vertex(_ index: Int) -> SIMD3<Float> {
+                    let offset = index * vertexStride
+                    return SIMD3(base.load(fromByteOffset: offset, as: Float.self),
+                                 base.load(fromByteOffset: offset + 4, as: Float.self),
+                                 base.load(fromByteOffset: offset + 8, as: Float.self))
+                }
+
+                var partial = Partial()
+                if job.isFaces {
+                    let indices = faces[job.part]!
+                    let limit = UInt32(parts[job.part].vertexCount)
+                    for face in job.range {
+                        let a = indices.load(fromByteOffset: face * 12, as: UInt32.self)
+                        let b = indices.load(fromByteOffset: face * 12 + 4, as: UInt32.self)
+                        let c = indices.load(fromByteOffset: face * 12 + 8, as: UInt32.self)
+                        partial.faceCount += 1
+                        guard a < limit && b < limit && c < limit else { continue }
+                        let p0 = vertex(Int(a)), p1 = vertex(Int(b)), p2 = vertex(Int(c))
+                        let lengths = SIMD3(simd_distance(p0, p1), simd_distance(p1, p2), simd_distance(p2, p0))
+                        partial.edgeSum += Double(lengths.sum())
+                        partial.edgeMax = Swift.max(partial.edgeMax, lengths.max())
+                        partial.edgeCount += 3
+                    }
+                } else {
+                    var sum = SIMD3<Double>.zero
+                    for index in job.range {
+                        let p = vertex(index)
+                        partial.min = simd_min(partial.min, p)
+                        partial.max = simd_max(partial.max, p)
+                        sum += SIMD3<Double>(p)
+                    }
+                    partial.sum = sum
+                    partial.vertexCount = job.range.count
+                }
+                out[jobIndex] = partial
+            }
+        }
+
+        var total = Partial()
+        for partial in partials {
+            total.merge(partial)
+        }
+        var result = MeshStatistics()
+        result.vertexCount = total.vertexCount
+        result.faceCount = parts.reduce(0) { $0 + $1.faceCount }
+        guard total.vertexCount > 0 else { return result }
+        result.min = total.min
+        result.max = total.max
+        result.centroid = SIMD3<Float>(total.sum / Double(total.vertexCount))
+        result.meanEdgeLength = total.edgeCount > 0 ? Float(total.edgeSum / Double(total.edgeCount)) : 0
+        result.maxEdgeLength = total.edgeMax
+        return result
+    }
+
+    /// Running totals of one chunk.
+    private struct Partial {
+        var min = SIMD3<Float>(repeating: .greatestFiniteMagnitude)
+        var max = SIMD3<Float>(repeating: -.greatestFiniteMagnitude)
+        var sum = SIMD3<Double>.zero
+        var vertexCount = 0
+        var faceCount = 0
+        var edgeSum: Double = 0
+        var edgeCount = 0
+        var edgeMax: Float = 0
+
+        mutating func merge(_ other: Partial) {
+            min = simd_min(min, other.min)
+            max = simd_max(max, other.max)
+            sum += other.sum
+            vertexCount += other.vertexCount
+            faceCount += other.faceCount
+            edgeSum += other.edgeSum
+            edgeCount += other.edgeCount
+            edgeMax = Swift.max(edgeMax, other.edgeMax)
+        }
+    }
+}
@@ -0,0 +1,110 @@
+//
+//  MeshTask.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+
+/// Controls shared by `MeshTask` and `STBackgroundTask`, so callers can hold either.
+protocol CancellableTask: AnyObject {
+    var isCancelled: Bool { get }
+    func start()
+    func cancel()
+}
+
+protocol MeshTaskDelegate: AnyObject {
+    /// Called on a background thread with a value from 0 (not started) to 1 (completed).
+    func meshTask(_ sender: MeshTask, didUpdateProgress progress: Double)
+}
+
+/// Mesh processing job run on a background queue, modelled on `STBackgroundTask`.
+///
+/// The work closure reports progress through `report(_:)` and polls `checkCancelled()`
+/// at safe points. A cancelled task still calls its completion handler, with
+/// `MeshTask.cancelledError`, so callers can release what they hold.
+final class MeshTask: CancellableTask {
+    typealias Work = (MeshTask) throws -> MeshBuffer
+    typealias Completion = (MeshBuffer?, Error?) -> Void
+
+    static let cancelledError = NSError(domain: "MeshTask", code: NSUserCancelledError,
+                                        userInfo: [NSLocalizedDescriptionKey: "The mesh task was cancelled"])
+
+    weak var delegate: MeshTaskDelegate?
+
+    private let work: Work
+    private let completion: Completion
+    private let lock = NSLock()
+    private let finished = DispatchGroup()
+    private var cancelled = false
+    private var started = false
+    private var lastReported: Double = -1
+
+    init(work: @escaping Work, completion: @escaping Completion) {
+        self.work = work
+        self.completion = completion
+    }
+
+    var isCancelled: Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        return cancelled
+    }
+
+    /// Starts the work on a global background queue. Later calls do nothing.
+    func start() {
+        lock.lock()
+        let shouldStart = !started
+        started = true
+        lock.unlock()
+        guard shouldStart else { return }
+
+        finished.enter()
+        DispatchQueue.global(qos: .userInitiated).async {
+            defer { self.finished.leave() }
+            do {
+                let mesh = try self.work(self)
+                if self.isCancelled {
+                    self.completion(nil, MeshTask.cancelledError)
+                } else {
+                    self.report(1)
+                    self.completion(mesh, nil)
+                }
+            } catch {
+                self.completion(nil, error)
+            }
+        }
+    }
+
+    /// Asks the work to stop at its next cancellation point.
+    func cancel() {
+        lock.lock()
+        cancelled = true
+        lock.unlock()
+    }
+
+    func waitUntilCompletion() {
+        finished.wait()
+    }
+
+    /// Forwards progress to the delegate, skipping updates smaller than 1%.
+    /// Safe to call from any thread.
+    func report(_ progress: Double) {
+        let progress = min(1, max(0, progress))
+        lock.lock()
+        let shouldReport = progress >= 1 || progress - lastReported >= 0.01
+        if shouldReport { lastReported = progress }
+        lock.unlock()
+        if shouldReport {
+            delegate?.meshTask(self, didUpdateProgress: progress)
+        }
+    }
+
+    /// Throws `cancelledError` once `cancel()` has been called.
+    func checkCancelled() throws {
+        if isCancelled {
+            throw MeshTask.cancelledError
+        }
+    }
+}
@@ -0,0 +1,228 @@
+//
+//  MeshWelder.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Triangle mesh with shared vertices.
+struct IndexedMesh {
+    var positions: [SIMD3<Float>]
+    var indices: [UInt32]
+
+    var faceCount: Int { indices.count / 3 }
+
+    /// Area-weighted smooth vertex normals.
+    func vertexNormals() -> [SIMD3<Float>] {
+        var normals = [SIMD3<Float>](repeating: .zero, count: positions.count)
+        for face in 0..<faceCount {
+            let a = Int(indices[face * 3]), b = Int(indices[face * 3 + 1]), c = Int(indices[face * 3 + 2])
+            let normal = simd_cross(positions[b] - positions[a], positions[c] - positions[a])
+            normals[a] += normal
+            normals[b] += normal
+            normals[c] += normal
+        }
+        normals.withUnsafeMutableBufferPointer { normalBuffer in
+            let buffer = normalBuffer
+            Parallel.forEachChunk(count: buffer.count) { _, range in
+                for i in range {
+                    let length = simd_length(buffer[i])
+                    buffer[i] = length > 0 ? buffer[i] / length : SIMD3<Float>(0, 0, 1)
+                }
+            }
+        }
+        return normals
+    }
+}
+
+/// Merges coincident vertices of a triangle soup.
+///
+/// Positions are snapped to a grid of cell size `epsilon`; vertices falling in the same
+/// cell are merged. Cells are sharded by hash so each shard is welded by exactly one
+/// thread, which keeps the pass free of locks while using every core.
+enum MeshWelder {
+    /// Default weld distance in mesh units (meters for Structure scans).
+    static let defaultEpsilon: Float = 1e-5
+
+    /// Welds a triangle soup where every three consecutive positions form a face.
+    /// Faces that collapse to a line or point are dropped.
+    static func weld(soup positions: [SIMD3<Float>], epsilon: Float = defaultEpsilon) -> IndexedMesh {
+        let (welded, remap) = weld(positions, epsilon: epsilon)
+        var indices = [UInt32]()
+        indices.reserveCapacity(remap.count)
+        var face = 0
+        while face + 2 < remap.count {
+            let a = remap[face], b = remap[face + 1], c = remap[face + 2]
+            if a != b && b != c && a != c {
+                indices.append(a)
+                indices.append(b)
+                indices.append(c)
+            }
+            face += 3
+        }
+        return IndexedMesh(positions: welded, indices: indices)
+    }
+
+    /// Returns the unique positions, in order of first occurrence, and for every input
+    /// position the index of the unique position it was merged into.
+    static func weld(_ positions: [SIMD3<Float>], epsilon: Float = defaultEpsilon) -> (positions: [SIMD3<Float>], remap: [UInt32]) {
+        let count = positions.count
+        guard count > 0 else { return ([], []) }
+        let inverseCell = 1 / max(epsilon, .leastNormalMagnitude)
+        let shardCount = 1 << 8
+        let shardMask = UInt32(shardCount - 1)
+
+        // 1. Cell of every vertex and the shard owning that cell.
+        var cells = [SIMD3<Int32>](repeating: .zero, count: count)
+        var shards = [UInt16](repeating: 0, count: count)
+        let chunkCount = Parallel.chunkCount(for: count)
+        var histograms = [Int](repeating: 0, count: chunkCount * shardCount)
+        positions.withUnsafeBufferPointer { points in
+            cells.withUnsafeMutableBufferPointer { cellBuffer in
+                shards.withUnsafeMutableBufferPointer { shardBuffer in
+                    histograms.withUnsafeMutableBufferPointer { histogramBuffer in
+                        let cellOut = cellBuffer, shardOut = shardBuffer, histogram = histogramBuffer
+                        Parallel.forEachChunk(count: count) { chunk, range in
+                            for i in range {
+                                let cell = cellOf(points[i], inverseCell: inverseCell)
+                                let shard = Int(hash(cell) & shardMask)
+                                cellOut[i] = cell
+                                shardOut[i] = UInt16(shard)
+                                histogram[chunk * shardCount + shard] += 1
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // 2. Counting sort of vertex ids by shard; within a shard ids stay in input order.
+        var shardStart = [Int](repeating: 0, count: shardCount + 1)
+        var slot = [Int](repeating: 0, count: chunkCount * shardCount)
+        var running = 0
+        for shard in 0..<shardCount {
+            shardStart[shard] = running
+            for chunk in 0..<chunkCount {
+                slot[chunk * shardCount + shard] = running
+                running += histograms[chunk * shardCount + shard]
+            }
+        }
+        shardStart[shardCount] = running
+        let shardBounds = shardStart
+
+        var order = [UInt32](repeating: 0, count: count)
+        order.withUnsafeMutableBufferPointer { orderBuffer in
+            slot.withUnsafeMutableBufferPointer { slotBuffer in
+                shards.withUnsafeBufferPointer { shardBuffer in
+                    let orderOut = orderBuffer, slots = slotBuffer
+                    Parallel.forEachChunk(count: count) { chunk, range in
+                        for i in range {
+                            let key = chunk * shardCount + Int(shardBuffer[i])
+                            orderOut[slots[key]] = UInt32(i)
+                            slots[key] += 1
+                        }
+                    }
+                }
+            }
+        }
+
+        // 3. Weld each shard independently: every vertex points at the first vertex of its cell.
+        var representative = [UInt32](repeating: 0, count: count)
+        representative.withUnsafeMutableBufferPointer { representativeBuffer in
+            order.withUnsafeBufferPointer { orderBuffer in
+                cells.withUnsafeBufferPointer { cellBuffer in
+                    let representativeOut = representativeBuffer
+                    DispatchQueue.concurrentPerform(iterations: shardCount) { shard in
+                        let range = shardBounds[shard]..<shardBounds[shard + 1]
+                        var firstInCell = [SIMD3<Int32>: UInt32](minimumCapacity: range.count)
+                        for position in range {
+                            let vertex = orderBuffer[position]
+                            let cell = cellBuffer[Int(vertex)]
+                            if let first = firstInCell[cell] {
+                                representativeOut[Int(vertex)] = first
+                            } else {
+                                firstInCell[cell] = vertex
+                                representativeOut[Int(vertex)] = vertex
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // 4. Number the representatives in input order and remap everything else to them.
+        var newIndex = [UInt32](repeating: 0, count: count)
+        var uniqueInChunk = [Int](repeating: 0, count: chunkCount)
+        representative.withUnsafeBufferPointer { representatives in
+            uniqueInChunk.withUnsafeMutableBufferPointer { uniqueBuffer in
+                let unique = uniqueBuffer
+                Parallel.forEachChunk(count: count) { chunk, range in
+                    var found = 0
+                    for i in range where representatives[i] == UInt32(i) {
+                        found += 1
+                    }
+                    unique[chunk] = found
+                }
+            }
+        }
+        var chunkStart = [Int](repeating: 0, count: chunkCount)
+        var uniqueCount = 0
+        for chunk in 0..<chunkCount {
+            chunkStart[chunk] = uniqueCount
+            uniqueCount += uniqueInChunk[chunk]
+        }
+        let chunkBase = chunkStart
+
+        var welded = [SIMD3<Float>](repeating: .zero, count: uniqueCount)
+        representative.withUnsafeBufferPointer { representatives in
+            newIndex.withUnsafeMutableBufferPointer { newIndexBuffer in
+                welded.withUnsafeMutableBufferPointer { weldedBuffer in
+                    positions.withUnsafeBufferPointer { points in
+                        let newIndexOut = newIndexBuffer, weldedOut = weldedBuffer
+                        Parallel.forEachChunk(count: count) { chunk, range in
+                            var next = chunkBase[chunk]
+                            for i in range where representatives[i] == UInt32(i) {
+                                newIndexOut[i] = UInt32(next)
+                                weldedOut[next] = points[i]
+                                next += 1
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        var remap = [UInt32](repeating: 0, count: count)
+        remap.withUnsafeMutableBufferPointer { remapBuffer in
+            representative.withUnsafeBufferPointer { representatives in
+                newIndex.withUnsafeBufferPointer { newIndices in
+                    let remapOut = remapBuffer
+                    Parallel.forEachChunk(count: count) { _, range in
+                        for i in range {
+                            remapOut[i] = newIndices[Int(representatives[i])]
+                        }
+                    }
+                }
+            }
+        }
+        return (welded, remap)
+    }
+
+    /// Grid cell of `point`; non-finite coordinates land in the outermost cell.
+    @inline(__always)
+    static func cellOf(_ point: SIMD3<Float>, inverseCell: Float) -> SIMD3<Int32> {
+        let limit: Float = 1e9
+        let scaled = (point * inverseCell).rounded(.down)
+        return SIMD3<Int32>(Int32(max(-limit, min(limit, scaled.x))),
+                            Int32(max(-limit, min(limit, scaled.y))),
+                            Int32(max(-limit, min(limit, scaled.z))))
+    }
+
+    @inline(__always)
+    private static func hash(_ cell: SIMD3<Int32>) -> UInt32 {
+        (UInt32(bitPattern: cell.x) &* 73_856_093) ^ (UInt32(bitPattern: cell.y) &* 19_349_663) ^ (UInt32(bitPattern: cell.z) &* 83_492_791)
+    }
+}
@@ -0,0 +1,38 @@
+//
+//  Parallel.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+
+/// Small helpers for splitting mesh work across all cores.
+enum Parallel {
+    static var coreCount: Int { ProcessInfo.processInfo.activeProcessorCount }
+
+    /// Number of contiguous chunks `count` items should be split into.
+    static func chunkCount(for count: Int, minChunk: Int = 4096) -> Int {
+        guard count > 0 else { return 0 }
+        return max(1, min(coreCount * 4, count / max(1, minChunk)))
+    }
+
+    /// Splits `0..<count` into contiguous ranges and runs `body` on them concurrently.
+    /// Small inputs run inline on the calling thread.
+    static func forEachChunk(count: Int, minChunk: Int = 4096, _ body: (_ chunk: Int, _ range: Range<Int>) -> Void) {
+        let chunks = chunkCount(for: count, minChunk: minChunk)
+        guard chunks > 0 else { return }
+        if chunks == 1 {
+            body(0, 0..<count)
+            return
+        }
+        let size = (count + chunks - 1) / chunks
+        DispatchQueue.concurrentPerform(iterations: chunks) { chunk in
+            let lower = chunk * size
+            let upper = min(count, lower + size)
+            if lower < upper {
+                body(chunk, lower..<upper)
+            }
+        }
+    }
+}
@@ -0,0 +1,358 @@
+//
+//  PoissonReconstructor.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Screened Poisson surface reconstruction (Kazhdan & Hoppe, 2013) from oriented mesh vertices.
+///
+/// Vertex normals, weighted by vertex area, are splatted into a padded cubic grid. The
+/// indicator function is solved with a multigrid V-cycle whose red-black Gauss-Seidel
+/// smoother runs across all cores, and the surface is extracted with marching cubes.
+/// Memory is fixed by the grid depth, which is capped by `Options.memoryBudget`.
+enum PoissonReconstructor {
+    enum Mode {
+        /// Strong screening: the surface stays on the scan and only gaps are bridged.
+        case closedHull
+        /// Weak screening: a smoother surface that favours closing over fidelity.
+        case watertight
+
+        var screening: Float {
+            switch self {
+            case .closedHull: return 8
+            case .watertight: return 0.5
+            }
+        }
+    }
+
+    struct Options {
+        var mode: Mode = .closedHull
+        /// Grid resolution is `2^depth` cells per side.
+        var maxDepth = 8
+        var minDepth = 5
+        /// Peak working memory allowed; the depth is lowered until the estimate fits.
+        var memoryBudget = 256 << 20
+        /// Empty margin around the scan, as a fraction of its largest extent.
+        var padding: Float = 0.1
+        var vCycles = 6
+        var smoothingSteps = 3
+    }
+
+    /// Peak bytes used at `depth`: the finest level plus the splatted normal field, then
+    /// the solver levels, then the extraction edge table, whichever is largest.
+    static func estimatedBytes(depth: Int) -> Int {
+        let cells = 1 << (3 * depth)
+        let level = cells * 4 * MemoryLayout<Float>.size
+        let solver = level * 8 / 7
+        let splat = level + cells * MemoryLayout<SIMD3<Float>>.stride
+        let extraction = cells * (MemoryLayout<Float>.size + 3 * MemoryLayout<Int32>.size)
+        return max(solver, splat, extraction)
+    }
+
+    static func depth(for options: Options) -> Int {
+        var depth = options.maxDepth
+        while depth > options.minDepth && estimatedBytes(depth: depth) > options.memoryBudget {
+            depth -= 1
+        }
+        return depth
+    }
+
+    static func newReconstructTask(with mesh: MeshBuffer, options: Options = Options(),
+                                   completion: @escaping MeshTask.Completion) -> MeshTask {
+        MeshTask(work: { task in
+            try reconstruct(mesh, options: options, task: task)
+        }, completion: completion)
+    }
+
+    static func reconstruct(_ mesh: MeshBuffer, options: Options = Options(), task: MeshTask? = nil) throws -> MeshBuffer {
+        var input = mesh
+        input.validateAttributes()
+        guard input.faceCount > 0 else { return MeshBuffer() }
+        let indexed = IndexedMesh(positions: input.positions, indices: input.indices)
+        let normals = input.hasNormals ? input.normals : indexed.vertexNormals()
+        let areas = vertexAreas(indexed)
+
+        let depth = depth(for: options)
+        let n = 1 << depth
+        let statistics = MeshStatistics(input)
+        let side = simd_reduce_max(statistics.size) * (1 + 2 * options.padding)
+        let h = side / Float(n)
+        let origin = statistics.center - SIMD3(repeating: side / 2)
+        task?.report(0.05)
+
+        // Right-hand side of  Δu - s u = ∇·V - s / 2,  u = 0 outside the grid.
+        let finest = Level(n: n, h: h)
+        splat(input.positions, normals: normals, areas: areas, into: finest, origin: origin, screening: options.mode.screening)
+        try task?.checkCancelled()
+        task?.report(0.2)
+
+        var levels = [finest]
+        while levels.last!.n > 4 {
+            let coarse = Level(n: levels.last!.n / 2, h: levels.last!.h * 2)
+            levels.last!.restrictScreening(into: coarse)
+            levels.append(coarse)
+        }
+        for cycle in 0..<options.vCycles {
+            vCycle(levels, level: 0, steps: options.smoothingSteps)
+            try task?.checkCancelled()
+            task?.report(0.2 + 0.6 * Double(cycle + 1) / Double(options.vCycles))
+        }
+        levels.removeSubrange(1...)
+
+        // The surface passes through the area-weighted mean of u at the samples.
+        var weightedSum: Double = 0
+        var weightTotal: Double = 0
+        for (index, position) in input.positions.enumerated() where areas[index] > 0 {
+            weightedSum += Double(finest.sample((position - origin) / h - 0.5) * areas[index])
+            weightTotal += Double(areas[index])
+        }
+        let isoValue = weightTotal > 0 ? Float(weightedSum / weightTotal) : 0.5
+        finest.releaseSolverBuffers()
+
+        let grid = MarchingCubes.Grid(values: UnsafeBufferPointer(finest.u), size: SIMD3(repeating: n),
+                                      origin: origin + SIMD3(repeating: h / 2), spacing: h)
+        var output = MarchingCubes.extract(grid, isoValue: isoValue, insideIsBelow: false)
+        if input.hasNormals {
+            output.normals = IndexedMesh(positions: output.positions, indices: output.indices).vertexNormals()
+        }
+        return output
+    }
+
+    /// A third of the area of every face around each vertex.
+    private static func vertexAreas(_ mesh: IndexedMesh) -> [Float] {
+        var areas = [Float](repeating: 0, count: mesh.positions.count)
+        for face in 0..<mesh.faceCount {
+            let a = Int(mesh.indices[face * 3]), b = Int(mesh.indices[face * 3 + 1]), c = Int(mesh.indices[face * 3 + 2])
+            let area = simd_length(simd_cross(mesh.positions[b] - mesh.positions[a], mesh.positions[c] - mesh.positions[a])) / 6
+            areas[a] += area
+            areas[b] += area
+            areas[c] += area
+        }
+        return areas
+    }
+
+    /// Splats the inward normal field and screening weights with trilinear weights, then
+    /// fills `level.f` with the right-hand side and `level.s` with the screening term.
+    ///
+    /// Samples are bucketed by the lower z-plane they touch; even and odd buckets run in
+    /// two rounds so no two threads write the same plane.
+    private static func splat(_ positions: [SIMD3<Float>], normals: [SIMD3<Float>], areas: [Float],
+                              into level: Level, origin: SIMD3<Float>, screening: Float) {
+        let n = level.n, h = level.h
+        let cells = n * n * n
+        let field = UnsafeMutableBufferPointer<SIMD3<Float>>.allocate(capacity: cells)
+        field.initialize(repeating: .zero)
+        defer { field.deallocate() }
+        let weight = level.s
+        weight.initialize(repeating: 0)
+
+        var buckets = [[Int32]](repeating: [], count: n)
+        for (index, position) in positions.enumerated() where areas[index] > 0 {
+            let z = Int(((position.z - origin.z) / h - 0.5).rounded(.down))
+            buckets[max(0, min(n - 1, z))].append(Int32(index))
+        }
+        let cellVolume = h * h * h
+        let bucketed = buckets
+        for parity in 0..<2 {
+            DispatchQueue.concurrentPerform(iterations: (n + 1 - parity) / 2) { slot in
+                for index in bucketed[slot * 2 + parity] {
+                    let i = Int(index)
+                    let local = (positions[i] - origin) / h - 0.5
+                    let base = SIMD3<Int>(Int(local.x.rounded(.down)), Int(local.y.rounded(.down)), Int(local.z.rounded(.down)))
+                    let t = local - SIMD3<Float>(base)
+                    let density = areas[i] / cellVolume
+                    for corner in 0..<8 {
+                        let offset = SIMD3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1)
+                        let cell = base &+ offset
+                        guard cell.x >= 0 && cell.y >= 0 && cell.z >= 0 && cell.x < n && cell.y < n && cell.z < n else { continue }
+                        let w = (offset.x == 1 ? t.x : 1 - t.x) * (offset.y == 1 ? t.y : 1 - t.y) * (offset.z == 1 ? t.z : 1 - t.z)
+                        let c = level.index(cell.x, cell.y, cell.z)
+                        field[c] -= normals[i] * (w * density)
+                        weight[c] += w * density
+                    }
+                }
+            }
+        }
+
+        let f = level.f
+        DispatchQueue.concurrentPerform(iterations: n) { z in
+            for y in 0..<n {
+                for x in 0..<n {
+                    let c = level.index(x, y, z)
+                    var divergence: Float = 0
+                    if x > 0 { divergence -= field[c - 1].x }
+                    if x < n - 1 { divergence += field[c + 1].x }
+                    if y > 0 { divergence -= field[c - n].y }
+                    if y < n - 1 { divergence += field[c + n].y }
+                    if z > 0 { divergence -= field[c - n * n].z }
+                    if z < n - 1 { divergence += field[c + n * n].z }
+                    let s = screening * weight[c] / h
+                    weight[c] = s
+                    f[c] = divergence / (2 * h) - s / 2
+                }
+            }
+        }
+    }
+
+    private static func vCycle(_ levels: [Level], level: Int, steps: Int) {
+        let current = levels[level]
+        guard level + 1 < levels.count else {
+            current.smooth(steps: 32)
+            return
+        }
+        current.smooth(steps: steps)
+        current.computeResidual()
+        let coarse = levels[level + 1]
+        current.restrictResidual(into: coarse)
+        coarse.u.initialize(repeating: 0)
+        vCycle(levels, level: level + 1, steps: steps)
+        current.addProlongedCorrection(from: coarse)
+        current.smooth(steps: steps)
+    }
+}
+
+// MARK: - Grid level
+
+/// One multigrid level: unknowns `u`, right-hand side `f`, screening `s` and residual `r`
+/// on an `n^3` cell-centred grid. Buffers are raw so slabs can be updated concurrently.
+private final class Level {
+    let n: Int
+    let h: Float
+    let u: UnsafeMutableBufferPointer<Float>
+    private(set) var f: UnsafeMutableBufferPointer<Float>
+    private(set) var s: UnsafeMutableBufferPointer<Float>
+    private(set) var r: UnsafeMutableBufferPointer<Float>
+
+    init(n: Int, h: Float) {
+        self.n = n
+        self.h = h
+        let cells = n * n * n
+        u = .allocate(capacity: cells)
+        f = .allocate(capacity: cells)
+        s = .allocate(capacity: cells)
+        r = .allocate(capacity: cells)
+        u.initialize(repeating: 0)
+        f.initialize(repeating: 0)
+        s.initialize(repeating: 0)
+        r.initialize(repeating: 0)
+    }
+
+    deinit {
+        u.deallocate()
+        f.deallocate()
+        s.deallocate()
+        r.deallocate()
+    }
+
+    @inline(__always)
+    func index(_ x: Int, _ y: Int, _ z: Int) -> Int {
+        x + n * (y + n * z)
+    }
+
+    /// Sum of the six neighbours of cell (x, y, z), with zero outside the grid.
+    @inline(__always)
+    private func neighborSum(_ x: Int, _ y: Int, _ z: Int, _ c: Int) -> Float {
+        var sum: Float = 0
+        if x > 0 { sum += u[c - 1] }
+        if x < n - 1 { sum += u[c + 1] }
+        if y > 0 { sum += u[c - n] }
+        if y < n - 1 { sum += u[c + n] }
+        if z > 0 { sum += u[c - n * n] }
+        if z < n - 1 { sum += u[c + n * n] }
+        return sum
+    }
+
+    /// Red-black Gauss-Seidel; cells of one colour only read the other, so z-planes run in parallel.
+    func smooth(steps: Int) {
+        let inverseH2 = 1 / (h * h)
+        for _ in 0..<steps {
+            for color in 0..<2 {
+                DispatchQueue.concurrentPerform(iterations: n) { z in
+                    for y in 0..<n {
+                        var x = (y + z + color) & 1
+                        while x < n {
+                            let c = index(x, y, z)
+                            u[c] = (neighborSum(x, y, z, c) * inverseH2 - f[c]) / (6 * inverseH2 + s[c])
+                            x += 2
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    func computeResidual() {
+        let inverseH2 = 1 / (h * h)
+        DispatchQueue.concurrentPerform(iterations: n) { z in
+            for y in 0..<n {
+                for x in 0..<n {
+                    let c = index(x, y, z)
+                    let applied = (neighborSum(x, y, z, c) - 6 * u[c]) * inverseH2 - s[c] * u[c]
+                    r[c] = f[c] - applied
+                }
+            }
+        }
+    }
+
+    /// Averages each 2x2x2 block of `values` into one coarse cell.
+    private func average(_ values: UnsafeMutableBufferPointer<Float>, into coarse: UnsafeMutableBufferPointer<Float>, coarseN: Int) {
+        DispatchQueue.concurrentPerform(iterations: coarseN) { z in
+            for y in 0..<coarseN {
+                for x in 0..<coarseN {
+                    var sum: Float = 0
+                    for corner in 0..<8 {
+                        sum += values[index(x * 2 + (corner & 1), y * 2 + ((corner >> 1) & 1), z * 2 + ((corner >> 2) & 1))]
+                    }
+                    coarse[x + coarseN * (y + coarseN * z)] = sum / 8
+                }
+            }
+        }
+    }
+
+    func restrictScreening(into coarse: Level) {
+        average(s, into: coarse.s, coarseN: coarse.n)
+    }
+
+    func restrictResidual(into coarse: Level) {
+        average(r, into: coarse.f, coarseN: coarse.n)
+    }
+
+    func addProlongedCorrection(from coarse: Level) {
+        DispatchQueue.concurrentPerform(iterations: n) { z in
+            for y in 0..<n {
+                for x in 0..<n {
+                    u[index(x, y, z)] += coarse.u[coarse.index(x / 2, y / 2, z / 2)]
+                }
+            }
+        }
+    }
+
+    /// Trilinear value of `u` at continuous cell coordinates.
+    func sample(_ point: SIMD3<Float>) -> Float {
+        let base = SIMD3<Int>(Int(point.x.rounded(.down)), Int(point.y.rounded(.down)), Int(point.z.rounded(.down)))
+        let t = point - SIMD3<Float>(base)
+        var value: Float = 0
+        for corner in 0..<8 {
+            let offset = SIMD3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1)
+            let cell = base &+ offset
+            guard cell.x >= 0 && cell.y >= 0 && cell.z >= 0 && cell.x < n && cell.y < n && cell.z < n else { continue }
+            let w = (offset.x == 1 ? t.x : 1 - t.x) * (offset.y == 1 ? t.y : 1 - t.y) * (offset.z == 1 ? t.z : 1 - t.z)
+            value += w * u[index(cell.x, cell.y, cell.z)]
+        }
+        return value
+    }
+
+    /// Frees everything but `u` ahead of surface extraction.
+    func releaseSolverBuffers() {
+        for buffer in [f, s, r] {
+            buffer.deallocate()
+        }
+        f = .allocate(capacity: 0)
+        s = .allocate(capacity: 0)
+        r = .allocate(capacity: 0)
+    }
+}
@@ -0,0 +1,132 @@
+//
+//  STLFile.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Read-only view over a binary STL file.
+///
+/// The file is memory-mapped and its 50-byte triangle records are read in place,
+/// so opening a large scan does not allocate anything per triangle.
+struct STLFile {
+    static let headerSize = 84
+    static let recordSize = 50
+
+    /// One triangle record, read straight from the mapped bytes.
+    struct Record {
+        fileprivate let base: UnsafeRawPointer
+
+        var normal: SIMD3<Float> { vector(at: 0) }
+        var v0: SIMD3<Float> { vector(at: 12) }
+        var v1: SIMD3<Float> { vector(at: 24) }
+        var v2: SIMD3<Float> { vector(at: 36) }
+        var attributeByteCount: UInt16 { UInt16(littleEndian: base.loadUnaligned(fromByteOffset: 48, as: UInt16.self)) }
+
+        /// Normal stored in the file, or the winding normal when the exporter left it zeroed.
+        var faceNormal: SIMD3<Float> {
+            let stored = normal
+            if simd_length_squared(stored) > 0 {
+                return stored
+            }
+            let cross = simd_cross(v1 - v0, v2 - v0)
+            let length = simd_length(cross)
+            return length > 0 ? cross / length : stored
+        }
+
+        @inline(__always)
+        private func vector(at offset: Int) -> SIMD3<Float> {
+            SIMD3<Float>(base.loadUnaligned(fromByteOffset: offset, as: Float.self),
+                         base.loadUnaligned(fromByteOffset: offset + 4, as: Float.self),
+                         base.loadUnaligned(fromByteOffset: offset + 8, as: Float.self))
+        }
+    }
+
+    /// Random access collection of the records of a mapped file.
+    /// Only valid inside `withRecords`.
+    struct Records: RandomAccessCollection {
+        fileprivate let base: UnsafeRawPointer
+        let count: Int
+
+        var startIndex: Int { 0 }
+        var endIndex: Int { count }
+
+        subscript(index: Int) -> Record {
+            precondition(index >= 0 && index < count, "STL record index out of range")
+            return Record(base: base + STLFile.headerSize + index * STLFile.recordSize)
+        }
+    }
+
+    let data: Data
+    let triangleCount: Int
+
+    /// Maps the file at `url` instead of reading it into memory.
+    init(url: URL) throws {
+        let data = try Data(contentsOf: url, options: .alwaysMapped)
+        try self.init(data: data)
+    }
+
+    init(data: Data) throws {
+        guard data.count >= STLFile.headerSize else {
+            throw STLFile.error(1, "Invalid STL file size")
+        }
+        let count = data.withUnsafeBytes { Int(UInt32(littleEndian: $0.loadUnaligned(fromByteOffset: 80, as: UInt32.self))) }
+        guard data.count >= STLFile.headerSize + count * STLFile.recordSize else {
+            let isASCII = data.prefix(5) == Data("solid".utf8)
+            throw STLFile.error(2, isASCII ? "ASCII STL files are not supported" : "File size doesn't match triangle count")
+        }
+        self.data = data
+        self.triangleCount = count
+    }
+
+    /// The 80-byte header text, trimmed.
+    var header: String {
+        let bytes = data.prefix(80)
+        return String(decoding: bytes, as: UTF8.self).trimmingCharacters(in: .whitespacesAndNewlines.union(.controlCharacters))
+    }
+
+    func withRecords<R>(_ body: (Records) throws -> R) rethrows -> R {
+        try data.withUnsafeBytes { raw in
+            try body(Records(base: raw.baseAddress!, count: triangleCount))
+        }
+    }
+
+    /// Unpacks every record into flat position and per-vertex normal arrays in one pass.
+    ///
+    /// Three vertices are emitted per triangle, in file order; the face normal is repeated
+    /// for each of them. The work is split across all cores.
+    func packedGeometry() -> (positions: [SIMD3<Float>], normals: [SIMD3<Float>]) {
+        let vertexCount = triangleCount * 3
+        var positions = [SIMD3<Float>](repeating: .zero, count: vertexCount)
+        var normals = [SIMD3<Float>](repeating: .zero, count: vertexCount)
+        positions.withUnsafeMutableBufferPointer { positionBuffer in
+            normals.withUnsafeMutableBufferPointer { normalBuffer in
+                let positionOut = positionBuffer
+                let normalOut = normalBuffer
+                withRecords { records in
+                    Parallel.forEachChunk(count: records.count) { _, range in
+                        for index in range {
+                            let record = records[index]
+                            let normal = record.faceNormal
+                            let out = index * 3
+                            positionOut[out] = record.v0
+                            positionOut[out + 1] = record.v1
+                            positionOut[out + 2] = record.v2
+                            normalOut[out] = normal
+                            normalOut[out + 1] = normal
+                            normalOut[out + 2] = normal
+                        }
+                    }
+                }
+            }
+        }
+        return (positions, normals)
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "STL", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+}
@@ -0,0 +1,116 @@
+//
+//  STLMerge.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// One binary STL to be merged, placed with a rigid transform.
+struct STLMergeInput {
+    let url: URL
+    var transform: simd_float4x4
+
+    init(url: URL, transform: simd_float4x4 = matrix_identity_float4x4) {
+        self.url = url
+        self.transform = transform
+    }
+
+    /// Input shifted along X, e.g. the right foot placed next to the left one.
+    init(url: URL, offsetX: Float) {
+        var transform = matrix_identity_float4x4
+        transform.columns.3.x = offsetX
+        self.init(url: url, transform: transform)
+    }
+}
+
+/// Streams any number of binary STL files into one output file.
+///
+/// Inputs are memory-mapped and copied to the output through a fixed-size record
+/// buffer, so peak memory does not depend on the size of the meshes.
+enum STLMerge {
+    /// Triangles copied per write; 16k records is ~800 KB.
+    static let chunkTriangles = 16_384
+
+    static func merge(_ inputs: [STLMergeInput], to outputURL: URL, header: String = "Merged STL File") throws {
+        let files = try inputs.map { try STLFile(url: $0.url) }
+        let totalTriangles = files.reduce(0) { $0 + $1.triangleCount }
+        guard totalTriangles <= Int(UInt32.max) else {
+            throw STLFile.error(3, "Too many triangles for a binary STL file")
+        }
+
+        let fileManager = FileManager.default
+        if fileManager.fileExists(atPath: outputURL.path) {
+            try fileManager.removeItem(at: outputURL)
+        }
+        guard fileManager.createFile(atPath: outputURL.path, contents: nil) else {
+            throw STLFile.error(4, "Unable to create \(outputURL.lastPathComponent)")
+        }
+        let handle = try FileHandle(forWritingTo: outputURL)
+        defer { try? handle.close() }
+
+        var headerData = Data(header.utf8.prefix(80))
+        headerData.append(Data(repeating: 0x20, count: 80 - headerData.count))
+        var triangleCount = UInt32(totalTriangles).littleEndian
+        headerData.append(Data(bytes: &triangleCount, count: 4))
+        try handle.write(contentsOf: headerData)
+
+        var chunk = Data(count: chunkTriangles * STLFile.recordSize)
+        for (file, input) in zip(files, inputs) {
+            var start = 0
+            while start < file.triangleCount {
+                let count = min(chunkTriangles, file.triangleCount - start)
+                let byteCount = count * STLFile.recordSize
+                file.data.withUnsafeBytes { source in
+                    chunk.withUnsafeMutableBytes { destination in
+                        let from = source.baseAddress! + STLFile.headerSize + start * STLFile.recordSize
+                        destination.baseAddress!.copyMemory(from: from, byteCount: byteCount)
+                        transformRecords(destination.baseAddress!, count: count, by: input.transform)
+                    }
+                }
+                try handle.write(contentsOf: chunk.prefix(byteCount))
+                start += count
+            }
+        }
+    }
+
+    /// Applies a rigid transform in place to `count` packed 50-byte records.
+    static func transformRecords(_ records: UnsafeMutableRawPointer, count: Int, by transform: simd_float4x4) {
+        guard transform != matrix_identity_float4x4 else { return }
+
+        let rotation = simd_float3x3(SIMD3(transform.columns.0.x, transform.columns.0.y, transform.columns.0.z),
+                                     SIMD3(transform.columns.1.x, transform.columns.1.y, transform.columns.1.z),
+                                     SIMD3(transform.columns.2.x, transform.columns.2.y, transform.columns.2.z))
+        let translation = SIMD3(transform.columns.3.x, transform.columns.3.y, transform.columns.3.z)
+        let translationOnly = rotation == matrix_identity_float3x3
+
+        @inline(__always) func load(_ pointer: UnsafeMutableRawPointer, _ offset: Int) -> SIMD3<Float> {
+            SIMD3(pointer.loadUnaligned(fromByteOffset: offset, as: Float.self),
+                  pointer.loadUnaligned(fromByteOffset: offset + 4, as: Float.self),
+                  pointer.loadUnaligned(fromByteOffset: offset + 8, as: Float.self))
+        }
+        @inline(__always) func store(_ vector: SIMD3<Float>, _ pointer: UnsafeMutableRawPointer, _ offset: Int) {
+            pointer.storeBytes(of: vector.x, toByteOffset: offset, as: Float.self)
+            pointer.storeBytes(of: vector.y, toByteOffset: offset + 4, as: Float.self)
+            pointer.storeBytes(of: vector.z, toByteOffset: offset + 8, as: Float.self)
+        }
+
+        Parallel.forEachChunk(count: count) { _, range in
+            for index in range {
+                let record = records + index * STLFile.recordSize
+                if translationOnly {
+                    store(load(record, 12) + translation, record, 12)
+                    store(load(record, 24) + translation, record, 24)
+                    store(load(record, 36) + translation, record, 36)
+                } else {
+                    store(rotation * load(record, 0), record, 0)
+                    store(rotation * load(record, 12) + translation, record, 12)
+                    store(rotation * load(record, 24) + translation, record, 24)
+                    store(rotation * load(record, 36) + translation, record, 36)
+                }
+            }
+        }
+    }
+}
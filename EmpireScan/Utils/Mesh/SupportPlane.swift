@@ -0,0 +1,308 @@
+//
+//  SupportPlane.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Finds the floor or footplate a scan rests on and cuts it away.
+///
+/// The mapper can drop the support plane while scanning, but rescans and older scans
+/// still carry it. Detection is RANSAC: every thread tests its own hypotheses against a
+/// strided sample stored as 8-wide lanes, then the winner is refit by least squares on
+/// all of its inliers.
+enum SupportPlane {
+    /// Plane `dot(normal, p) + distance = 0` with a unit normal pointing away from the support.
+    struct Plane {
+        var normal: SIMD3<Float>
+        var distance: Float
+
+        init(normal: SIMD3<Float>, distance: Float) {
+            self.normal = normal
+            self.distance = distance
+        }
+
+        /// Plane through three points, or nil when they are nearly collinear.
+        init?(_ a: SIMD3<Float>, _ b: SIMD3<Float>, _ c: SIMD3<Float>) {
+            let cross = simd_cross(b - a, c - a)
+            let length = simd_length(cross)
+            guard length > 1e-9 else { return nil }
+            normal = cross / length
+            distance = -simd_dot(normal, a)
+        }
+
+        func signedDistance(to point: SIMD3<Float>) -> Float {
+            simd_dot(normal, point) + distance
+        }
+
+        var flipped: Plane { Plane(normal: -normal, distance: -distance) }
+    }
+
+    struct Options {
+        var iterations = 512
+        /// Points closer than this to a hypothesis count as its inliers.
+        var inlierThreshold: Float = 0.004
+        /// The support has to hold at least this share of the points.
+        var minInlierFraction: Float = 0.1
+        /// A support has almost nothing underneath it; this rejects planes through the foot.
+        var maxBelowFraction: Float = 0.02
+        /// Hypotheses are scored on at most this many points.
+        var maxSamples = 65_536
+        /// The cut is raised this far above the fitted plane so the floor's noise goes with it.
+        var cutOffset: Float = 0.004
+    }
+
+    /// Dominant support plane among `points`, oriented towards the side holding the object.
+    static func detect(points: [SIMD3<Float>], options: Options = Options()) -> Plane? {
+        let count = points.count
+        guard count >= 3 else { return nil }
+
+        // Strided sample as structure-of-arrays lanes; NaN padding never counts.
+        let step = max(1, count / max(1, options.maxSamples))
+        let sampleCount = (count + step - 1) / step
+        let laneCount = (sampleCount + 7) / 8
+        var xs = [SIMD8<Float>](repeating: SIMD8(repeating: .nan), count: laneCount)
+        var ys = xs, zs = xs
+        for sample in 0..<sampleCount {
+            let point = points[sample * step]
+            xs[sample / 8][sample % 8] = point.x
+            ys[sample / 8][sample % 8] = point.y
+            zs[sample / 8][sample % 8] = point.z
+        }
+        let laneX = xs, laneY = ys, laneZ = zs
+
+        let threads = max(1, min(Parallel.coreCount, options.iterations))
+        let perThread = (options.iterations + threads - 1) / threads
+        let threshold = options.inlierThreshold
+        let maxBelow = Int(options.maxBelowFraction * Float(sampleCount))
+        var best = [Hypothesis](repeating: Hypothesis(), count: threads)
+        best.withUnsafeMutableBufferPointer { bestBuffer in
+            let results = bestBuffer
+            DispatchQueue.concurrentPerform(iterations: threads) { thread in
+                var random = SplitMix64(seed: UInt64(thread + 1))
+                var winner = Hypothesis()
+                for _ in 0..<perThread {
+                    let a = points[random.next(below: sampleCount) * step]
+                    let b = points[random.next(below: sampleCount) * step]
+                    let c = points[random.next(below: sampleCount) * step]
+                    guard let plane = Plane(a, b, c) else { continue }
+                    let (inliers, above) = score(plane, threshold: threshold, xs: laneX, ys: laneY, zs: laneZ)
+                    guard inliers > winner.inliers else { continue }
+                    let below = sampleCount - inliers - above
+                    guard min(above, below) <= maxBelow else { continue }
+                    winner = Hypothesis(plane: above >= below ? plane : plane.flipped, inliers: inliers)
+                }
+                results[thread] = winner
+            }
+        }
+
+        guard let winner = best.max(by: { $0.inliers < $1.inliers }), let plane = winner.plane,
+              Float(winner.inliers) >= options.minInlierFraction * Float(sampleCount) else { return nil }
+        return refine(plane, points: points, threshold: threshold)
+    }
+
+    /// Removes everything below `plane` raised by `offset`.
+    ///
+    /// Faces crossing the cut are clipped, and the new vertices are shared along each
+    /// split edge, so the mesh ends in one clean boundary loop lying on the plane.
+    static func cut(_ mesh: MeshBuffer, below plane: Plane, offset: Float = 0) -> MeshBuffer {
+        let vertexCount = mesh.vertexCount
+        let faceCount = mesh.faceCount
+        var side = [Float](repeating: 0, count: vertexCount)
+        side.withUnsafeMutableBufferPointer { sideBuffer in
+            let out = sideBuffer
+            Parallel.forEachChunk(count: vertexCount) { _, range in
+                for vertex in range {
+                    out[vertex] = plane.signedDistance(to: mesh.positions[vertex]) - offset
+                }
+            }
+        }
+        let height = side
+
+        // Number of corners below the cut per face.
+        var belowCorners = [UInt8](repeating: 0, count: faceCount)
+        belowCorners.withUnsafeMutableBufferPointer { belowBuffer in
+            let out = belowBuffer
+            Parallel.forEachChunk(count: faceCount) { _, range in
+                for face in range {
+                    let corners = mesh.face(face)
+                    out[face] = (height[Int(corners.x)] < 0 ? 1 : 0) + (height[Int(corners.y)] < 0 ? 1 : 0) + (height[Int(corners.z)] < 0 ? 1 : 0)
+                }
+            }
+        }
+        guard belowCorners.contains(where: { $0 > 0 }) else { return mesh }
+
+        var vertexMap = [Int32](repeating: -1, count: vertexCount)
+        for face in 0..<faceCount where belowCorners[face] < 3 {
+            for corner in 0..<3 {
+                let vertex = Int(mesh.indices[face * 3 + corner])
+                if height[vertex] >= 0 { vertexMap[vertex] = 0 }
+            }
+        }
+        var result = MeshBuffer()
+        var next: Int32 = 0
+        for vertex in 0..<vertexCount where vertexMap[vertex] == 0 {
+            vertexMap[vertex] = next
+            next += 1
+            result.positions.append(mesh.positions[vertex])
+            if mesh.hasNormals { result.normals.append(mesh.normals[vertex]) }
+            if mesh.hasColors { result.colors.append(mesh.colors[vertex]) }
+            if mesh.hasUVs { result.uvs.append(mesh.uvs[vertex]) }
+        }
+
+        // One new vertex per split edge, interpolated from the edge's lower index so both
+        // faces sharing the edge agree on it exactly.
+        var splitVertex: [UInt64: UInt32] = [:]
+        func split(_ a: Int, _ b: Int) -> UInt32 {
+            let (low, high) = a < b ? (a, b) : (b, a)
+            if height[low] == 0 { return UInt32(vertexMap[low]) }
+            if height[high] == 0 { return UInt32(vertexMap[high]) }
+            let key = UInt64(low) << 32 | UInt64(high)
+            if let vertex = splitVertex[key] { return vertex }
+            let t = height[low] / (height[low] - height[high])
+            let vertex = UInt32(result.positions.count)
+            result.positions.append(simd_mix(mesh.positions[low], mesh.positions[high], SIMD3(repeating: t)))
+            if mesh.hasNormals {
+                let normal = simd_mix(mesh.normals[low], mesh.normals[high], SIMD3(repeating: t))
+                result.normals.append(simd_length_squared(normal) > 0 ? simd_normalize(normal) : mesh.normals[low])
+            }
+            if mesh.hasColors { result.colors.append(simd_mix(mesh.colors[low], mesh.colors[high], SIMD3(repeating: t))) }
+            if mesh.hasUVs { result.uvs.append(simd_mix(mesh.uvs[low], mesh.uvs[high], SIMD2(repeating: t))) }
+            splitVertex[key] = vertex
+            return vertex
+        }
+
+        result.indices.reserveCapacity(mesh.indices.count)
+        var polygon: [UInt32] = []
+        for face in 0..<faceCount where belowCorners[face] < 3 {
+            let corners = mesh.face(face)
+            if belowCorners[face] == 0 {
+                result.indices.append(UInt32(vertexMap[Int(corners.x)]))
+                result.indices.append(UInt32(vertexMap[Int(corners.y)]))
+                result.indices.append(UInt32(vertexMap[Int(corners.z)]))
+                continue
+            }
+            // Clip the triangle against the cut, keeping its winding.
+            polygon.removeAll(keepingCapacity: true)
+            for corner in 0..<3 {
+                let a = Int(corners[corner]), b = Int(corners[(corner + 1) % 3])
+                if height[a] >= 0 { polygon.append(UInt32(vertexMap[a])) }
+                if (height[a] >= 0) != (height[b] >= 0) {
+                    let vertex = split(a, b)
+                    if polygon.last != vertex { polygon.append(vertex) }
+                }
+            }
+            if polygon.count > 1 && polygon.first == polygon.last { polygon.removeLast() }
+            guard polygon.count >= 3 else { continue }
+            for corner in 1..<(polygon.count - 1) {
+                result.indices.append(polygon[0])
+                result.indices.append(polygon[corner])
+                result.indices.append(polygon[corner + 1])
+            }
+        }
+        return result
+    }
+
+    /// Detects the support plane of `mesh` and cuts it away in place.
+    /// Returns the plane, or nil when the mesh has no clear support and was left untouched.
+    @discardableResult
+    static func removeSupport(from mesh: inout MeshBuffer, options: Options = Options()) -> Plane? {
+        guard let plane = detect(points: mesh.positions, options: options) else { return nil }
+        mesh = cut(mesh, below: plane, offset: options.cutOffset)
+        return plane
+    }
+
+    /// Inlier count and count of points above the inlier band, eight points at a time.
+    private static func score(_ plane: Plane, threshold: Float,
+                              xs: [SIMD8<Float>], ys: [SIMD8<Float>], zs: [SIMD8<Float>]) -> (inliers: Int, above: Int) {
+        let nx = SIMD8(repeating: plane.normal.x)
+        let ny = SIMD8(repeating: plane.normal.y)
+        let nz = SIMD8(repeating: plane.normal.z)
+        let d = SIMD8(repeating: plane.distance)
+        let upper = SIMD8<Float>(repeating: threshold), lower = -upper
+        var inliers = SIMD8<Int32>(repeating: 0)
+        var above = SIMD8<Int32>(repeating: 0)
+        let one = SIMD8<Int32>(repeating: 1)
+        for lane in 0..<xs.count {
+            let distance = nx * xs[lane] + ny * ys[lane] + nz * zs[lane] + d
+            inliers &+= SIMD8<Int32>(repeating: 0).replacing(with: one, where: (distance .< upper) .& (distance .> lower))
+            above &+= SIMD8<Int32>(repeating: 0).replacing(with: one, where: distance .>= upper)
+        }
+        return (Int(inliers.wrappedSum()), Int(above.wrappedSum()))
+    }
+
+    /// Least-squares refit on every point within `threshold` of `plane`, keeping its orientation.
+    private static func refine(_ plane: Plane, points: [SIMD3<Float>], threshold: Float) -> Plane {
+        var moments = [Moments](repeating: Moments(), count: max(1, Parallel.chunkCount(for: points.count)))
+        moments.withUnsafeMutableBufferPointer { momentsBuffer in
+            let out = momentsBuffer
+            Parallel.forEachChunk(count: points.count) { chunk, range in
+                var partial = Moments()
+                for index in range where abs(plane.signedDistance(to: points[index])) < threshold {
+                    partial.add(SIMD3<Double>(points[index]))
+                }
+                out[chunk] = partial
+            }
+        }
+        let total = moments.reduce(Moments()) { $0.merged($1) }
+        guard total.count >= 3 else { return plane }
+
+        let mean = total.sum / total.count
+        let covariance = total.outer * (1 / total.count) - simd_double3x3(rows: [mean * mean.x, mean * mean.y, mean * mean.z])
+        // Inverse iteration converges on the eigenvector of the smallest eigenvalue.
+        let trace = covariance[0, 0] + covariance[1, 1] + covariance[2, 2]
+        let shifted = covariance + simd_double3x3(diagonal: SIMD3(repeating: max(trace * 1e-9, 1e-18)))
+        guard abs(shifted.determinant) > 0 else { return plane }
+        let inverse = shifted.inverse
+        var normal = SIMD3<Double>(plane.normal)
+        for _ in 0..<8 {
+            normal = simd_normalize(inverse * normal)
+        }
+        guard normal.x.isFinite, normal.y.isFinite, normal.z.isFinite else { return plane }
+        if simd_dot(normal, SIMD3<Double>(plane.normal)) < 0 { normal = -normal }
+        return Plane(normal: SIMD3<Float>(normal), distance: Float(-simd_dot(normal, mean)))
+    }
+
+    private struct Hypothesis {
+        var plane: Plane?
+        var inliers = 0
+    }
+
+    /// Running sums for a least-squares plane fit.
+    private struct Moments {
+        var count: Double = 0
+        var sum = SIMD3<Double>.zero
+        var outer = simd_double3x3()
+
+        mutating func add(_ point: SIMD3<Double>) {
+            count += 1
+            sum += point
+            outer += simd_double3x3(rows: [point * point.x, point * point.y, point * point.z])
+        }
+
+        func merged(_ other: Moments) -> Moments {
+            Moments(count: count + other.count, sum: sum + other.sum, outer: outer + other.outer)
+        }
+    }
+
+    /// Small seeded generator so detection is repeatable for the same scan.
+    private struct SplitMix64 {
+        var state: UInt64
+
+        init(seed: UInt64) {
+            state = seed &* 0x9E37_79B9_7F4A_7C15
+        }
+
+        mutating func next(below bound: Int) -> Int {
+            state &+= 0x9E37_79B9_7F4A_7C15
+            var z = state
+            z = (z ^ (z >> 30)) &* 0xBF58_476D_1CE4_E5B9
+            z = (z ^ (z >> 27)) &* 0x94D0_49BB_1331_11EB
+            z ^= z >> 31
+            return Int(z % UInt64(bound))
+        }
+    }
+}
@@ -0,0 +1,224 @@
+//
+//  ThreeMFWriter.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// One mesh in a 3MF build, placed by its own transform.
+struct ThreeMFObject {
+    var name: String
+    var mesh: MeshBuffer
+    /// Placement in mesh units and the mesh's own axes, e.g. the right foot moved
+    /// next to the left one.
+    var transform: simd_float4x4
+
+    init(name: String, mesh: MeshBuffer, transform: simd_float4x4 = matrix_identity_float4x4) {
+        self.name = name
+        self.mesh = mesh
+        self.transform = transform
+    }
+
+    /// Object for a binary STL, read through its cached `MeshBlob`.
+    init(name: String, stlURL: URL, transform: simd_float4x4 = matrix_identity_float4x4) throws {
+        self.init(name: name, mesh: MeshBuffer(try MeshBlob.cached(forSTL: stlURL).indexedMesh()), transform: transform)
+    }
+}
+
+/// Writes meshes as a 3MF package for the printing lab.
+///
+/// Each mesh becomes its own object with a build item carrying its transform, so the
+/// feet keep their own geometry instead of baked offsets. Units are millimetres;
+/// vertex colors go in a color group and every object records whether it is
+/// watertight. The model XML is formatted in parallel batches that are deflated
+/// straight into the archive by `ZipStreamWriter`, so memory use stays flat however
+/// large the meshes are. Positions are written as given; the build items turn the
+/// Y-up meshes `MeshExporter` produces into 3MF's Z-up frame.
+enum ThreeMFWriter {
+    struct Options {
+        /// Millimetres per mesh unit; Structure scans are in metres.
+        var unitScale: Float = 1000
+        /// Writes vertex colors when the meshes have them.
+        var includeColors = true
+        /// Meshes are Y up; each build item then carries `yUpToZUp`.
+        var yUp = true
+    }
+
+    /// +90° about X: (x, y, z) becomes (x, -z, y).
+    static let yUpToZUp = simd_float4x4(columns: (SIMD4(1, 0, 0, 0), SIMD4(0, 0, 1, 0),
+                                                  SIMD4(0, -1, 0, 0), SIMD4(0, 0, 0, 1)))
+
+    /// Vertices or triangles formatted per batch.
+    static let batchSize = 65_536
+
+    private static let coreNamespace = "http://schemas.microsoft.com/3dmanufacturing/core/2015/02"
+    private static let materialNamespace = "http://schemas.microsoft.com/3dmanufacturing/material/2015/02"
+    private static let modelPath = "3D/3dmodel.model"
+
+    static func write(_ objects: [ThreeMFObject], to url: URL, options: Options = Options()) throws {
+        let archive = try ZipStreamWriter(url: url)
+        try write(objects, into: archive, options: options)
+        try archive.finish()
+    }
+
+    /// Adds the package parts to `archive`; the caller finishes it.
+    static func write(_ objects: [ThreeMFObject], into archive: ZipStreamWriter, options: Options = Options()) throws {
+        guard !objects.isEmpty else {
+            throw error(1, "Nothing to export")
+        }
+        try archive.addEntry("[Content_Types].xml") { emit in
+            try emit(Data("""
+            <?xml version="1.0" encoding="UTF-8"?>
+            <Types xmlns="http://schemas.openxmlformats.org/package/2006/content-types">\
+            <Default Extension="rels" ContentType="application/vnd.openxmlformats-package.relationships+xml"/>\
+            <Default Extension="model" ContentType="application/vnd.ms-package.3dmanufacturing-3dmodel+xml"/>\
+            </Types>
+
+            """.utf8))
+        }
+        try archive.addEntry("_rels/.rels") { emit in
+            try emit(Data("""
+            <?xml version="1.0" encoding="UTF-8"?>
+            <Relationships xmlns="http://schemas.openxmlformats.org/package/2006/relationships">\
+            <Relationship Target="/\(modelPath)" Id="rel0" Type="http://schemas.microsoft.com/3dmanufacturing/2013/01/3dmodel"/>\
+            </Relationships>
+
+            """.utf8))
+        }
+        try archive.addEntry(modelPath) { emit in
+            try writeModel(objects, options: options, emit: emit)
+        }
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "ThreeMFWriter", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+
+    // MARK: Model
+
+    private static func writeModel(_ objects: [ThreeMFObject], options: Options, emit: (Data) throws -> Void) throws {
+        let date = ISO8601DateFormatter().string(from: Date())
+        try emit(Data("""
+        <?xml version="1.0" encoding="UTF-8"?>
+        <model unit="millimeter" xml:lang="en-US" xmlns="\(coreNamespace)" xmlns:m="\(materialNamespace)">
+         <metadata name="Application">EmpireScan</metadata>
+         <metadata name="CreationDate">\(date)</metadata>
+         <resources>
+
+        """.utf8))
+
+        var items: [String] = []
+        var nextId = 1
+        for object in objects {
+            let mesh = object.mesh
+            let colorGroup = options.includeColors && mesh.hasColors ? nextId : nil
+            if let colorGroup = colorGroup {
+                nextId += 1
+                try emit(Data("  <m:colorgroup id=\"\(colorGroup)\">\n".utf8))
+                try emitBatches(count: mesh.vertexCount) { range, text in
+                    for vertex in range {
+                        let color = (simd_clamp(mesh.colors[vertex], .zero, .one) * 255).rounded(.toNearestOrAwayFromZero)
+                        text.append("   <m:color color=\"#")
+                        text.appendHex(UInt8(color.x))
+                        text.appendHex(UInt8(color.y))
+                        text.appendHex(UInt8(color.z))
+                        text.append("\"/>\n")
+                    }
+                } emit: emit
+                try emit(Data("  </m:colorgroup>\n".utf8))
+            }
+
+            let objectId = nextId
+            nextId += 1
+            let watertight = !mesh.indices.isEmpty && MeshHoleFiller.boundaryLoops(mesh).isEmpty
+            let group = colorGroup.map { " pid=\"\($0)\" pindex=\"0\"" } ?? ""
+            try emit(Data("""
+              <object id="\(objectId)" name="\(escaped(object.name))" type="model"\(group)>
+               <metadatagroup><metadata name="Description">\(watertight ? "Watertight" : "Open") scan mesh</metadata></metadatagroup>
+               <mesh>
+                <vertices>
+
+            """.utf8))
+            let scale = options.unitScale
+            try emitBatches(count: mesh.vertexCount) { range, text in
+                for vertex in range {
+                    let p = mesh.positions[vertex] * scale
+                    text.append("     <vertex x=\"")
+                    text.append(p.x)
+                    text.append("\" y=\"")
+                    text.append(p.y)
+                    text.append("\" z=\"")
+                    text.append(p.z)
+                    text.append("\"/>\n")
+                }
+            } emit: emit
+            try emit(Data("    </vertices>\n    <triangles>\n".utf8))
+            try emitBatches(count: mesh.faceCount) { range, text in
+                for face in range {
+                    let corners = mesh.face(face)
+                    text.append("     <triangle v1=\"")
+                    text.append(Int(corners.x))
+                    text.append("\" v2=\"")
+                    text.append(Int(corners.y))
+                    text.append("\" v3=\"")
+                    text.append(Int(corners.z))
+                    if colorGroup != nil {
+                        // Colors are per vertex, so each corner points at its vertex's entry.
+                        text.append("\" p1=\"")
+                        text.append(Int(corners.x))
+                        text.append("\" p2=\"")
+                        text.append(Int(corners.y))
+                        text.append("\" p3=\"")
+                        text.append(Int(corners.z))
+                    }
+                    text.append("\"/>\n")
+                }
+            } emit: emit
+            try emit(Data("    </triangles>\n   </mesh>\n  </object>\n".utf8))
+            let placement = options.yUp ? yUpToZUp * object.transform : object.transform
+            items.append("  <item objectid=\"\(objectId)\" transform=\"\(transform(placement, scale: scale))\"/>\n")
+        }
+
+        try emit(Data((" </resources>\n <build>\n" + items.joined() + " </build>\n</model>\n").utf8))
+    }
+
+    /// Formats `0..<count` in batches, each split across cores, and emits them in order.
+    private static func emitBatches(count: Int, _ format: (Range<Int>, inout MeshExporter.TextBuffer) -> Void,
+                                    emit: (Data) throws -> Void) throws {
+        var lower = 0
+        while lower < count {
+            let batch = lower..<min(count, lower + batchSize)
+            var chunks = [Data](repeating: Data(), count: Parallel.chunkCount(for: batch.count, minChunk: 4096))
+            chunks.withUnsafeMutableBufferPointer { chunkBuffer in
+                let out = chunkBuffer
+                Parallel.forEachChunk(count: batch.count, minChunk: 4096) { chunk, range in
+                    var text = MeshExporter.TextBuffer(capacity: range.count * 64)
+                    format((batch.lowerBound + range.lowerBound)..<(batch.lowerBound + range.upperBound), &text)
+                    out[chunk] = text.data
+                }
+            }
+            for chunk in chunks {
+                try emit(chunk)
+            }
+            lower = batch.upperBound
+        }
+    }
+
+    /// 3MF's row-major 3x4 form of a column-vector transform, translation in millimetres.
+    private static func transform(_ matrix: simd_float4x4, scale: Float) -> String {
+        let columns = [matrix.columns.0, matrix.columns.1, matrix.columns.2]
+        var values = columns.flatMap { [$0.x, $0.y, $0.z] }
+        values += [matrix.columns.3.x * scale, matrix.columns.3.y * scale, matrix.columns.3.z * scale]
+        return values.map { $0.description }.joined(separator: " ")
+    }
+
+    private static func escaped(_ text: String) -> String {
+        text.replacingOccurrences(of: "&", with: "&amp;")
+            .replacingOccurrences(of: "<", with: "&lt;")
+            .replacingOccurrences(of: ">", with: "&gt;")
+            .replacingOccurrences(of: "\"", with: "&quot;")
+    }
+}
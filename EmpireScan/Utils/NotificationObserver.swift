@@ -9,4 +9,5 @@ import Foundation
 
 extension Notification.Name {
     static let scanUploadedSuccessfully = Notification.Name("scanUploadedSuccessfully")
+    static let uploadFailed = Notification.Name("uploadFailed")
 }
@@ -0,0 +1,247 @@
+//
+//  DepthFrameLog.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Recorded depth frames with their tracked poses, for replaying reconstruction and
+/// tracking off-device.
+///
+/// The file starts with "EDF1" and a version, followed by one record per frame:
+/// width and height (UInt32), fx, fy, cx, cy (Float32), the timestamp (Float64), the
+/// world-from-camera pose as 16 column-major Float32 and the depths as UInt16 tenths of
+/// a millimetre, zero for invalid. All values are little-endian.
+enum DepthFrameLog {
+    struct Frame {
+        var depth: DepthImage
+        var cameraPose: simd_float4x4
+        var timestamp: TimeInterval
+    }
+
+    /// Timing of a replay through `TSDFVolume.integrate`.
+    struct ReplayStatistics {
+        var frameCount: Int
+        var bounds: SIMD3<Int>
+        var seconds: TimeInterval
+        var framesPerSecond: Double { seconds > 0 ? Double(frameCount) / seconds : 0 }
+    }
+
+    /// Timing of a replay through `DepthTracker`, frame to frame.
+    struct TrackingStatistics {
+        var frameCount: Int
+        var seconds: TimeInterval
+        /// Mean time per frame building the pyramid, and at each level, finest first.
+        var pyramidSeconds: TimeInterval
+        var levelSeconds: [TimeInterval]
+        /// Frames graded at each `DepthTracker.PoseAccuracy`, by raw value.
+        var accuracyCounts: [Int]
+        var framesPerSecond: Double { seconds > 0 ? Double(frameCount) / seconds : 0 }
+    }
+
+    private static let magic: UInt32 = 0x3146_4445 // "EDF1"
+    private static let version: UInt32 = 1
+    /// Stored depth units per metre.
+    private static let unitsPerMetre: Float = 10_000
+
+    /// Appends frames to a log file as they arrive.
+    final class Writer {
+        private let handle: FileHandle
+
+        /// Log at `url`, replacing any existing file.
+        init(url: URL) throws {
+            let fileManager = FileManager.default
+            if fileManager.fileExists(atPath: url.path) {
+                try fileManager.removeItem(at: url)
+            }
+            guard fileManager.createFile(atPath: url.path, contents: nil) else {
+                throw DepthFrameLog.error(1, "Unable to create \(url.lastPathComponent)")
+            }
+            handle = try FileHandle(forWritingTo: url)
+            var header = Data()
+            header.appendLittleEndian(DepthFrameLog.magic)
+            header.appendLittleEndian(DepthFrameLog.version)
+            try handle.write(contentsOf: header)
+        }
+
+        deinit {
+            try? handle.close()
+        }
+
+        func append(_ frame: Frame) throws {
+            try handle.write(contentsOf: DepthFrameLog.encode(frame))
+        }
+
+        func close() throws {
+            try handle.close()
+        }
+    }
+
+    /// Frames of a log, decoded one at a time from the mapped file so only the current
+    /// frame is held in memory. Iterating again starts over from the first frame.
+    struct Reader: Sequence, IteratorProtocol {
+        let data: Data
+        /// Frames in the log.
+        let count: Int
+        private var offset = 8
+
+        /// Maps the log at `url` and checks that every record is complete.
+        init(url: URL) throws {
+            data = try Data(contentsOf: url, options: .alwaysMapped)
+            guard data.count >= 8, data.uint32(at: 0) == DepthFrameLog.magic else {
+                throw DepthFrameLog.error(2, "Not a depth frame log")
+            }
+            guard data.uint32(at: 4) == DepthFrameLog.version else {
+                throw DepthFrameLog.error(3, "Unsupported depth frame log version")
+            }
+            var count = 0
+            var offset = 8
+            while offset < data.count {
+                guard offset + 96 <= data.count else { throw DepthFrameLog.error(4, "The log is truncated") }
+                let byteCount = Int(data.uint32(at: offset)) * Int(data.uint32(at: offset + 4)) * 2
+                guard byteCount <= data.count - offset - 96 else { throw DepthFrameLog.error(4, "The log is truncated") }
+                offset += 96 + byteCount
+                count += 1
+            }
+            self.count = count
+        }
+
+        mutating func next() -> Frame? {
+            guard offset < data.count else { return nil }
+            let width = Int(data.uint32(at: offset))
+            let height = Int(data.uint32(at: offset + 4))
+            let floats = (0..<20).map { Float(bitPattern: data.uint32(at: offset + 8 + $0 * 4 + ($0 >= 4 ? 8 : 0))) }
+            let timestamp = Double(bitPattern: data.uint64(at: offset + 24))
+            let start = offset + 96
+            offset = start + width * height * 2
+
+            let mapped = data
+            let depths = [Float](unsafeUninitializedCapacity: width * height) { buffer, initializedCount in
+                let out = buffer
+                mapped.withUnsafeBytes { bytes in
+                    Parallel.forEachChunk(count: width * height, minChunk: 16 * 1024) { _, range in
+                        for index in range {
+                            let units = UInt16(littleEndian: bytes.loadUnaligned(fromByteOffset: start + index * 2, as: UInt16.self))
+                            out[index] = units == 0 ? .nan : Float(units) / DepthFrameLog.unitsPerMetre
+                        }
+                    }
+                }
+                initializedCount = width * height
+            }
+
+            let pose = simd_float4x4(SIMD4(floats[4], floats[5], floats[6], floats[7]),
+                                     SIMD4(floats[8], floats[9], floats[10], floats[11]),
+                                     SIMD4(floats[12], floats[13], floats[14], floats[15]),
+                                     SIMD4(floats[16], floats[17], floats[18], floats[19]))
+            let intrinsics = CameraIntrinsics(fx: floats[0], fy: floats[1], cx: floats[2], cy: floats[3])
+            return Frame(depth: DepthImage(width: width, height: height, intrinsics: intrinsics, depths: depths),
+                         cameraPose: pose, timestamp: timestamp)
+        }
+    }
+
+    /// The frames of the log at `url`, streamed from disk.
+    static func read(_ url: URL) throws -> Reader {
+        try Reader(url: url)
+    }
+
+    /// Integrates `frames` into a fresh volume built with `options` and times the
+    /// integration alone, not the reading of the frames.
+    static func replay<Frames: Sequence>(_ frames: Frames, options: TSDFVolume.Options)
+        -> (volume: TSDFVolume, statistics: ReplayStatistics) where Frames.Element == Frame {
+        let volume = TSDFVolume(options: options)
+        var frameCount = 0
+        var seconds: TimeInterval = 0
+        for frame in frames {
+            let start = CFAbsoluteTimeGetCurrent()
+            volume.integrate(frame.depth, cameraPose: frame.cameraPose)
+            seconds += CFAbsoluteTimeGetCurrent() - start
+            frameCount += 1
+        }
+        let statistics = ReplayStatistics(frameCount: frameCount, bounds: options.bounds, seconds: seconds)
+        return (volume, statistics)
+    }
+
+    /// Replays `frames` once per resolution over a `volumeSize` cube, finest last.
+    static func benchmark<Frames: Sequence>(_ frames: Frames, volumeSize: SIMD3<Float>,
+                                            resolutions: [Float] = [0.004, 0.003, 0.002, 0.0015, 0.001])
+        -> [ReplayStatistics] where Frames.Element == Frame {
+        resolutions.map { resolution in
+            let statistics = replay(frames, options: TSDFVolume.Options(volumeSize: volumeSize, resolution: resolution)).statistics
+            print(String(format: "[TSDF] bounds %ld x %ld x %ld: %ld frames in %.2f s (%.1f fps)",
+                         statistics.bounds.x, statistics.bounds.y, statistics.bounds.z,
+                         statistics.frameCount, statistics.seconds, statistics.framesPerSecond))
+            return statistics
+        }
+    }
+
+    /// Tracks `frames` in order, starting at the first recorded pose, and times every stage.
+    static func replayTracking<Frames: Sequence>(_ frames: Frames, options: DepthTracker.Options = DepthTracker.Options())
+        -> TrackingStatistics where Frames.Element == Frame {
+        let tracker = DepthTracker(options: options)
+        var statistics = TrackingStatistics(frameCount: 0, seconds: 0, pyramidSeconds: 0,
+                                            levelSeconds: [TimeInterval](repeating: 0, count: DepthTracker.levelCount),
+                                            accuracyCounts: [Int](repeating: 0, count: DepthTracker.PoseAccuracy.veryHigh.rawValue + 1))
+        for frame in frames {
+            if statistics.frameCount == 0 {
+                tracker.initialCameraPose = frame.cameraPose
+            }
+            statistics.frameCount += 1
+            let start = CFAbsoluteTimeGetCurrent()
+            let result = tracker.updateCameraPose(with: frame.depth)
+            statistics.seconds += CFAbsoluteTimeGetCurrent() - start
+            statistics.pyramidSeconds += result.pyramidSeconds
+            for level in 0..<DepthTracker.levelCount {
+                statistics.levelSeconds[level] += result.levelSeconds[level]
+            }
+            statistics.accuracyCounts[result.accuracy.rawValue] += 1
+        }
+        if statistics.frameCount > 0 {
+            statistics.pyramidSeconds /= Double(statistics.frameCount)
+            statistics.levelSeconds = statistics.levelSeconds.map { $0 / Double(statistics.frameCount) }
+        }
+        print(String(format: "[ICP] %ld frames at %.1f fps; pyramid %.2f ms, levels %@ ms", statistics.frameCount,
+                     statistics.framesPerSecond, statistics.pyramidSeconds * 1000,
+                     statistics.levelSeconds.map { String(format: "%.2f", $0 * 1000) }.joined(separator: " / ")))
+        return statistics
+    }
+
+    static func error(_ code: Int, _ message: String) -> NSError {
+        NSError(domain: "DepthFrameLog", code: code, userInfo: [NSLocalizedDescriptionKey: message])
+    }
+
+    private static func encode(_ frame: Frame) -> Data {
+        let depth = frame.depth
+        var record = Data(capacity: 96 + depth.depths.count * 2)
+        record.appendLittleEndian(UInt32(depth.width))
+        record.appendLittleEndian(UInt32(depth.height))
+        for value in [depth.intrinsics.fx, depth.intrinsics.fy, depth.intrinsics.cx, depth.intrinsics.cy] {
+            record.appendLittleEndian(value.bitPattern)
+        }
+        record.appendLittleEndian(frame.timestamp.bitPattern)
+        let pose = frame.cameraPose
+        for column in [pose.columns.0, pose.columns.1, pose.columns.2, pose.columns.3] {
+            for value in [column.x, column.y, column.z, column.w] {
+                record.appendLittleEndian(value.bitPattern)
+            }
+        }
+
+        var units = [UInt16](repeating: 0, count: depth.depths.count)
+        units.withUnsafeMutableBufferPointer { unitBuffer in
+            let out = unitBuffer
+            depth.depths.withUnsafeBufferPointer { depths in
+                Parallel.forEachChunk(count: depths.count, minChunk: 16 * 1024) { _, range in
+                    for index in range {
+                        let value = (depths[index] * unitsPerMetre).rounded(.toNearestOrAwayFromZero)
+                        // Invalid and out-of-range depths are both stored as zero.
+                        out[index] = value >= 1 && value <= Float(UInt16.max) ? UInt16(value).littleEndian : 0
+                    }
+                }
+            }
+        }
+        units.withUnsafeBytes { record.append(contentsOf: $0) }
+        return record
+    }
+}
@@ -0,0 +1,32 @@
+//
+//  DepthImage+STDepthFrame.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import Structure
+
+extension DepthImage {
+    /// Copies `frame` into metres, converting rows in parallel. Zero and NaN depths stay invalid.
+    init(frame: STDepthFrame) {
+        let width = Int(frame.width)
+        let height = Int(frame.height)
+        let i: STIntrinsics = frame.intrinsics()
+        let source: UnsafeMutablePointer<Float>? = frame.depthInMillimeters
+        let depths = [Float](unsafeUninitializedCapacity: width * height) { buffer, initializedCount in
+            let out = buffer
+            Parallel.forEachChunk(count: height, minChunk: 32) { _, rows in
+                for index in (rows.lowerBound * width)..<(rows.upperBound * width) {
+                    let millimetres = source?[index] ?? .nan
+                    out[index] = millimetres > 0 ? millimetres / 1000 : .nan
+                }
+            }
+            initializedCount = width * height
+        }
+        self.init(width: width, height: height,
+                  intrinsics: CameraIntrinsics(fx: i.fx, fy: i.fy, cx: i.cx, cy: i.cy),
+                  depths: depths)
+    }
+}
@@ -0,0 +1,65 @@
+//
+//  DepthImage.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Pinhole camera with the depth sensor's convention: x right, y down, z forward,
+/// pixel centers at integer coordinates.
+struct CameraIntrinsics: Equatable {
+    var fx: Float
+    var fy: Float
+    var cx: Float
+    var cy: Float
+
+    /// Pixel coordinates of a camera-space point in front of the camera.
+    @inline(__always)
+    func project(_ point: SIMD3<Float>) -> SIMD2<Float> {
+        SIMD2(fx * point.x / point.z + cx, fy * point.y / point.z + cy)
+    }
+
+    /// Camera-space point seen at pixel `(u, v)` with depth `z`.
+    @inline(__always)
+    func unproject(_ u: Float, _ v: Float, depth z: Float) -> SIMD3<Float> {
+        SIMD3((u - cx) / fx * z, (v - cy) / fy * z, z)
+    }
+
+    /// Intrinsics of the same camera at `factor` times the resolution, e.g. 0.5 for half.
+    func scaled(by factor: Float) -> CameraIntrinsics {
+        // Pixel centers move with the image, so scale around the corner at (-0.5, -0.5).
+        CameraIntrinsics(fx: fx * factor, fy: fy * factor,
+                         cx: (cx + 0.5) * factor - 0.5, cy: (cy + 0.5) * factor - 0.5)
+    }
+}
+
+/// Depth map in metres, row-major with x fastest; invalid pixels are NaN.
+struct DepthImage {
+    let width: Int
+    let height: Int
+    var intrinsics: CameraIntrinsics
+    var depths: [Float]
+
+    init(width: Int, height: Int, intrinsics: CameraIntrinsics, depths: [Float]) {
+        precondition(depths.count == width * height, "Depth count does not match the image size")
+        self.width = width
+        self.height = height
+        self.intrinsics = intrinsics
+        self.depths = depths
+    }
+
+    /// Image with every pixel invalid.
+    init(width: Int, height: Int, intrinsics: CameraIntrinsics) {
+        self.init(width: width, height: height, intrinsics: intrinsics,
+                  depths: [Float](repeating: .nan, count: width * height))
+    }
+
+    @inline(__always)
+    subscript(x: Int, y: Int) -> Float {
+        get { depths[y * width + x] }
+        set { depths[y * width + x] = newValue }
+    }
+}
@@ -0,0 +1,479 @@
+//
+//  DepthTracker.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Depth-only camera tracking with coarse-to-fine point-to-plane ICP.
+///
+/// Every frame is reduced to a three-level depth pyramid with points and normals. Each
+/// level, coarsest first, is matched to the reference maps by projective data
+/// association: a point is moved by the current pose estimate, projected into the
+/// reference camera and paired with the pixel it lands on. The pairs give the 6x6
+/// normal equations of the point-to-plane error, summed in SIMD rows per thread and
+/// combined in double precision. The API follows `STTracker`: the pose is world from
+/// camera and every update is graded like `STTrackerPoseAccuracy`.
+final class DepthTracker {
+    struct Options {
+        /// ICP iterations per pyramid level, finest first.
+        var levelIterations = [10, 5, 4]
+        /// Farthest a pair may be apart, in metres.
+        var maxCorrespondenceDistance: Float = 0.02
+        /// Least cosine between paired normals.
+        var minNormalCosine: Float = 0.8
+        /// Pairs needed at the finest level for any pose to be reported.
+        var minCorrespondences = 500
+        /// Motion between frames beyond which the pose is considered lost.
+        var maxTranslationPerFrame: Float = 0.1
+        var maxRotationPerFrame: Float = .pi / 6
+        /// Keeps `reference` as set by the caller, e.g. a model raycast, instead of
+        /// replacing it with every tracked frame, as `kSTTrackerTrackAgainstModelKey`.
+        var trackAgainstModel = false
+    }
+
+    /// Confidence in a tracked pose, ordered like `STTrackerPoseAccuracy`.
+    enum PoseAccuracy: Int, Comparable {
+        case notAvailable
+        case low
+        case approximate
+        case high
+        case veryHigh
+
+        static func < (lhs: PoseAccuracy, rhs: PoseAccuracy) -> Bool {
+            lhs.rawValue < rhs.rawValue
+        }
+    }
+
+    /// Points and normals in world space to track against; invalid pixels are NaN.
+    struct Reference {
+        let width: Int
+        let height: Int
+        let intrinsics: CameraIntrinsics
+        /// World from camera of the view the maps were made from.
+        let cameraPose: simd_float4x4
+        var points: [SIMD3<Float>]
+        var normals: [SIMD3<Float>]
+
+        /// Reference made from a depth frame seen from `cameraPose`.
+        init(depth: DepthImage, cameraPose: simd_float4x4) {
+            self.init(Level(depth), cameraPose: cameraPose)
+        }
+
+        init(width: Int, height: Int, intrinsics: CameraIntrinsics, cameraPose: simd_float4x4,
+             points: [SIMD3<Float>], normals: [SIMD3<Float>]) {
+            self.width = width
+            self.height = height
+            self.intrinsics = intrinsics
+            self.cameraPose = cameraPose
+            self.points = points
+            self.normals = normals
+        }
+
+        /// Reference made from the camera-space maps of a pyramid level.
+        fileprivate init(_ level: Level, cameraPose: simd_float4x4) {
+            self.init(width: level.width, height: level.height, intrinsics: level.intrinsics, cameraPose: cameraPose,
+                      points: level.points, normals: level.normals)
+            let rotation = DepthTracker.rotation(of: cameraPose)
+            let translation = DepthTracker.translation(of: cameraPose)
+            let count = points.count
+            points.withUnsafeMutableBufferPointer { pointBuffer in
+                normals.withUnsafeMutableBufferPointer { normalBuffer in
+                    let points = pointBuffer
+                    let normals = normalBuffer
+                    Parallel.forEachChunk(count: count, minChunk: 16 * 1024) { _, range in
+                        for index in range {
+                            points[index] = rotation * points[index] + translation
+                            normals[index] = rotation * normals[index]
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    struct Result {
+        var cameraPose: simd_float4x4
+        var accuracy: PoseAccuracy
+        /// Pairs used in the last iteration at the finest level.
+        var correspondences: Int
+        /// Share of the frame's valid points that found a pair.
+        var inlierRatio: Float
+        /// Root mean square point-to-plane distance in metres.
+        var residual: Float
+        /// Time spent building the pyramid.
+        var pyramidSeconds: TimeInterval
+        /// Time spent per pyramid level, finest first.
+        var levelSeconds: [TimeInterval]
+    }
+
+    static let levelCount = 3
+
+    let options: Options
+    /// Pose of the first frame after creation or `reset`.
+    var initialCameraPose = matrix_identity_float4x4
+    private(set) var lastFrameCameraPose = matrix_identity_float4x4
+    private(set) var poseAccuracy = PoseAccuracy.notAvailable
+    /// What the next frame is tracked against. Set by every frame unless
+    /// `options.trackAgainstModel`, in which case the caller provides it.
+    var reference: Reference?
+
+    init(options: Options = Options()) {
+        precondition(options.levelIterations.count == DepthTracker.levelCount, "One iteration count per pyramid level")
+        self.options = options
+    }
+
+    /// Forgets the reference; the next frame starts again at `initialCameraPose`.
+    func reset() {
+        reference = nil
+        lastFrameCameraPose = initialCameraPose
+        poseAccuracy = .notAvailable
+    }
+
+    /// Tracks `depth` from the last pose against `reference`.
+    @discardableResult
+    func updateCameraPose(with depth: DepthImage) -> Result {
+        let pyramidStart = CFAbsoluteTimeGetCurrent()
+        let pyramid = DepthTracker.pyramid(depth)
+        let pyramidSeconds = CFAbsoluteTimeGetCurrent() - pyramidStart
+
+        guard let reference = reference else {
+            // The first frame defines the world, so its pose is exact.
+            lastFrameCameraPose = initialCameraPose
+            poseAccuracy = .veryHigh
+            adoptReference(pyramid[0], pose: initialCameraPose)
+            return Result(cameraPose: initialCameraPose, accuracy: .veryHigh, correspondences: 0, inlierRatio: 1,
+                          residual: 0, pyramidSeconds: pyramidSeconds,
+                          levelSeconds: [TimeInterval](repeating: 0, count: DepthTracker.levelCount))
+        }
+
+        var pose = lastFrameCameraPose
+        var levelSeconds = [TimeInterval](repeating: 0, count: DepthTracker.levelCount)
+        var last = Equations()
+        var solved = true
+        for level in stride(from: DepthTracker.levelCount - 1, through: 0, by: -1) {
+            let start = CFAbsoluteTimeGetCurrent()
+            for _ in 0..<options.levelIterations[level] {
+                last = equations(pyramid[level], reference: reference, pose: pose)
+                guard last.count >= 6, let step = last.solve() else {
+                    solved = false
+                    break
+                }
+                pose = DepthTracker.exponential(step) * pose
+                if (step * step).sum() < 1e-10 { break }
+            }
+            levelSeconds[level] = CFAbsoluteTimeGetCurrent() - start
+            if !solved { break }
+        }
+
+        let validPoints = pyramid[0].validCount
+        let inlierRatio = validPoints > 0 ? Float(last.count) / Float(validPoints) : 0
+        let residual = last.count > 0 ? (last.squaredError / Double(last.count)).squareRoot() : .infinity
+        var accuracy = grade(solved: solved, correspondences: last.count, inlierRatio: inlierRatio, residual: Float(residual))
+        let motion = lastFrameCameraPose.inverse * pose
+        if simd_length(DepthTracker.translation(of: motion)) > options.maxTranslationPerFrame
+            || DepthTracker.rotationAngle(of: motion) > options.maxRotationPerFrame {
+            accuracy = .notAvailable
+        }
+
+        if accuracy >= .approximate {
+            lastFrameCameraPose = pose
+            if !options.trackAgainstModel {
+                adoptReference(pyramid[0], pose: pose)
+            }
+        }
+        poseAccuracy = accuracy
+        return Result(cameraPose: accuracy >= .approximate ? pose : lastFrameCameraPose, accuracy: accuracy,
+                      correspondences: last.count, inlierRatio: inlierRatio, residual: Float(residual),
+                      pyramidSeconds: pyramidSeconds, levelSeconds: levelSeconds)
+    }
+
+    /// Grade from how much of the frame matched and how closely.
+    private func grade(solved: Bool, correspondences: Int, inlierRatio: Float, residual: Float) -> PoseAccuracy {
+        guard solved, correspondences >= options.minCorrespondences else { return .notAvailable }
+        let distance = options.maxCorrespondenceDistance
+        if inlierRatio >= 0.8 && residual <= distance * 0.1 { return .veryHigh }
+        if inlierRatio >= 0.6 && residual <= distance * 0.2 { return .high }
+        if inlierRatio >= 0.4 && residual <= distance * 0.35 { return .approximate }
+        return .low
+    }
+
+    private func adoptReference(_ level: Level, pose: simd_float4x4) {
+        reference = Reference(level, cameraPose: pose)
+    }
+
+    // MARK: Pyramid
+
+    /// One pyramid level in camera space; invalid pixels are NaN.
+    struct Level {
+        let width: Int
+        let height: Int
+        let intrinsics: CameraIntrinsics
+        var depths: [Float]
+        var points: [SIMD3<Float>]
+        var normals: [SIMD3<Float>]
+        var validCount = 0
+
+        init(_ depth: DepthImage) {
+            width = depth.width
+            height = depth.height
+            intrinsics = depth.intrinsics
+            depths = depth.depths
+            points = []
+            normals = []
+            computeMaps()
+        }
+
+        /// Level at half the resolution of `finer`. Each pixel averages the valid 2x2
+        /// samples close to the nearest one, so depth edges are not blurred.
+        init(halving finer: Level) {
+            width = finer.width / 2
+            height = finer.height / 2
+            intrinsics = finer.intrinsics.scaled(by: 0.5)
+            let width = self.width
+            let height = self.height
+            depths = [Float](unsafeUninitializedCapacity: width * height) { buffer, initializedCount in
+                let out = buffer
+                finer.depths.withUnsafeBufferPointer { source in
+                    Parallel.forEachChunk(count: height, minChunk: 8) { _, rows in
+                        for y in rows {
+                            for x in 0..<width {
+                                let first = 2 * y * finer.width + 2 * x
+                                let samples = SIMD4(source[first], source[first + 1],
+                                                    source[first + finer.width], source[first + finer.width + 1])
+                                let valid = samples .== samples
+                                guard any(valid) else {
+                                    out[y * width + x] = .nan
+                                    continue
+                                }
+                                let nearest = samples.replacing(with: .infinity, where: .!valid).min()
+                                let close = valid .& (samples .<= nearest * 1.03 + 0.01)
+                                let sum = samples.replacing(with: 0, where: .!close).sum()
+                                let count = SIMD4<Float>(repeating: 1).replacing(with: 0, where: .!close).sum()
+                                out[y * width + x] = sum / count
+                            }
+                        }
+                    }
+                }
+                initializedCount = width * height
+            }
+            points = []
+            normals = []
+            computeMaps()
+        }
+
+        /// Camera-space points and normals from `depths`.
+        private mutating func computeMaps() {
+            let width = self.width
+            let height = self.height
+            let intrinsics = self.intrinsics
+            let depths = self.depths
+            points = [SIMD3<Float>](unsafeUninitializedCapacity: width * height) { buffer, initializedCount in
+                let out = buffer
+                Parallel.forEachChunk(count: height, minChunk: 8) { _, rows in
+                    for y in rows {
+                        for x in 0..<width {
+                            let depth = depths[y * width + x]
+                            out[y * width + x] = depth.isFinite
+                                ? intrinsics.unproject(Float(x), Float(y), depth: depth)
+                                : SIMD3(repeating: .nan)
+                        }
+                    }
+                }
+                initializedCount = width * height
+            }
+            let points = self.points
+            var counts = [Int](repeating: 0, count: Parallel.chunkCount(for: height, minChunk: 8))
+            normals = [SIMD3<Float>](unsafeUninitializedCapacity: width * height) { buffer, initializedCount in
+                let out = buffer
+                counts.withUnsafeMutableBufferPointer { countBuffer in
+                    let validCounts = countBuffer
+                    Parallel.forEachChunk(count: height, minChunk: 8) { chunk, rows in
+                        var valid = 0
+                        for y in rows {
+                            for x in 0..<width {
+                                let index = y * width + x
+                                out[index] = SIMD3(repeating: .nan)
+                                guard x + 1 < width, y + 1 < height else { continue }
+                                let point = points[index]
+                                let right = points[index + 1] - point
+                                let down = points[index + width] - point
+                                // Neighbours across a depth edge belong to another surface.
+                                let limit = 0.05 * point.z
+                                guard point.z.isFinite, simd_length(right) < limit, simd_length(down) < limit else { continue }
+                                // x right and y down, so down x right faces the camera.
+                                let normal = simd_cross(down, right)
+                                let length = simd_length(normal)
+                                guard length > 0 else { continue }
+                                out[index] = normal / length
+                                valid += 1
+                            }
+                        }
+                        validCounts[chunk] = valid
+                    }
+                }
+                initializedCount = width * height
+            }
+            validCount = counts.reduce(0, +)
+        }
+    }
+
+    static func pyramid(_ depth: DepthImage) -> [Level] {
+        var levels = [Level(depth)]
+        while levels.count < levelCount {
+            levels.append(Level(halving: levels[levels.count - 1]))
+        }
+        return levels
+    }
+
+    // MARK: Normal equations
+
+    /// Point-to-plane normal equations as the upper rows of `[J r] * [J r]^T`.
+    struct Equations {
+        /// Rows 0-5 hold `JJ^T` and `J r`; row 6 holds `J r` and `r^2`.
+        var rows = [SIMD8<Double>](repeating: .zero, count: 7)
+        var count = 0
+
+        var squaredError: Double { rows[6][6] }
+
+        mutating func add(_ other: Equations) {
+            for row in 0..<7 {
+                rows[row] += other.rows[row]
+            }
+            count += other.count
+        }
+
+        /// Twist `(rotation, translation)` minimizing the error, by Cholesky decomposition.
+        func solve() -> SIMD8<Float>? {
+            var l = [[Double]](repeating: [Double](repeating: 0, count: 6), count: 6)
+            for i in 0..<6 {
+                for j in 0...i {
+                    var sum = rows[i][j]
+                    for k in 0..<j {
+                        sum -= l[i][k] * l[j][k]
+                    }
+                    if i == j {
+                        guard sum > 1e-12 else { return nil }
+                        l[i][i] = sum.squareRoot()
+                    } else {
+                        l[i][j] = sum / l[j][j]
+                    }
+                }
+            }
+            // L y = -J r, then L^T x = y.
+            var y = [Double](repeating: 0, count: 6)
+            for i in 0..<6 {
+                var sum = -rows[i][6]
+                for k in 0..<i { sum -= l[i][k] * y[k] }
+                y[i] = sum / l[i][i]
+            }
+            var x = [Double](repeating: 0, count: 6)
+            for i in stride(from: 5, through: 0, by: -1) {
+                var sum = y[i]
+                for k in (i + 1)..<6 { sum -= l[k][i] * x[k] }
+                x[i] = sum / l[i][i]
+            }
+            return SIMD8(Float(x[0]), Float(x[1]), Float(x[2]), Float(x[3]), Float(x[4]), Float(x[5]), 0, 0)
+        }
+    }
+
+    /// Pairs `level` with `reference` at `pose` and sums the normal equations per thread.
+    private func equations(_ level: Level, reference: Reference, pose: simd_float4x4) -> Equations {
+        let rotation = DepthTracker.rotation(of: pose)
+        let translation = DepthTracker.translation(of: pose)
+        let referenceFromWorld = reference.cameraPose.inverse
+        let referenceRotation = DepthTracker.rotation(of: referenceFromWorld)
+        let referenceTranslation = DepthTracker.translation(of: referenceFromWorld)
+        let referenceIntrinsics = reference.intrinsics
+        let referenceWidth = reference.width
+        let referenceHeight = reference.height
+        let maxDistance = options.maxCorrespondenceDistance
+        let minCosine = options.minNormalCosine
+        let width = level.width
+
+        var partials = [Equations](repeating: Equations(), count: Parallel.chunkCount(for: level.height, minChunk: 4))
+        level.points.withUnsafeBufferPointer { points in
+            level.normals.withUnsafeBufferPointer { normals in
+                reference.points.withUnsafeBufferPointer { referencePoints in
+                    reference.normals.withUnsafeBufferPointer { referenceNormals in
+                        partials.withUnsafeMutableBufferPointer { partialBuffer in
+                            let out = partialBuffer
+                            Parallel.forEachChunk(count: level.height, minChunk: 4) { chunk, rows in
+                                // Float rows are exact enough for one chunk; chunks are combined in double.
+                                var sums = [SIMD8<Float>](repeating: .zero, count: 7)
+                                var count = 0
+                                for index in (rows.lowerBound * width)..<(rows.upperBound * width) {
+                                    let normal = normals[index]
+                                    guard normal.x.isFinite else { continue }
+                                    let world = rotation * points[index] + translation
+                                    let seen = referenceRotation * world + referenceTranslation
+                                    guard seen.z > 0 else { continue }
+                                    let pixel = referenceIntrinsics.project(seen).rounded(.toNearestOrAwayFromZero)
+                                    guard pixel.x >= 0, pixel.y >= 0, pixel.x < Float(referenceWidth), pixel.y < Float(referenceHeight) else { continue }
+                                    let target = Int(pixel.y) * referenceWidth + Int(pixel.x)
+                                    let targetNormal = referenceNormals[target]
+                                    guard targetNormal.x.isFinite else { continue }
+                                    let difference = world - referencePoints[target]
+                                    guard simd_length_squared(difference) <= maxDistance * maxDistance,
+                                          simd_dot(rotation * normal, targetNormal) >= minCosine else { continue }
+
+                                    let residual = simd_dot(targetNormal, difference)
+                                    let angular = simd_cross(world, targetNormal)
+                                    let row = SIMD8(angular.x, angular.y, angular.z,
+                                                    targetNormal.x, targetNormal.y, targetNormal.z, residual, 0)
+                                    for i in 0..<7 {
+                                        sums[i] += row[i] * row
+                                    }
+                                    count += 1
+                                }
+                                var partial = Equations()
+                                for i in 0..<7 {
+                                    partial.rows[i] = SIMD8<Double>(sums[i])
+                                }
+                                partial.count = count
+                                out[chunk] = partial
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        return partials.reduce(into: Equations()) { $0.add($1) }
+    }
+
+    // MARK: Geometry
+
+    static func rotation(of pose: simd_float4x4) -> simd_float3x3 {
+        simd_float3x3(SIMD3(pose.columns.0.x, pose.columns.0.y, pose.columns.0.z),
+                      SIMD3(pose.columns.1.x, pose.columns.1.y, pose.columns.1.z),
+                      SIMD3(pose.columns.2.x, pose.columns.2.y, pose.columns.2.z))
+    }
+
+    static func translation(of pose: simd_float4x4) -> SIMD3<Float> {
+        SIMD3(pose.columns.3.x, pose.columns.3.y, pose.columns.3.z)
+    }
+
+    static func rotationAngle(of pose: simd_float4x4) -> Float {
+        let r = rotation(of: pose)
+        let cosine = (r.columns.0.x + r.columns.1.y + r.columns.2.z - 1) / 2
+        return acos(min(1, max(-1, cosine)))
+    }
+
+    /// Rigid transform of a small twist, rotation by Rodrigues' formula.
+    static func exponential(_ twist: SIMD8<Float>) -> simd_float4x4 {
+        let omega = SIMD3(twist[0], twist[1], twist[2])
+        let angle = simd_length(omega)
+        var transform = matrix_identity_float4x4
+        if angle > 1e-9 {
+            let rotation = simd_float3x3(simd_quatf(angle: angle, axis: omega / angle))
+            transform.columns.0 = SIMD4(rotation.columns.0, 0)
+            transform.columns.1 = SIMD4(rotation.columns.1, 0)
+            transform.columns.2 = SIMD4(rotation.columns.2, 0)
+        }
+        transform.columns.3 = SIMD4(twist[3], twist[4], twist[5], 1)
+        return transform
+    }
+}
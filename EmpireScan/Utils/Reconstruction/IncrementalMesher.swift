@@ -0,0 +1,137 @@
+//
+//  IncrementalMesher.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// A TSDF stored as 8x8x8 voxel blocks that records which blocks changed.
+protocol VoxelBlockSource: AnyObject {
+    var options: TSDFVolume.Options { get }
+    /// Voxels of `block`, x fastest, or nil when the block holds no data.
+    func blockVoxels(at block: SIMD3<Int>) -> UnsafeBufferPointer<TSDFVoxel>?
+    /// Blocks whose surface may have changed since the last call.
+    func takeDirtyBlocks() -> [SIMD3<Int>]
+}
+
+extension TSDFVolume: VoxelBlockSource {}
+extension SparseTSDFVolume: VoxelBlockSource {}
+
+/// Keeps a surface mesh of a TSDF up to date by re-meshing only the blocks that changed.
+///
+/// Every block owns the marching cubes cells whose first corner lies in it, so it is
+/// meshed from a 9x9x9 grid borrowing one layer of voxels from its +x, +y and +z
+/// neighbours. A changed block therefore also dirties the seven blocks below it. Dirty
+/// blocks are re-meshed in parallel and reported as a `Delta`, so a live preview can
+/// upload just those meshes. Vertices on block faces are not shared between blocks.
+final class IncrementalMesher {
+    struct Delta {
+        /// New mesh of every block whose surface was rebuilt, never empty.
+        var updated: [(block: SIMD3<Int>, mesh: MeshBuffer)] = []
+        /// Blocks whose surface disappeared.
+        var removed: [SIMD3<Int>] = []
+
+        var isEmpty: Bool { updated.isEmpty && removed.isEmpty }
+    }
+
+    let volume: VoxelBlockSource
+    /// Current mesh of every block with a surface.
+    private(set) var blockMeshes: [SIMD3<Int>: MeshBuffer] = [:]
+
+    init(volume: VoxelBlockSource) {
+        self.volume = volume
+    }
+
+    /// Re-meshes the blocks the volume changed since the last update.
+    /// Must not run while the volume is integrating.
+    @discardableResult
+    func update() -> Delta {
+        var affected = Set<SIMD3<Int>>()
+        for block in volume.takeDirtyBlocks() {
+            for corner in 0..<8 {
+                affected.insert(block &- SIMD3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1))
+            }
+        }
+        guard !affected.isEmpty else { return Delta() }
+
+        let blocks = Array(affected)
+        var meshes = [MeshBuffer](repeating: MeshBuffer(), count: blocks.count)
+        meshes.withUnsafeMutableBufferPointer { meshBuffer in
+            let out = meshBuffer
+            Parallel.forEachChunk(count: blocks.count, minChunk: 4) { _, range in
+                for index in range {
+                    out[index] = extract(blocks[index])
+                }
+            }
+        }
+
+        var delta = Delta()
+        for (block, mesh) in zip(blocks, meshes) {
+            if mesh.faceCount > 0 {
+                blockMeshes[block] = mesh
+                delta.updated.append((block, mesh))
+            } else if blockMeshes.removeValue(forKey: block) != nil {
+                delta.removed.append(block)
+            }
+        }
+        return delta
+    }
+
+    /// All block meshes in one buffer, one submesh per block.
+    func mesh() -> MeshBuffer {
+        var result = MeshBuffer()
+        result.positions.reserveCapacity(blockMeshes.values.reduce(0) { $0 + $1.vertexCount })
+        result.indices.reserveCapacity(blockMeshes.values.reduce(0) { $0 + $1.indices.count })
+        for mesh in blockMeshes.values {
+            let vertexStart = result.vertexCount
+            let faceStart = result.faceCount
+            result.positions.append(contentsOf: mesh.positions)
+            result.indices.append(contentsOf: mesh.indices.lazy.map { $0 + UInt32(vertexStart) })
+            result.submeshes.append(MeshBuffer.Submesh(vertexRange: vertexStart..<result.vertexCount,
+                                                       faceRange: faceStart..<result.faceCount))
+        }
+        return result
+    }
+
+    /// Drops every block mesh, e.g. after the volume was reset.
+    func removeAll() {
+        blockMeshes.removeAll()
+    }
+
+    /// Surface of the cells owned by `block`.
+    private func extract(_ block: SIMD3<Int>) -> MeshBuffer {
+        let blockSize = TSDFVolume.blockSize
+        let padded = blockSize + 1
+        guard volume.blockVoxels(at: block) != nil else { return MeshBuffer() }
+        let neighbours = (0..<8).map { corner in
+            volume.blockVoxels(at: block &+ SIMD3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1))
+        }
+
+        var samples = [Float](repeating: .nan, count: padded * padded * padded)
+        var hasInside = false
+        var hasOutside = false
+        for z in 0..<padded {
+            for y in 0..<padded {
+                for x in 0..<padded {
+                    let neighbour = (x == blockSize ? 1 : 0) | (y == blockSize ? 2 : 0) | (z == blockSize ? 4 : 0)
+                    guard let voxels = neighbours[neighbour] else { continue }
+                    let voxel = voxels[(x & (blockSize - 1)) + blockSize * ((y & (blockSize - 1)) + blockSize * (z & (blockSize - 1)))]
+                    guard voxel.weight > 0 else { continue }
+                    samples[x + padded * (y + padded * z)] = voxel.distance
+                    if voxel.distance < 0 { hasInside = true } else { hasOutside = true }
+                }
+            }
+        }
+        guard hasInside && hasOutside else { return MeshBuffer() }
+
+        let resolution = volume.options.resolution
+        return samples.withUnsafeBufferPointer { values in
+            MarchingCubes.extract(MarchingCubes.Grid(values: values, size: SIMD3(repeating: padded),
+                                                     origin: (SIMD3<Float>(block &* blockSize) + 0.5) * resolution,
+                                                     spacing: resolution))
+        }
+    }
+}
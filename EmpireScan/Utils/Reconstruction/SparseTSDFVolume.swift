@@ -0,0 +1,276 @@
+//
+//  SparseTSDFVolume.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// TSDF fusion that allocates 8x8x8 voxel blocks only around observed surfaces.
+///
+/// Memory scales with the scanned surface instead of the cube, so the foot cube can be
+/// mapped far past the 290^3 voxels `STMapper` is comfortable with, e.g. at 0.5 mm.
+/// Blocks come from a fixed pool and are found through a `VoxelBlockHash`. Each
+/// frame first allocates the blocks around its depth samples on all cores, then
+/// fuses every visible block in parallel with the same SIMD kernel as `TSDFVolume`.
+/// `evictBlocks` streams out and frees blocks the camera no longer sees.
+final class SparseTSDFVolume {
+    /// `options.bounds` still limits where blocks may be allocated.
+    let options: TSDFVolume.Options
+    /// Most blocks resident at once.
+    let maxBlocks: Int
+    /// Blocks per axis inside `bounds`.
+    let blockCounts: SIMD3<Int>
+
+    private let hash: VoxelBlockHash
+    private let voxels: UnsafeMutableBufferPointer<TSDFVoxel>
+    private var freeBlocks: [Int32]
+    private let poolLock = NSLock()
+    private var dirtyBlocks = Set<SIMD3<Int>>()
+    private let dirtyLock = NSLock()
+    /// Blocks that could not be allocated because the pool was full.
+    private(set) var droppedBlocks = 0
+
+    /// Blocks currently resident.
+    var blockCount: Int {
+        poolLock.lock()
+        defer { poolLock.unlock() }
+        return maxBlocks - freeBlocks.count
+    }
+
+    /// Volume for `options` holding at most `maxBlocks` blocks; the default is 64 MB of voxels.
+    init(options: TSDFVolume.Options = TSDFVolume.Options(), maxBlocks: Int = 16_384) {
+        precondition(options.resolution > 0 && options.bounds.min() > 0 && maxBlocks > 0, "Invalid TSDF volume options")
+        self.options = options
+        self.maxBlocks = maxBlocks
+        blockCounts = (options.bounds &+ (TSDFVolume.blockSize - 1)) / TSDFVolume.blockSize
+        hash = VoxelBlockHash(minimumCapacity: maxBlocks)
+        voxels = .allocate(capacity: maxBlocks * TSDFVolume.blockVoxelCount)
+        freeBlocks = Array((0..<Int32(maxBlocks)).reversed())
+    }
+
+    deinit {
+        voxels.deallocate()
+    }
+
+    /// Voxel at integer coordinates, or nil when its block is not resident.
+    func voxel(at coordinate: SIMD3<Int>) -> TSDFVoxel? {
+        let block = coordinate / TSDFVolume.blockSize
+        guard let slot = hash.value(for: VoxelBlockHash.key(block)) else { return nil }
+        let local = coordinate &- block &* TSDFVolume.blockSize
+        return voxels[Int(slot) * TSDFVolume.blockVoxelCount
+                      + local.x + TSDFVolume.blockSize * (local.y + TSDFVolume.blockSize * local.z)]
+    }
+
+    /// Voxels of a resident block, x fastest.
+    func blockVoxels(at block: SIMD3<Int>) -> UnsafeBufferPointer<TSDFVoxel>? {
+        hash.value(for: VoxelBlockHash.key(block)).map { slot in
+            UnsafeBufferPointer(rebasing: voxels[(Int(slot) * TSDFVolume.blockVoxelCount)..<((Int(slot) + 1) * TSDFVolume.blockVoxelCount)])
+        }
+    }
+
+    /// Blocks whose surface may have changed, or that were restored, since the last call.
+    /// Evicted blocks are not included, so meshes built from them stay valid.
+    func takeDirtyBlocks() -> [SIMD3<Int>] {
+        dirtyLock.lock()
+        defer { dirtyLock.unlock() }
+        let blocks = Array(dirtyBlocks)
+        dirtyBlocks.removeAll(keepingCapacity: true)
+        return blocks
+    }
+
+    private func markDirty(_ blocks: [SIMD3<Int>]) {
+        dirtyLock.lock()
+        dirtyBlocks.formUnion(blocks)
+        dirtyLock.unlock()
+    }
+
+    /// Coordinates of every resident block.
+    func residentBlocks() -> [SIMD3<Int>] {
+        var stripes = [[SIMD3<Int>]](repeating: [], count: VoxelBlockHash.stripeCount)
+        stripes.withUnsafeMutableBufferPointer { stripeBuffer in
+            let out = stripeBuffer
+            DispatchQueue.concurrentPerform(iterations: VoxelBlockHash.stripeCount) { stripe in
+                var blocks: [SIMD3<Int>] = []
+                hash.forEach(inStripe: stripe) { key, _ in
+                    blocks.append(VoxelBlockHash.block(key))
+                }
+                out[stripe] = blocks
+            }
+        }
+        return stripes.flatMap { $0 }
+    }
+
+    // MARK: Integration
+
+    /// Fuses `depth` seen from `cameraPose`, the world-from-camera transform reported
+    /// by `STTracker.lastFrameCameraPose()`. Returns the number of blocks whose surface
+    /// may have changed, which are also queued for `takeDirtyBlocks`.
+    @discardableResult
+    func integrate(_ depth: DepthImage, cameraPose: simd_float4x4) -> Int {
+        allocateBlocks(around: depth, cameraPose: cameraPose)
+
+        var updated: [SIMD3<Int>] = []
+        depth.depths.withUnsafeBufferPointer { depths in
+            let pass = TSDFVolume.Integration(depth, depths: depths, cameraPose: cameraPose, options: options)
+            let visible = visibleBlocks(pass)
+            let bounds = options.bounds
+            let base = voxels.baseAddress!
+            var chunks = [[SIMD3<Int>]](repeating: [], count: Parallel.chunkCount(for: visible.count, minChunk: 16))
+            chunks.withUnsafeMutableBufferPointer { chunkBuffer in
+                let out = chunkBuffer
+                Parallel.forEachChunk(count: visible.count, minChunk: 16) { chunk, range in
+                    var changed: [SIMD3<Int>] = []
+                    for (block, slot) in visible[range] {
+                        let extent = simd_min(SIMD3(repeating: TSDFVolume.blockSize), bounds &- block &* TSDFVolume.blockSize)
+                        if pass.integrate(base + Int(slot) * TSDFVolume.blockVoxelCount, block: block, extent: extent) == .surface {
+                            changed.append(block)
+                        }
+                    }
+                    out[chunk] = changed
+                }
+            }
+            updated = chunks.flatMap { $0 }
+        }
+        markDirty(updated)
+        return updated.count
+    }
+
+    /// Inserts every block within the truncation band of a depth sample.
+    private func allocateBlocks(around depth: DepthImage, cameraPose: simd_float4x4) {
+        let intrinsics = depth.intrinsics
+        let width = depth.width
+        let blockCounts = self.blockCounts
+        let blockExtent = Float(TSDFVolume.blockSize) * options.resolution
+        let truncation = options.truncation * options.resolution
+        let farThreshold = options.depthFarThreshold
+        // Samples along the ray through the band, closer together than a block.
+        let offsets = stride(from: -truncation, through: truncation, by: min(truncation, blockExtent) * 0.5).map { $0 }
+        let hash = self.hash
+
+        var dropped = [Int](repeating: 0, count: Parallel.chunkCount(for: depth.height, minChunk: 8))
+        depth.depths.withUnsafeBufferPointer { depthBuffer in
+            dropped.withUnsafeMutableBufferPointer { droppedBuffer in
+                let depths = depthBuffer
+                let out = droppedBuffer
+                Parallel.forEachChunk(count: depth.height, minChunk: 8) { chunk, rows in
+                    // Neighbouring pixels hit the same blocks, so deduplicate before locking.
+                    var keys = Set<VoxelBlockHash.Key>()
+                    for y in rows {
+                        for x in 0..<width {
+                            let measured = depths[y * width + x]
+                            guard measured.isFinite, measured > 0, measured <= farThreshold else { continue }
+                            let ray = intrinsics.unproject(Float(x), Float(y), depth: 1)
+                            for offset in offsets {
+                                let world = cameraPose * SIMD4(ray * (measured + offset), 1)
+                                let block = SIMD3<Int>((SIMD3(world.x, world.y, world.z) / blockExtent).rounded(.down))
+                                if all(block .>= 0) && all(block .< blockCounts) {
+                                    keys.insert(VoxelBlockHash.key(block))
+                                }
+                            }
+                        }
+                    }
+                    var failed = 0
+                    for key in keys where hash.insert(key, makeValue: takeFreeBlock) == nil {
+                        failed += 1
+                    }
+                    out[chunk] = failed
+                }
+            }
+        }
+        let failed = dropped.reduce(0, +)
+        if failed > 0 {
+            poolLock.lock()
+            droppedBlocks += failed
+            poolLock.unlock()
+        }
+    }
+
+    /// Resident blocks the frame can update, with their pool slots.
+    private func visibleBlocks(_ pass: TSDFVolume.Integration) -> [(block: SIMD3<Int>, slot: Int32)] {
+        var stripes = [[(block: SIMD3<Int>, slot: Int32)]](repeating: [], count: VoxelBlockHash.stripeCount)
+        stripes.withUnsafeMutableBufferPointer { stripeBuffer in
+            let out = stripeBuffer
+            DispatchQueue.concurrentPerform(iterations: VoxelBlockHash.stripeCount) { stripe in
+                var blocks: [(block: SIMD3<Int>, slot: Int32)] = []
+                hash.forEach(inStripe: stripe) { key, slot in
+                    let block = VoxelBlockHash.block(key)
+                    if pass.isVisible(block) {
+                        blocks.append((block, slot))
+                    }
+                }
+                out[stripe] = blocks
+            }
+        }
+        return stripes.flatMap { $0 }
+    }
+
+    // MARK: Pool
+
+    /// Pops a pool slot and clears its voxels; nil when the pool is exhausted.
+    private func takeFreeBlock() -> Int32? {
+        poolLock.lock()
+        let slot = freeBlocks.popLast()
+        poolLock.unlock()
+        if let slot = slot {
+            let start = Int(slot) * TSDFVolume.blockVoxelCount
+            UnsafeMutableBufferPointer(rebasing: voxels[start..<(start + TSDFVolume.blockVoxelCount)]).initialize(repeating: TSDFVoxel())
+        }
+        return slot
+    }
+
+    /// Frees every block that cannot be seen from `cameraPose` through a `width` x `height`
+    /// image with `intrinsics`, handing each one to `stream` first, e.g. to mesh or store it.
+    /// Returns the number of blocks evicted.
+    @discardableResult
+    func evictBlocks(notVisibleFrom cameraPose: simd_float4x4, intrinsics: CameraIntrinsics, width: Int, height: Int,
+                     stream: ((SIMD3<Int>, UnsafeBufferPointer<TSDFVoxel>) -> Void)? = nil) -> Int {
+        let pass = TSDFVolume.Integration(intrinsics: intrinsics, width: width, height: height,
+                                          depths: UnsafeBufferPointer(start: nil, count: 0),
+                                          cameraPose: cameraPose, options: options)
+        var stripes = [[(block: SIMD3<Int>, slot: Int32)]](repeating: [], count: VoxelBlockHash.stripeCount)
+        stripes.withUnsafeMutableBufferPointer { stripeBuffer in
+            let out = stripeBuffer
+            DispatchQueue.concurrentPerform(iterations: VoxelBlockHash.stripeCount) { stripe in
+                var blocks: [(block: SIMD3<Int>, slot: Int32)] = []
+                hash.forEach(inStripe: stripe) { key, slot in
+                    let block = VoxelBlockHash.block(key)
+                    if !pass.isVisible(block) {
+                        blocks.append((block, slot))
+                    }
+                }
+                out[stripe] = blocks
+            }
+        }
+        let evicted = stripes.flatMap { $0 }
+
+        let hash = self.hash
+        Parallel.forEachChunk(count: evicted.count, minChunk: 64) { _, range in
+            for (block, _) in evicted[range] {
+                hash.remove(VoxelBlockHash.key(block))
+            }
+        }
+        for (block, slot) in evicted {
+            let start = Int(slot) * TSDFVolume.blockVoxelCount
+            stream?(block, UnsafeBufferPointer(rebasing: voxels[start..<(start + TSDFVolume.blockVoxelCount)]))
+        }
+        poolLock.lock()
+        freeBlocks.append(contentsOf: evicted.map { $0.slot })
+        poolLock.unlock()
+        return evicted.count
+    }
+
+    /// Makes a streamed-out block resident again with `blockVoxels`.
+    /// Returns false when the pool is full.
+    @discardableResult
+    func restoreBlock(_ block: SIMD3<Int>, voxels blockVoxels: UnsafeBufferPointer<TSDFVoxel>) -> Bool {
+        precondition(blockVoxels.count == TSDFVolume.blockVoxelCount, "A block has \(TSDFVolume.blockVoxelCount) voxels")
+        guard let slot = hash.insert(VoxelBlockHash.key(block), makeValue: takeFreeBlock)?.value else { return false }
+        let start = Int(slot) * TSDFVolume.blockVoxelCount
+        _ = UnsafeMutableBufferPointer(rebasing: voxels[start..<(start + TSDFVolume.blockVoxelCount)]).initialize(from: blockVoxels)
+        markDirty([block])
+        return true
+    }
+}
@@ -0,0 +1,220 @@
+//
+//  TSDFRaycaster.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Renders the depth and normals the fused surface would produce at a camera pose.
+///
+/// Rays are clipped to the volume and skip whole 8x8x8 blocks that hold no data.
+/// Inside a block they advance by the stored distance to the surface, and a sign change
+/// from front to back is refined by interpolating trilinear samples on both sides. Normals
+/// are the gradient of the trilinear field. The image is split into tiles traced on
+/// all cores. The result can be handed to `DepthTracker` as its model reference.
+enum TSDFRaycaster {
+    struct Options {
+        /// Closest surface reported, in metres along the optical axis.
+        var minDepth: Float = 0.05
+        /// Farthest surface reported; nil uses the volume's `depthFarThreshold`.
+        var maxDepth: Float?
+        /// Pixels along each edge of a tile.
+        var tileSize = 16
+    }
+
+    struct Result {
+        /// Depth along the optical axis; pixels that hit nothing are NaN.
+        var depth: DepthImage
+        /// World-space points and normals for model-based tracking.
+        var reference: DepthTracker.Reference
+        var seconds: TimeInterval
+    }
+
+    /// Traces a `width` x `height` image seen through `intrinsics` from `cameraPose`,
+    /// the world-from-camera transform. Must not run while the volume is integrating.
+    static func raycast(_ volume: VoxelBlockSource, cameraPose: simd_float4x4, intrinsics: CameraIntrinsics,
+                        width: Int, height: Int, options: Options = Options()) -> Result {
+        let start = CFAbsoluteTimeGetCurrent()
+        let rotation = DepthTracker.rotation(of: cameraPose)
+        let origin = DepthTracker.translation(of: cameraPose)
+        let volumeOptions = volume.options
+        let maxDepth = options.maxDepth ?? volumeOptions.depthFarThreshold
+        let tileSize = options.tileSize
+        let tilesX = (width + tileSize - 1) / tileSize
+        let tilesY = (height + tileSize - 1) / tileSize
+        let pixelCount = width * height
+
+        let depths = UnsafeMutableBufferPointer<Float>.allocate(capacity: pixelCount)
+        let points = UnsafeMutableBufferPointer<SIMD3<Float>>.allocate(capacity: pixelCount)
+        let normals = UnsafeMutableBufferPointer<SIMD3<Float>>.allocate(capacity: pixelCount)
+        defer {
+            depths.deallocate()
+            points.deallocate()
+            normals.deallocate()
+        }
+
+        DispatchQueue.concurrentPerform(iterations: tilesX * tilesY) { tile in
+            var sampler = Sampler(volume: volume)
+            let lowerX = (tile % tilesX) * tileSize
+            let lowerY = (tile / tilesX) * tileSize
+            for y in lowerY..<min(height, lowerY + tileSize) {
+                for x in lowerX..<min(width, lowerX + tileSize) {
+                    let index = y * width + x
+                    // Unit depth along the optical axis, so the ray parameter is the depth.
+                    let direction = rotation * intrinsics.unproject(Float(x), Float(y), depth: 1)
+                    if let hit = trace(from: origin, direction: direction, near: options.minDepth, far: maxDepth,
+                                       sampler: &sampler),
+                       let normal = sampler.normal(at: origin + direction * hit) {
+                        depths[index] = hit
+                        points[index] = origin + direction * hit
+                        normals[index] = normal
+                    } else {
+                        depths[index] = .nan
+                        points[index] = SIMD3(repeating: .nan)
+                        normals[index] = SIMD3(repeating: .nan)
+                    }
+                }
+            }
+        }
+
+        let depth = DepthImage(width: width, height: height, intrinsics: intrinsics, depths: Array(depths))
+        let reference = DepthTracker.Reference(width: width, height: height, intrinsics: intrinsics, cameraPose: cameraPose,
+                                               points: Array(points), normals: Array(normals))
+        return Result(depth: depth, reference: reference, seconds: CFAbsoluteTimeGetCurrent() - start)
+    }
+
+    /// Ray parameter of the first front-to-back zero crossing within `near...far`.
+    private static func trace(from origin: SIMD3<Float>, direction: SIMD3<Float>, near: Float, far: Float,
+                              sampler: inout Sampler) -> Float? {
+        let resolution = sampler.resolution
+        let blockExtent = Float(TSDFVolume.blockSize) * resolution
+        let truncation = sampler.truncation
+
+        // Clip the ray to the volume box; axis-parallel rays get a tiny slope instead of infinities.
+        let inverse = 1 / direction.replacing(with: 1e-12, where: simd_abs(direction) .< 1e-12)
+        let lower = (SIMD3<Float>.zero - origin) * inverse
+        let upper = (SIMD3<Float>(sampler.bounds) * resolution - origin) * inverse
+        var t = max(near, simd_min(lower, upper).max())
+        let end = min(far, simd_max(lower, upper).min())
+        guard t < end else { return nil }
+
+        var previous: (t: Float, distance: Float)?
+        while t < end {
+            let position = origin + direction * t
+            let coordinate = SIMD3<Int>((position / resolution).rounded(.down))
+            let block = floorDivide(coordinate, TSDFVolume.blockSize)
+            guard let voxel = sampler.voxel(coordinate, block: block) else {
+                previous = nil
+                if !sampler.hasBlock(block) {
+                    // Jump to where the ray leaves this empty block.
+                    let blockLower = SIMD3<Float>(block) * blockExtent
+                    let exits = (blockLower + simd_float3(repeating: blockExtent)).replacing(with: blockLower, where: direction .< 0)
+                    let leave = ((exits - origin) * inverse).min()
+                    t = max(t + resolution * 0.01, leave + resolution * 0.01)
+                } else {
+                    t += resolution
+                }
+                continue
+            }
+
+            if voxel.distance < 0, let front = previous {
+                // Refine between the last sample in front and this one with trilinear values.
+                let before = sampler.trilinear(origin + direction * front.t) ?? front.distance
+                let after = sampler.trilinear(position) ?? voxel.distance
+                let fraction = before > 0 && after < 0 ? before / (before - after) : front.distance / (front.distance - voxel.distance)
+                return front.t + (t - front.t) * fraction
+            }
+            if voxel.distance < 0 {
+                // Entered behind the surface, e.g. starting inside the object.
+                return nil
+            }
+            previous = (t, voxel.distance)
+            t += max(resolution * 0.5, voxel.distance * truncation * 0.8)
+        }
+        return nil
+    }
+
+    @inline(__always)
+    private static func floorDivide(_ value: SIMD3<Int>, _ divisor: Int) -> SIMD3<Int> {
+        let quotient = value / divisor
+        return quotient &- SIMD3<Int>(repeating: 1).replacing(with: 0, where: quotient &* divisor .<= value)
+    }
+
+    /// Voxel lookups that remember the last block, since neighbouring samples share it.
+    private struct Sampler {
+        let volume: VoxelBlockSource
+        let resolution: Float
+        let truncation: Float
+        let bounds: SIMD3<Int>
+        private var cachedBlock = SIMD3<Int>(repeating: .min)
+        private var cachedVoxels: UnsafeBufferPointer<TSDFVoxel>?
+
+        init(volume: VoxelBlockSource) {
+            self.volume = volume
+            resolution = volume.options.resolution
+            truncation = volume.options.truncation * volume.options.resolution
+            bounds = volume.options.bounds
+        }
+
+        @inline(__always)
+        mutating func hasBlock(_ block: SIMD3<Int>) -> Bool {
+            voxels(of: block) != nil
+        }
+
+        @inline(__always)
+        private mutating func voxels(of block: SIMD3<Int>) -> UnsafeBufferPointer<TSDFVoxel>? {
+            if block != cachedBlock {
+                cachedBlock = block
+                cachedVoxels = volume.blockVoxels(at: block)
+            }
+            return cachedVoxels
+        }
+
+        /// Observed voxel at `coordinate`, which lies in `block`.
+        @inline(__always)
+        mutating func voxel(_ coordinate: SIMD3<Int>, block: SIMD3<Int>) -> TSDFVoxel? {
+            guard let voxels = voxels(of: block) else { return nil }
+            let local = coordinate &- block &* TSDFVolume.blockSize
+            let voxel = voxels[local.x + TSDFVolume.blockSize * (local.y + TSDFVolume.blockSize * local.z)]
+            return voxel.weight > 0 ? voxel : nil
+        }
+
+        mutating func voxel(_ coordinate: SIMD3<Int>) -> TSDFVoxel? {
+            voxel(coordinate, block: TSDFRaycaster.floorDivide(coordinate, TSDFVolume.blockSize))
+        }
+
+        /// Trilinear distance at a world position, nil unless all eight voxels are observed.
+        mutating func trilinear(_ position: SIMD3<Float>) -> Float? {
+            // Voxel centers sit at (index + 0.5) * resolution.
+            let grid = position / resolution - 0.5
+            let base = grid.rounded(.down)
+            let weights = grid - base
+            let first = SIMD3<Int>(base)
+            var value: Float = 0
+            for corner in 0..<8 {
+                let offset = SIMD3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1)
+                guard let voxel = voxel(first &+ offset) else { return nil }
+                let factors = SIMD3<Float>(offset).replacing(with: 1 - weights, where: offset .== 0)
+                    .replacing(with: weights, where: offset .== 1)
+                value += voxel.distance * factors.x * factors.y * factors.z
+            }
+            return value
+        }
+
+        /// Outward unit normal from the trilinear gradient, nil where it is undefined.
+        mutating func normal(at position: SIMD3<Float>) -> SIMD3<Float>? {
+            var gradient = SIMD3<Float>.zero
+            for axis in 0..<3 {
+                var step = SIMD3<Float>.zero
+                step[axis] = resolution
+                guard let ahead = trilinear(position + step), let behind = trilinear(position - step) else { return nil }
+                gradient[axis] = ahead - behind
+            }
+            let length = simd_length(gradient)
+            return length > 0 ? gradient / length : nil
+        }
+    }
+}
@@ -0,0 +1,341 @@
+//
+//  TSDFVolume.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// One sample of a truncated signed distance field.
+struct TSDFVoxel {
+    /// Signed distance to the surface in units of the truncation band, in [-1, 1];
+    /// positive in front of the surface.
+    var distance: Float = 1
+    /// Accumulated integration weight; zero means never observed.
+    var weight: Float = 0
+}
+
+/// Dense TSDF fusion on the CPU, with the volume semantics of `STMapper`.
+///
+/// The volume covers `bounds * resolution` metres starting at the world origin, like
+/// the mapper's cube, and voxel centers sit at `(index + 0.5) * resolution`. Voxels are
+/// stored in 8x8x8 blocks, each contiguous in memory, so integrating or meshing one
+/// region touches few cache lines. `integrate` culls blocks against the camera
+/// frustum, projects a block row of eight voxels at a time with SIMD and runs the
+/// z-slabs of blocks on all cores. Changed blocks are remembered for `IncrementalMesher`.
+final class TSDFVolume {
+    struct Options {
+        /// Voxel size in metres, as `kSTMapperVolumeResolutionKey`.
+        var resolution: Float = 0.002
+        /// Voxels per axis, as `kSTMapperVolumeBoundsKey`.
+        var bounds = SIMD3<Int>(100, 150, 150)
+        /// Depths beyond this many metres are not integrated, as `kSTMapperDepthIntegrationFarThresholdKey`.
+        var depthFarThreshold: Float = 4
+        /// Half-width of the band around the surface, in voxels.
+        var truncation: Float = 4
+        /// Weight at which older observations stop losing influence.
+        var maxWeight: Float = 64
+
+        init() {}
+
+        /// Options for a `volumeSize` cube in metres, bounds rounded as `setupMapper` does.
+        init(volumeSize: SIMD3<Float>, resolution: Float) {
+            self.resolution = resolution
+            bounds = SIMD3<Int>((volumeSize / resolution).rounded(.toNearestOrAwayFromZero))
+        }
+    }
+
+    /// Voxels along each edge of a block.
+    static let blockSize = 8
+    static let blockVoxelCount = blockSize * blockSize * blockSize
+
+    let options: Options
+    /// Blocks per axis; the last block on each axis may reach past `bounds`.
+    let blockCounts: SIMD3<Int>
+    private let voxels: UnsafeMutableBufferPointer<TSDFVoxel>
+    /// Whether each block has been integrated since creation or `reset`.
+    private let observed: UnsafeMutableBufferPointer<Bool>
+    private var dirtyBlocks = Set<SIMD3<Int>>()
+    private let dirtyLock = NSLock()
+
+    /// Extent of the volume in metres.
+    var size: SIMD3<Float> { SIMD3<Float>(options.bounds) * options.resolution }
+
+    init(options: Options = Options()) {
+        precondition(options.resolution > 0 && options.bounds.min() > 0, "Invalid TSDF volume options")
+        self.options = options
+        blockCounts = (options.bounds &+ (TSDFVolume.blockSize - 1)) / TSDFVolume.blockSize
+        voxels = .allocate(capacity: blockCounts.x * blockCounts.y * blockCounts.z * TSDFVolume.blockVoxelCount)
+        voxels.initialize(repeating: TSDFVoxel())
+        observed = .allocate(capacity: blockCounts.x * blockCounts.y * blockCounts.z)
+        observed.initialize(repeating: false)
+    }
+
+    deinit {
+        voxels.deallocate()
+        observed.deallocate()
+    }
+
+    /// Forgets every observation.
+    func reset() {
+        let voxels = self.voxels
+        Parallel.forEachChunk(count: voxels.count, minChunk: 64 * 1024) { _, range in
+            for index in range {
+                voxels[index] = TSDFVoxel()
+            }
+        }
+        observed.initialize(repeating: false)
+        var blocks: [SIMD3<Int>] = []
+        for z in 0..<blockCounts.z {
+            for y in 0..<blockCounts.y {
+                for x in 0..<blockCounts.x {
+                    blocks.append(SIMD3(x, y, z))
+                }
+            }
+        }
+        markDirty(blocks)
+    }
+
+    /// Voxel at integer coordinates inside `bounds`.
+    func voxel(at coordinate: SIMD3<Int>) -> TSDFVoxel {
+        voxels[voxelIndex(coordinate)]
+    }
+
+    /// Voxels of `block`, x fastest, or nil outside the volume or when never observed.
+    func blockVoxels(at block: SIMD3<Int>) -> UnsafeBufferPointer<TSDFVoxel>? {
+        guard all(block .>= 0) && all(block .< blockCounts) else { return nil }
+        let blockIndex = block.x + blockCounts.x * (block.y + blockCounts.y * block.z)
+        guard observed[blockIndex] else { return nil }
+        let start = blockIndex * TSDFVolume.blockVoxelCount
+        return UnsafeBufferPointer(rebasing: voxels[start..<(start + TSDFVolume.blockVoxelCount)])
+    }
+
+    /// Blocks whose surface may have changed since the last call.
+    func takeDirtyBlocks() -> [SIMD3<Int>] {
+        dirtyLock.lock()
+        defer { dirtyLock.unlock() }
+        let blocks = Array(dirtyBlocks)
+        dirtyBlocks.removeAll(keepingCapacity: true)
+        return blocks
+    }
+
+    private func markDirty(_ blocks: [SIMD3<Int>]) {
+        dirtyLock.lock()
+        dirtyBlocks.formUnion(blocks)
+        dirtyLock.unlock()
+    }
+
+    @inline(__always)
+    private func voxelIndex(_ coordinate: SIMD3<Int>) -> Int {
+        let block = coordinate / TSDFVolume.blockSize
+        let local = coordinate &- block &* TSDFVolume.blockSize
+        let blockIndex = block.x + blockCounts.x * (block.y + blockCounts.y * block.z)
+        return blockIndex * TSDFVolume.blockVoxelCount
+            + local.x + TSDFVolume.blockSize * (local.y + TSDFVolume.blockSize * local.z)
+    }
+
+    // MARK: Integration
+
+    /// Fuses `depth` seen from `cameraPose`, the world-from-camera transform reported
+    /// by `STTracker.lastFrameCameraPose()`. Returns the number of blocks whose surface
+    /// may have changed, which are also queued for `takeDirtyBlocks`.
+    @discardableResult
+    func integrate(_ depth: DepthImage, cameraPose: simd_float4x4) -> Int {
+        let blockCounts = self.blockCounts
+        let bounds = options.bounds
+        let observed = self.observed
+        var updated = [[SIMD3<Int>]](repeating: [], count: blockCounts.z)
+        depth.depths.withUnsafeBufferPointer { depths in
+            let pass = Integration(depth, depths: depths, cameraPose: cameraPose, options: options)
+            updated.withUnsafeMutableBufferPointer { updatedBuffer in
+                let slabs = updatedBuffer
+                DispatchQueue.concurrentPerform(iterations: blockCounts.z) { blockZ in
+                    var changed: [SIMD3<Int>] = []
+                    for blockY in 0..<blockCounts.y {
+                        for blockX in 0..<blockCounts.x {
+                            let block = SIMD3(blockX, blockY, blockZ)
+                            guard pass.isVisible(block) else { continue }
+                            let blockIndex = blockX + blockCounts.x * (blockY + blockCounts.y * blockZ)
+                            let extent = simd_min(SIMD3(repeating: TSDFVolume.blockSize), bounds &- block &* TSDFVolume.blockSize)
+                            let change = pass.integrate(voxels.baseAddress! + blockIndex * TSDFVolume.blockVoxelCount,
+                                                        block: block, extent: extent)
+                            if change != .none {
+                                observed[blockIndex] = true
+                            }
+                            if change == .surface {
+                                changed.append(block)
+                            }
+                        }
+                    }
+                    slabs[blockZ] = changed
+                }
+            }
+        }
+        let blocks = updated.flatMap { $0 }
+        markDirty(blocks)
+        return blocks.count
+    }
+
+    /// Whether a sphere around camera-space `center` can overlap the image and depth range.
+    @inline(__always)
+    static func isVisible(_ center: SIMD3<Float>, radius: Float, far: Float, _ intrinsics: CameraIntrinsics,
+                          width: Float, height: Float) -> Bool {
+        guard center.z + radius > 0, center.z - radius < far else { return false }
+        // A block around the camera plane can project anywhere.
+        guard center.z - radius > 0 else { return true }
+        let pixel = intrinsics.project(center)
+        let margin = SIMD2(intrinsics.fx, intrinsics.fy) * radius / (center.z - radius)
+        return pixel.x + margin.x >= -0.5 && pixel.x - margin.x < width - 0.5
+            && pixel.y + margin.y >= -0.5 && pixel.y - margin.y < height - 0.5
+    }
+
+    /// One depth frame prepared for fusing block by block, shared by the dense and sparse volumes.
+    struct Integration {
+        /// What one pass did to a block.
+        enum Change {
+            case none
+            /// Only free-space samples far in front of the surface, which leave the mesh as it is.
+            case freeSpace
+            /// A voxel inside the truncation band was updated, or one changed sign.
+            case surface
+        }
+
+        let depths: UnsafeBufferPointer<Float>
+        let intrinsics: CameraIntrinsics
+        let width: Int
+        let height: Int
+        let rotation: simd_float3x3
+        let translation: SIMD3<Float>
+        let resolution: Float
+        let truncation: Float
+        let farThreshold: Float
+        let maxWeight: Float
+        let blockRadius: Float
+
+        /// `depths` must stay valid, and hold `depth`'s samples, while the pass is used.
+        init(_ depth: DepthImage, depths: UnsafeBufferPointer<Float>, cameraPose: simd_float4x4, options: Options) {
+            self.init(intrinsics: depth.intrinsics, width: depth.width, height: depth.height,
+                      depths: depths, cameraPose: cameraPose, options: options)
+        }
+
+        /// Pass for a `width` x `height` camera; `depths` may be empty when only `isVisible` is used.
+        init(intrinsics: CameraIntrinsics, width: Int, height: Int, depths: UnsafeBufferPointer<Float>,
+             cameraPose: simd_float4x4, options: Options) {
+            let cameraFromWorld = cameraPose.inverse
+            self.depths = depths
+            self.intrinsics = intrinsics
+            self.width = width
+            self.height = height
+            rotation = simd_float3x3(SIMD3(cameraFromWorld.columns.0.x, cameraFromWorld.columns.0.y, cameraFromWorld.columns.0.z),
+                                     SIMD3(cameraFromWorld.columns.1.x, cameraFromWorld.columns.1.y, cameraFromWorld.columns.1.z),
+                                     SIMD3(cameraFromWorld.columns.2.x, cameraFromWorld.columns.2.y, cameraFromWorld.columns.2.z))
+            translation = SIMD3(cameraFromWorld.columns.3.x, cameraFromWorld.columns.3.y, cameraFromWorld.columns.3.z)
+            resolution = options.resolution
+            truncation = options.truncation * options.resolution
+            farThreshold = options.depthFarThreshold
+            maxWeight = options.maxWeight
+            blockRadius = Float(TSDFVolume.blockSize) * options.resolution * 0.5 * Float(3).squareRoot()
+        }
+
+        /// Camera-space position of a world point.
+        @inline(__always)
+        func camera(_ world: SIMD3<Float>) -> SIMD3<Float> {
+            rotation * world + translation
+        }
+
+        /// Whether any voxel of `block` can receive a sample from this frame.
+        @inline(__always)
+        func isVisible(_ block: SIMD3<Int>) -> Bool {
+            let center = camera((SIMD3<Float>(block) + 0.5) * (Float(TSDFVolume.blockSize) * resolution))
+            return TSDFVolume.isVisible(center, radius: blockRadius, far: farThreshold + truncation, intrinsics,
+                                        width: Float(width), height: Float(height))
+        }
+
+        /// Updates the `extent` voxels of `block` stored at `blockVoxels` and reports
+        /// whether its surface may have moved.
+        func integrate(_ blockVoxels: UnsafeMutablePointer<TSDFVoxel>, block: SIMD3<Int>, extent: SIMD3<Int>) -> Change {
+            let blockSize = TSDFVolume.blockSize
+            let origin = camera((SIMD3<Float>(block &* blockSize) + 0.5) * resolution)
+            // Camera-space step between neighbouring voxels along world x, y and z.
+            let stepX = rotation.columns.0 * resolution
+            let stepY = rotation.columns.1 * resolution
+            let stepZ = rotation.columns.2 * resolution
+
+            let lanes = SIMD8<Float>(0, 1, 2, 3, 4, 5, 6, 7)
+            let laneInside = SIMD8<Int32>(0, 1, 2, 3, 4, 5, 6, 7) .< Int32(extent.x)
+            let offsetX = lanes * stepX.x
+            let offsetY = lanes * stepX.y
+            let offsetZ = lanes * stepX.z
+            let maxU = Float(width) - 0.5
+            let maxV = Float(height) - 0.5
+            var change = Change.none
+
+            for z in 0..<extent.z {
+                for y in 0..<extent.y {
+                    let row = origin + Float(y) * stepY + Float(z) * stepZ
+                    let pointX = offsetX + row.x
+                    let pointY = offsetY + row.y
+                    let pointZ = offsetZ + row.z
+                    let u = intrinsics.fx * pointX / pointZ + intrinsics.cx
+                    let v = intrinsics.fy * pointY / pointZ + intrinsics.cy
+                    let visible = laneInside .& (pointZ .> 0) .& (u .>= -0.5) .& (u .< maxU) .& (v .>= -0.5) .& (v .< maxV)
+                    guard any(visible) else { continue }
+
+                    // Lanes outside the image are parked on pixel 0 before converting to integers.
+                    // Ties go to even so that -0.5, which is still inside the image, lands on 0.
+                    let pixelU = SIMD8<Int32>(u.replacing(with: 0, where: .!visible).rounded(.toNearestOrEven))
+                    let pixelV = SIMD8<Int32>(v.replacing(with: 0, where: .!visible).rounded(.toNearestOrEven))
+                    let pixels = pixelV &* Int32(width) &+ pixelU
+                    let rowVoxels = blockVoxels + blockSize * (y + blockSize * z)
+                    for lane in 0..<blockSize where visible[lane] {
+                        let measured = depths[Int(pixels[lane])]
+                        guard measured.isFinite, measured <= farThreshold else { continue }
+                        let signed = measured - pointZ[lane]
+                        guard signed >= -truncation else { continue }
+                        let sample = min(1, signed / truncation)
+                        let voxel = rowVoxels[lane]
+                        let weight = voxel.weight + 1
+                        let distance = (voxel.distance * voxel.weight + sample) / weight
+                        rowVoxels[lane] = TSDFVoxel(distance: distance, weight: min(weight, maxWeight))
+                        // Free space seen again between the camera and the surface does not
+                        // move the zero crossing, so it must not send the block to the mesher.
+                        if signed < truncation || (distance < 0) != (voxel.distance < 0) {
+                            change = .surface
+                        } else if change == .none {
+                            change = .freeSpace
+                        }
+                    }
+                }
+            }
+            return change
+        }
+    }
+
+    // MARK: Meshing
+
+    /// Extracts the zero crossing of the observed voxels with `MarchingCubes`.
+    func mesh() -> MeshBuffer {
+        let bounds = options.bounds
+        var samples = [Float](repeating: .nan, count: bounds.x * bounds.y * bounds.z)
+        samples.withUnsafeMutableBufferPointer { sampleBuffer in
+            let out = sampleBuffer
+            DispatchQueue.concurrentPerform(iterations: bounds.z) { z in
+                for y in 0..<bounds.y {
+                    for x in 0..<bounds.x {
+                        let voxel = voxels[voxelIndex(SIMD3(x, y, z))]
+                        if voxel.weight > 0 {
+                            out[x + bounds.x * (y + bounds.y * z)] = voxel.distance
+                        }
+                    }
+                }
+            }
+        }
+        return samples.withUnsafeBufferPointer { values in
+            MarchingCubes.extract(MarchingCubes.Grid(values: values, size: bounds,
+                                                     origin: SIMD3(repeating: options.resolution * 0.5),
+                                                     spacing: options.resolution))
+        }
+    }
+}
@@ -0,0 +1,156 @@
+//
+//  VoxelBlockHash.swift
+//  EmpireScan
+//
+//  Created by MacOK on 17/10/2026.
+//
+
+import Foundation
+import simd
+
+/// Open-addressing hash from block coordinates to slots of a block pool.
+///
+/// The table is split into stripes, each a linear-probing table of its own behind its
+/// own lock, so threads inserting or removing different blocks rarely wait on each
+/// other. Removal shifts later entries back instead of leaving tombstones. `value(for:)`
+/// and `forEach` take no locks and must not run while the table is being changed.
+final class VoxelBlockHash {
+    typealias Key = Int64
+
+    /// Number of independently locked stripes.
+    static let stripeCount = 64
+    private static let empty = Key.min
+    /// Bits per coordinate in a key; coordinates are stored with a bias.
+    private static let coordinateBits: Key = 21
+    private static let coordinateBias = 1 << 20
+
+    /// Slots in the whole table.
+    let capacity: Int
+    private let stripeSize: Int
+    private let keys: UnsafeMutableBufferPointer<Key>
+    private let values: UnsafeMutableBufferPointer<Int32>
+    private let locks = (0..<VoxelBlockHash.stripeCount).map { _ in NSLock() }
+
+    /// Table with room for at least `minimumCapacity` blocks at a low load factor.
+    init(minimumCapacity: Int) {
+        var stripeSize = 16
+        while stripeSize * VoxelBlockHash.stripeCount < minimumCapacity * 2 {
+            stripeSize *= 2
+        }
+        self.stripeSize = stripeSize
+        capacity = stripeSize * VoxelBlockHash.stripeCount
+        keys = .allocate(capacity: capacity)
+        keys.initialize(repeating: VoxelBlockHash.empty)
+        values = .allocate(capacity: capacity)
+        values.initialize(repeating: -1)
+    }
+
+    deinit {
+        keys.deallocate()
+        values.deallocate()
+    }
+
+    /// Packs a block coordinate, each axis within ±2^20.
+    static func key(_ block: SIMD3<Int>) -> Key {
+        let biased = block &+ coordinateBias
+        return Key(biased.x) | Key(biased.y) << coordinateBits | Key(biased.z) << (2 * coordinateBits)
+    }
+
+    static func block(_ key: Key) -> SIMD3<Int> {
+        let mask = Key(1) << coordinateBits - 1
+        return SIMD3(Int(key & mask), Int(key >> coordinateBits & mask), Int(key >> (2 * coordinateBits) & mask)) &- coordinateBias
+    }
+
+    /// Value stored for `key`, if any.
+    func value(for key: Key) -> Int32? {
+        let (stripe, home) = location(key)
+        let base = stripe * stripeSize
+        var slot = home
+        for _ in 0..<stripeSize {
+            let stored = keys[base + slot]
+            if stored == key { return values[base + slot] }
+            if stored == VoxelBlockHash.empty { return nil }
+            slot = (slot + 1) & (stripeSize - 1)
+        }
+        return nil
+    }
+
+    /// Looks up `key` and inserts the result of `makeValue` when it is missing.
+    /// Returns nil when the stripe is full or `makeValue` returns nil. Safe to call concurrently.
+    func insert(_ key: Key, makeValue: () -> Int32?) -> (value: Int32, inserted: Bool)? {
+        let (stripe, home) = location(key)
+        let base = stripe * stripeSize
+        locks[stripe].lock()
+        defer { locks[stripe].unlock() }
+        var slot = home
+        for _ in 0..<stripeSize {
+            let stored = keys[base + slot]
+            if stored == key { return (values[base + slot], false) }
+            if stored == VoxelBlockHash.empty {
+                guard let value = makeValue() else { return nil }
+                keys[base + slot] = key
+                values[base + slot] = value
+                return (value, true)
+            }
+            slot = (slot + 1) & (stripeSize - 1)
+        }
+        return nil
+    }
+
+    /// Removes `key` and returns its value. Safe to call concurrently.
+    @discardableResult
+    func remove(_ key: Key) -> Int32? {
+        let (stripe, home) = location(key)
+        let base = stripe * stripeSize
+        let mask = stripeSize - 1
+        locks[stripe].lock()
+        defer { locks[stripe].unlock() }
+        var hole = home
+        var found = false
+        for _ in 0..<stripeSize {
+            let stored = keys[base + hole]
+            if stored == VoxelBlockHash.empty { return nil }
+            if stored == key {
+                found = true
+                break
+            }
+            hole = (hole + 1) & mask
+        }
+        guard found else { return nil }
+        let removed = values[base + hole]
+
+        // Shift back every later entry of the run whose home does not lie after the hole.
+        var slot = hole
+        while true {
+            slot = (slot + 1) & mask
+            let stored = keys[base + slot]
+            if stored == VoxelBlockHash.empty { break }
+            let wanted = location(stored).slot
+            if (slot - wanted) & mask >= (slot - hole) & mask {
+                keys[base + hole] = stored
+                values[base + hole] = values[base + slot]
+                hole = slot
+            }
+        }
+        keys[base + hole] = VoxelBlockHash.empty
+        values[base + hole] = -1
+        return removed
+    }
+
+    /// Calls `body` for every entry of `stripe`.
+    func forEach(inStripe stripe: Int, _ body: (Key, Int32) -> Void) {
+        let base = stripe * stripeSize
+        for slot in base..<(base + stripeSize) where keys[slot] != VoxelBlockHash.empty {
+            body(keys[slot], values[slot])
+        }
+    }
+
+    /// Stripe of `key` and its home slot within the stripe.
+    @inline(__always)
+    private func location(_ key: Key) -> (stripe: Int, slot: Int) {
+        // Fibonacci hashing spreads neighbouring blocks across stripes.
+        let hash = UInt64(bitPattern: key) &* 0x9E37_79B9_7F4A_7C15
+        let mixed = Int(truncatingIfNeeded: hash >> 32)
+        return (mixed & (VoxelBlockHash.stripeCount - 1), (mixed >> 6) & (stripeSize - 1))
+    }
+}